@@ -0,0 +1,109 @@
+#include "AnalyticsJob.h"
+#include <algorithm>
+
+// Constructor
+JobContext::JobContext()
+    : total(0), done(0), cancelRequested(false), complete(false)
+{
+}
+
+// Progress in percent
+double JobContext::percent() const
+{
+  if (complete.load())
+  {
+    return 100.0;
+  }
+  size_t units = total.load();
+  if (units == 0)
+  {
+    return 0.0;
+  }
+  return 100.0 * min(done.load(), units) / units;
+}
+
+// Destructor: stop and wait for the jobs still running
+JobRunner::~JobRunner()
+{
+  cancelAll();
+  for (auto &job : running)
+  {
+    job.second.join();
+  }
+}
+
+// Cancel every running job
+void JobRunner::cancelAll()
+{
+  lock_guard<mutex> guard(lock);
+  for (auto &job : running)
+  {
+    job.first->cancel();
+  }
+}
+
+// Number of unfinished jobs
+size_t JobRunner::activeJobs()
+{
+  lock_guard<mutex> guard(lock);
+  reap();
+  return running.size();
+}
+
+// Launch the thread of a job
+void JobRunner::start(shared_ptr<JobContext> context, function<void()> body)
+{
+  lock_guard<mutex> guard(lock);
+  reap();
+  running.emplace_back(std::move(context), thread(std::move(body)));
+}
+
+// Join the threads of finished jobs; the caller holds 'lock'
+void JobRunner::reap()
+{
+  auto done = partition(running.begin(), running.end(),
+                        [](const pair<shared_ptr<JobContext>, thread> &job) {
+                          return !job.first->finished();
+                        });
+  for (auto it = done; it != running.end(); ++it)
+  {
+    it->second.join(); // already past its last statement
+  }
+  running.erase(done, running.end());
+}
+
+// Constructor
+PeriodicTask::PeriodicTask() : stopping(false) {}
+
+// Destructor: stop the thread
+PeriodicTask::~PeriodicTask() { stop(); }
+
+// Start the background thread
+void PeriodicTask::start(chrono::milliseconds interval, function<void()> task)
+{
+  stopping = false;
+  worker = thread([this, interval, task]() {
+    unique_lock<mutex> guard(lock);
+    while (!wake.wait_for(guard, interval, [this] { return stopping; }))
+    {
+      guard.unlock();
+      task();
+      guard.lock();
+    }
+  });
+}
+
+// Wake and join the background thread
+void PeriodicTask::stop()
+{
+  if (!worker.joinable())
+  {
+    return;
+  }
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+}
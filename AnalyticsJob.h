@@ -0,0 +1,260 @@
+/******************************************************************************
+    Background analytics jobs:
+    JobContext: Progress and cancellation state shared with a running job.
+    AnalyticsJob: Handle to a submitted job: progress, cancel, result.
+    JobCancelled: Thrown by AnalyticsJob::get() for a cancelled job.
+    JobRunner: Starts jobs on their own threads and joins them.
+    PeriodicTask: Runs a function on a thread of its own at a fixed interval.
+ * ****************************************************************************
+ * */
+
+#ifndef ANALYTICSJOB_H
+#define ANALYTICSJOB_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: JobContext
+ *
+ * Description: Passed to the analytic of a job. The analytic announces its
+ *              amount of work with setTotal(), reports it with advance()
+ *              (from any worker thread), and polls cancelled() between
+ *              units of work, returning early once it is set.
+ *
+ * Member Variables:
+ *    - total / done: Units of work announced and completed.
+ *    - cancelRequested: Set by AnalyticsJob::cancel().
+ *    - complete: Set once the result (or exception) is available.
+ *
+ *****************************************************************************/
+class JobContext
+{
+public:
+  JobContext();
+
+  void setTotal(size_t units) { total.store(units); }
+  void advance(size_t units = 1) { done.fetch_add(units); }
+  bool cancelled() const { return cancelRequested.load(); }
+
+  double percent() const;
+  /*-------------------------------------------------------------------------
+    Report how far the job has come.
+
+    Preconditions: None.
+    Postconditions: Returns a value in [0, 100]; 100 once the job is done.
+  -------------------------------------------------------------------------*/
+
+  void cancel() { cancelRequested.store(true); }
+  void finish() { complete.store(true); }
+  bool finished() const { return complete.load(); }
+
+private:
+  /***** Member Variables *****/
+  atomic<size_t> total;          // units of work
+  atomic<size_t> done;           // units completed
+  atomic<bool> cancelRequested;  // stop at the next check
+  atomic<bool> complete;         // result is available
+};
+
+// Result of a job cancelled before it finished: its value would be partial
+class JobCancelled : public runtime_error
+{
+public:
+  JobCancelled() : runtime_error("job cancelled") {}
+};
+
+/******************************************************************************
+ * Class: AnalyticsJob
+ *
+ * Description: Handle returned when an analytic is submitted. The job keeps
+ *              running if the handle is dropped; JobRunner joins it.
+ *
+ * Member Variables:
+ *    - context: Progress and cancellation state shared with the job.
+ *    - result: The value returned by the analytic.
+ *
+ *****************************************************************************/
+template <typename T> class AnalyticsJob
+{
+public:
+  AnalyticsJob(shared_ptr<JobContext> context, shared_future<T> result)
+      : context(std::move(context)), result(std::move(result))
+  {
+  }
+
+  double progress() const { return context->percent(); }
+  bool ready() const { return context->finished(); }
+
+  void cancel() { context->cancel(); }
+  bool cancelled() const { return context->cancelled(); }
+  /*-------------------------------------------------------------------------
+    Ask the job to stop.
+
+    Preconditions: None.
+    Postconditions: The analytic returns at its next check; get() then
+                    throws JobCancelled rather than return a partial
+                    result.
+  -------------------------------------------------------------------------*/
+
+  const T &get() const { return result.get(); }
+  /*-------------------------------------------------------------------------
+    Wait for the job and return its result.
+
+    Preconditions: None.
+    Postconditions: Throws JobCancelled if the job was cancelled; rethrows
+                    an exception thrown by the analytic.
+  -------------------------------------------------------------------------*/
+
+  const shared_future<T> &future() const { return result; }
+
+private:
+  /***** Member Variables *****/
+  shared_ptr<JobContext> context; // progress and cancellation
+  shared_future<T> result;        // value of the analytic
+};
+
+/******************************************************************************
+ * Class: JobRunner
+ *
+ * Description: Runs each submitted analytic on a thread of its own, so the
+ *              caller returns immediately. Finished threads are joined on
+ *              the next submit; the destructor cancels the jobs still
+ *              running and waits for them.
+ *
+ * Member Variables:
+ *    - lock: Guards 'running'.
+ *    - running: Started threads with their job state.
+ *
+ *****************************************************************************/
+class JobRunner
+{
+public:
+  JobRunner() = default;
+  JobRunner(const JobRunner &) = delete;
+  JobRunner &operator=(const JobRunner &) = delete;
+  ~JobRunner();
+
+  template <typename T>
+  shared_ptr<AnalyticsJob<T>> submit(function<T(JobContext &)> analytic);
+  /*-------------------------------------------------------------------------
+    Start 'analytic' on a new thread.
+
+    Preconditions: 'analytic' only uses data it owns or shares (e.g. an
+                   immutable graph snapshot), not the caller's mutable
+                   state. T is not void.
+    Postconditions: Returns the job's handle.
+  -------------------------------------------------------------------------*/
+
+  void cancelAll();
+  /*-------------------------------------------------------------------------
+    Cancel every running job.
+
+    Preconditions: None.
+    Postconditions: Jobs stop at their next check; nothing is joined.
+  -------------------------------------------------------------------------*/
+
+  size_t activeJobs();
+  /*-------------------------------------------------------------------------
+    Count the jobs that have not finished.
+
+    Preconditions: None.
+    Postconditions: Finished threads are joined.
+  -------------------------------------------------------------------------*/
+
+private:
+  void start(shared_ptr<JobContext> context, function<void()> body);
+  void reap();
+
+  /***** Member Variables *****/
+  mutex lock;                                            // guards 'running'
+  vector<pair<shared_ptr<JobContext>, thread>> running; // started jobs
+};
+
+// Start an analytic and hand back its handle
+template <typename T>
+shared_ptr<AnalyticsJob<T>> JobRunner::submit(function<T(JobContext &)> analytic)
+{
+  shared_ptr<JobContext> context = make_shared<JobContext>();
+  shared_ptr<promise<T>> result = make_shared<promise<T>>();
+  shared_ptr<AnalyticsJob<T>> job =
+      make_shared<AnalyticsJob<T>>(context, result->get_future().share());
+  start(context, [context, result, analytic]() {
+    try
+    {
+      T value = analytic(*context);
+      if (context->cancelled())
+      {
+        throw JobCancelled(); // an analytic stops early once cancelled
+      }
+      result->set_value(std::move(value));
+    }
+    catch (...)
+    {
+      result->set_exception(current_exception());
+    }
+    context->finish();
+  });
+  return job;
+}
+
+/******************************************************************************
+ * Class: PeriodicTask
+ *
+ * Description: Calls a function every 'interval' on a background thread
+ *              until stopped. stop() wakes the thread instead of waiting
+ *              out the interval, and waits for a call in progress to end.
+ *
+ * Member Variables:
+ *    - lock: Guards 'stopping'.
+ *    - wake: Signals stop() to the sleeping thread.
+ *    - stopping: stop() was called.
+ *    - worker: The background thread.
+ *
+ *****************************************************************************/
+class PeriodicTask
+{
+public:
+  PeriodicTask();
+  PeriodicTask(const PeriodicTask &) = delete;
+  PeriodicTask &operator=(const PeriodicTask &) = delete;
+  ~PeriodicTask();
+
+  void start(chrono::milliseconds interval, function<void()> task);
+  /*-------------------------------------------------------------------------
+    Start calling 'task', first after one interval.
+
+    Preconditions: The task is not running.
+    Postconditions: 'task' runs on the background thread only.
+  -------------------------------------------------------------------------*/
+
+  void stop();
+  /*-------------------------------------------------------------------------
+    Stop calling the task.
+
+    Preconditions: Not called from the task.
+    Postconditions: The thread is joined; the task no longer runs.
+  -------------------------------------------------------------------------*/
+
+  bool running() const { return worker.joinable(); }
+
+private:
+  /***** Member Variables *****/
+  mutex lock;              // guards 'stopping'
+  condition_variable wake; // interrupts the wait between calls
+  bool stopping;           // stop() called
+  thread worker;           // background thread
+};
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,231 @@
+#include "Betweenness.h"
+#include "AnalyticsJob.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace
+{
+typedef FlatGraph::Vertex Vertex;
+
+// Per-worker scratch space, reused across sources
+struct Workspace
+{
+  vector<int64_t> distance;   // distance from the source (-1 unreached)
+  vector<double> paths;       // number of shortest paths (sigma)
+  vector<double> dependency;  // dependency of the source on each vertex
+  vector<Vertex> order;       // vertices in non-decreasing distance
+  vector<double> centrality;  // this worker's accumulated scores
+
+  explicit Workspace(size_t n)
+      : distance(n, -1), paths(n, 0.0), dependency(n, 0.0), centrality(n, 0.0)
+  {
+  }
+};
+
+// Shortest-path DAG from 'source' by breadth-first search
+void searchHops(const FlatGraph &graph, Vertex source, Workspace &w)
+{
+  w.distance[source] = 0;
+  w.paths[source] = 1.0;
+  w.order.push_back(source);
+  for (size_t head = 0; head < w.order.size(); ++head)
+  {
+    Vertex v = w.order[head];
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      Vertex u = graph.neighbors(v)[i];
+      if (w.distance[u] < 0)
+      {
+        w.distance[u] = w.distance[v] + 1;
+        w.order.push_back(u);
+      }
+      if (w.distance[u] == w.distance[v] + 1)
+      {
+        w.paths[u] += w.paths[v];
+      }
+    }
+  }
+}
+
+// Shortest-path DAG from 'source' by Dijkstra over the weights
+void searchWeighted(const FlatGraph &graph, Vertex source, Workspace &w)
+{
+  typedef pair<int64_t, Vertex> Entry;
+  priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+  w.distance[source] = 0;
+  w.paths[source] = 1.0;
+  queue.push(Entry(0, source));
+  while (!queue.empty())
+  {
+    Entry top = queue.top();
+    queue.pop();
+    Vertex v = top.second;
+    if (top.first != w.distance[v])
+    {
+      continue; // stale entry; v was reached again by a shorter path
+    }
+    w.order.push_back(v);
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      Vertex u = graph.neighbors(v)[i];
+      int64_t candidate = w.distance[v] + graph.weights(v)[i];
+      if (w.distance[u] < 0 || candidate < w.distance[u])
+      {
+        w.distance[u] = candidate;
+        w.paths[u] = 0.0;
+        queue.push(Entry(candidate, u));
+      }
+      if (candidate == w.distance[u])
+      {
+        w.paths[u] += w.paths[v];
+      }
+    }
+  }
+}
+
+// Accumulate the dependencies of one source and reset the scratch arrays
+void accumulate(const FlatGraph &graph, Vertex source, bool weighted,
+                Workspace &w)
+{
+  for (size_t i = w.order.size(); i-- > 0;)
+  {
+    Vertex v = w.order[i];
+    // Successors of v on shortest paths are the neighbors one step further
+    for (uint32_t j = 0; j < graph.degree(v); ++j)
+    {
+      Vertex u = graph.neighbors(v)[j];
+      int64_t step = weighted ? graph.weights(v)[j] : 1;
+      if (w.distance[u] == w.distance[v] + step && w.paths[u] > 0.0)
+      {
+        w.dependency[v] +=
+            w.paths[v] / w.paths[u] * (1.0 + w.dependency[u]);
+      }
+    }
+    if (v != source)
+    {
+      w.centrality[v] += w.dependency[v];
+    }
+  }
+  for (Vertex v : w.order)
+  {
+    w.distance[v] = -1;
+    w.paths[v] = 0.0;
+    w.dependency[v] = 0.0;
+  }
+  w.order.clear();
+}
+} // namespace
+
+// Betweenness centrality, exact or sampled
+BetweennessResult calculateBetweenness(const FlatGraph &graph,
+                                       const BetweennessOptions &options,
+                                       JobContext *context)
+{
+  size_t n = graph.vertexCount();
+  BetweennessResult result;
+  result.centrality.assign(n, 0.0);
+
+  // Pick the sources
+  size_t samples = options.samples;
+  if (samples == 0 && options.epsilon > 0.0)
+  {
+    samples = samplesForError(n, options.epsilon, options.delta);
+  }
+  vector<Vertex> sources(n);
+  iota(sources.begin(), sources.end(), 0);
+  result.exact = samples == 0 || samples >= n;
+  if (!result.exact)
+  {
+    mt19937_64 rng(options.seed ? options.seed : random_device()());
+    // Partial Fisher-Yates: the first 'samples' entries are the sample
+    for (size_t i = 0; i < samples; ++i)
+    {
+      uniform_int_distribution<size_t> pick(i, n - 1);
+      swap(sources[i], sources[pick(rng)]);
+    }
+    sources.resize(samples);
+  }
+  result.sources = sources.size();
+  if (context != nullptr)
+  {
+    context->setTotal(sources.size());
+  }
+
+  // One workspace (scratch + accumulator) per worker, created on first use
+  vector<unique_ptr<Workspace>> workspaces(workerCount());
+  parallelFor(0, sources.size(), 4, [&](size_t lo, size_t hi,
+                                        unsigned worker) {
+    if (context != nullptr && context->cancelled())
+    {
+      return;
+    }
+    if (!workspaces[worker])
+    {
+      workspaces[worker].reset(new Workspace(n));
+    }
+    Workspace &w = *workspaces[worker];
+    for (size_t i = lo; i < hi; ++i)
+    {
+      if (options.weighted)
+      {
+        searchWeighted(graph, sources[i], w);
+      }
+      else
+      {
+        searchHops(graph, sources[i], w);
+      }
+      accumulate(graph, sources[i], options.weighted, w);
+    }
+    if (context != nullptr)
+    {
+      context->advance(hi - lo);
+    }
+  });
+  for (const auto &w : workspaces)
+  {
+    if (w)
+    {
+      for (size_t v = 0; v < n; ++v)
+      {
+        result.centrality[v] += w->centrality[v];
+      }
+    }
+  }
+
+  // Every pair was counted from both ends; scale samples up to n sources
+  double scale = 0.5;
+  if (!result.exact)
+  {
+    scale *= static_cast<double>(n) / result.sources;
+  }
+  if (options.normalized && n > 2)
+  {
+    scale *= 2.0 / ((n - 1.0) * (n - 2.0));
+  }
+  for (double &c : result.centrality)
+  {
+    c *= scale;
+  }
+  return result;
+}
+
+// Sampled sources needed for an error bound
+size_t samplesForError(size_t vertexCount, double epsilon, double delta)
+{
+  double n = max<size_t>(vertexCount, 1);
+  return static_cast<size_t>(
+      ceil(log(2.0 * n / delta) / (2.0 * epsilon * epsilon)));
+}
+
+// Error bound reached by a number of sampled sources
+double errorForSamples(size_t vertexCount, size_t samples, double delta)
+{
+  double n = max<size_t>(vertexCount, 1);
+  return sqrt(log(2.0 * n / delta) / (2.0 * samples));
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+    Betweenness centrality (Brandes' algorithm):
+    BetweennessOptions: Exact or sampled mode, weighting, normalization.
+    BetweennessResult: Centrality per vertex and how it was computed.
+    calculateBetweenness: Compute betweenness for a flat graph in parallel.
+    samplesForError: Number of sampled sources for an error bound.
+    errorForSamples: Error bound reached by a number of sampled sources.
+ * ****************************************************************************
+ * */
+
+#ifndef BETWEENNESS_H
+#define BETWEENNESS_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class JobContext;
+
+struct BetweennessOptions
+{
+  bool weighted = false;  // false: hop counts (BFS); true: weights (Dijkstra)
+  bool normalized = true; // divide by the number of vertex pairs
+  size_t samples = 0;     // sampled sources; 0 = exact unless 'epsilon' set
+  double epsilon = 0.0;   // target absolute error of normalized scores
+  double delta = 0.1;     // failure probability of the error bound
+  uint64_t seed = 0;      // 0 = seed from random_device
+};
+
+struct BetweennessResult
+{
+  vector<double> centrality; // betweenness per vertex
+  size_t sources;            // sources the scores were accumulated from
+  bool exact;                // every vertex was used as a source
+};
+
+/******************************************************************************
+ * Function: calculateBetweenness
+ *
+ * Purpose: Brandes' algorithm: one single-source shortest-path search per
+ *          source (BFS, or Dijkstra when weighted), then dependencies are
+ *          accumulated in reverse distance order. Predecessors are found by
+ *          rescanning the sorted neighbor slices, so no predecessor lists
+ *          are stored. Sources are spread over the parallelFor workers,
+ *          each with its own scratch arrays and dependency accumulator.
+ *          In sampled mode the sources are drawn uniformly and the sums are
+ *          scaled by n / samples. 'context' (if any) receives progress
+ *          per source and can cancel the run.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns the centrality indexed by vertex ID. A cancelled
+ *                 run is partial.
+ *****************************************************************************/
+BetweennessResult calculateBetweenness(const FlatGraph &graph,
+                                       const BetweennessOptions &options,
+                                       JobContext *context = nullptr);
+
+/******************************************************************************
+ * Function: samplesForError
+ *
+ * Purpose: Number of uniformly sampled sources for which every normalized
+ *          score is within 'epsilon' of the exact value with probability
+ *          1 - 'delta' (Hoeffding bound with a union bound over vertices):
+ *          ceil(ln(2n / delta) / (2 epsilon^2)).
+ *
+ * Preconditions: 'epsilon' > 0, 0 < 'delta' < 1.
+ *
+ * Postconditions: Returns the sample count (not capped at n).
+ *****************************************************************************/
+size_t samplesForError(size_t vertexCount, double epsilon, double delta);
+
+/******************************************************************************
+ * Function: errorForSamples
+ *
+ * Purpose: Inverse of samplesForError: the absolute error of normalized
+ *          scores that 'samples' uniformly sampled sources stay within with
+ *          probability 1 - 'delta': sqrt(ln(2n / delta) / (2 samples)).
+ *
+ * Preconditions: 'samples' > 0, 0 < 'delta' < 1.
+ *
+ * Postconditions: Returns the error bound.
+ *****************************************************************************/
+double errorForSamples(size_t vertexCount, size_t samples, double delta);
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,342 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+const char MAGIC[8] = {'S', 'N', 'G', 'C', 'K', 'P', 'T', '2'};
+const size_t IMAGE_HEADER_BYTES = 12;         // block, payload length, CRC
+const uint64_t COMPACT_MIN_BYTES = 256 << 10; // dead bytes worth a rewrite
+const size_t COPY_BATCH_BYTES = 1 << 20;      // compaction write size
+
+// Header and user count in front of an image's users
+string frameImage(const CheckpointImage &image)
+{
+  string payload;
+  ByteWriter count(payload);
+  count.u32(image.users);
+  payload += image.payload;
+
+  string framed;
+  framed.reserve(IMAGE_HEADER_BYTES + payload.size());
+  ByteWriter header(framed);
+  header.u32(image.block);
+  header.u32(static_cast<uint32_t>(payload.size()));
+  header.u32(crc32(payload.data(), payload.size()));
+  framed += payload;
+  return framed;
+}
+} // namespace
+
+// Constructor
+CheckpointStore::CheckpointStore()
+    : checkpointLsn(0), generation(0), dataBytes(0), liveBytes(0)
+{
+}
+
+// Destructor
+CheckpointStore::~CheckpointStore() { close(); }
+
+// Read the manifest and map the data file
+bool CheckpointStore::open(const string &directory, bool &found)
+{
+  close();
+  this->directory = directory;
+  string manifestName = directory + "/graph.ckpt";
+  string manifest;
+  found = readWholeFile(manifestName, manifest);
+  if (found)
+  {
+    // Magic, body, CRC of everything before it
+    uint32_t checksum = 0;
+    bool valid = manifest.size() >= sizeof(MAGIC) + 4 &&
+                 manifest.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) == 0;
+    if (valid)
+    {
+      ByteReader trailer(manifest.data() + manifest.size() - 4, 4);
+      trailer.u32(checksum);
+      valid = crc32(manifest.data(), manifest.size() - 4) == checksum;
+    }
+    ByteReader in(manifest.data() + sizeof(MAGIC),
+                  valid ? manifest.size() - sizeof(MAGIC) - 4 : 0);
+    uint32_t count = 0;
+    valid = valid && in.u64(checkpointLsn) && in.u64(generation) &&
+            in.u64(dataBytes) && in.u32(count);
+    for (uint32_t i = 0; valid && i < count; ++i)
+    {
+      uint32_t block;
+      Extent extent;
+      valid = in.u32(block) && in.u64(extent.offset) && in.u32(extent.size) &&
+              extent.size > IMAGE_HEADER_BYTES &&
+              extent.offset + extent.size <= dataBytes;
+      extents[block] = extent;
+      liveBytes += extent.size;
+    }
+    if (!valid || in.remaining() != 0)
+    {
+      cerr << "Error: checkpoint " << manifestName << " is corrupt." << endl;
+      close();
+      return false;
+    }
+  }
+
+  // Images after 'dataBytes' belong to a checkpoint that never finished
+  string dataName = dataFileName(generation);
+  if (!data.open(dataName))
+  {
+    close();
+    return false;
+  }
+  uint64_t size = data.size();
+  if (size < dataBytes)
+  {
+    cerr << "Error: " << dataName << " is shorter than its checkpoint."
+         << endl;
+    close();
+    return false;
+  }
+  if ((size > dataBytes && !data.truncate(dataBytes)) ||
+      !mapping.open(dataName))
+  {
+    close();
+    return false;
+  }
+  // Left behind by a compaction that crashed before or after its manifest
+  remove(dataFileName(generation + 1).c_str());
+  if (generation > 0)
+  {
+    remove(dataFileName(generation - 1).c_str());
+  }
+  return true;
+}
+
+// Release the files
+void CheckpointStore::close()
+{
+  data.close();
+  mapping.close();
+  extents.clear();
+  checkpointLsn = generation = dataBytes = liveBytes = 0;
+}
+
+// Decode every saved block
+bool CheckpointStore::load(
+    const function<void(uint32_t, const CheckpointUser &)> &visit)
+{
+  CheckpointUser user;
+  for (const auto &entry : extents)
+  {
+    const Extent &extent = entry.second;
+    ByteReader image(mapping.data() + extent.offset, extent.size);
+    uint32_t block, length, checksum, count;
+    bool valid = image.u32(block) && image.u32(length) &&
+                 image.u32(checksum) && block == entry.first &&
+                 length == image.remaining() &&
+                 crc32(image.position(), length) == checksum &&
+                 image.u32(count);
+    for (uint32_t i = 0; valid && i < count; ++i)
+    {
+      uint32_t degree;
+      valid = image.str(user.userName) && image.str(user.firstName) &&
+              image.str(user.lastName) && image.str(user.email) &&
+              image.u32(degree) && degree <= image.remaining();
+      user.neighbors.resize(valid ? degree : 0);
+      for (GraphVersion::Neighbor &neighbor : user.neighbors)
+      {
+        uint32_t weight = 0;
+        valid = valid && image.str(neighbor.userName) && image.u32(weight);
+        neighbor.weight = static_cast<int>(weight);
+      }
+      if (valid)
+      {
+        visit(block, user);
+      }
+    }
+    if (!valid || image.remaining() != 0)
+    {
+      cerr << "Error: block " << entry.first << " of "
+           << dataFileName(generation) << " is corrupt." << endl;
+      return false;
+    }
+  }
+  // Compaction maps the file again when it needs the images
+  mapping.close();
+  return true;
+}
+
+// Encode a user into its block's image
+void CheckpointStore::addUser(CheckpointImage &image, const string &userName,
+                              const string &firstName, const string &lastName,
+                              const string &email,
+                              const GraphVersion::NeighborList &neighbors)
+{
+  ByteWriter out(image.payload);
+  out.str(userName);
+  out.str(firstName);
+  out.str(lastName);
+  out.str(email);
+  out.u32(static_cast<uint32_t>(neighbors.size()));
+  for (const GraphVersion::Neighbor &neighbor : neighbors)
+  {
+    out.str(neighbor.userName);
+    out.u32(static_cast<uint32_t>(neighbor.weight));
+  }
+  ++image.users;
+}
+
+// Save the changed blocks and switch the manifest to them
+bool CheckpointStore::write(uint64_t lsn, const vector<CheckpointImage> &images,
+                            CheckpointStats *stats)
+{
+  // The block map after this checkpoint, without the new images yet
+  map<uint32_t, Extent> next = extents;
+  uint64_t live = liveBytes;
+  vector<string> framed;
+  vector<uint32_t> framedBlocks;
+  uint64_t appended = 0;
+  for (const CheckpointImage &image : images)
+  {
+    auto old = next.find(image.block);
+    if (old != next.end())
+    {
+      live -= old->second.size;
+      next.erase(old);
+    }
+    if (image.users > 0)
+    {
+      framed.push_back(frameImage(image));
+      framedBlocks.push_back(image.block);
+      appended += framed.back().size();
+    }
+  }
+  live += appended;
+
+  // Append the images, or copy the live ones to a new data file once the
+  // dead ones outweigh them
+  uint64_t nextGeneration = generation;
+  uint64_t nextBytes = dataBytes + appended;
+  bool compacting =
+      nextBytes > 2 * live && nextBytes - live >= COMPACT_MIN_BYTES;
+  if (compacting)
+  {
+    ++nextGeneration;
+    map<uint32_t, Extent> kept;
+    kept.swap(next);
+    if (!compact(kept, framed, framedBlocks, next, nextBytes))
+    {
+      remove(dataFileName(nextGeneration).c_str());
+      return false;
+    }
+  }
+  else
+  {
+    string batch;
+    batch.reserve(appended);
+    for (size_t i = 0; i < framed.size(); ++i)
+    {
+      next[framedBlocks[i]] = Extent{dataBytes + batch.size(),
+                                     static_cast<uint32_t>(framed[i].size())};
+      batch += framed[i];
+    }
+    if (!data.append(batch.data(), batch.size()) || !data.sync())
+    {
+      data.truncate(dataBytes);
+      return false;
+    }
+  }
+
+  // The manifest makes the checkpoint current
+  string manifest(MAGIC, sizeof(MAGIC));
+  ByteWriter out(manifest);
+  out.u64(lsn);
+  out.u64(nextGeneration);
+  out.u64(nextBytes);
+  out.u32(static_cast<uint32_t>(next.size()));
+  for (const auto &entry : next)
+  {
+    out.u32(entry.first);
+    out.u64(entry.second.offset);
+    out.u32(entry.second.size);
+  }
+  out.u32(crc32(manifest.data(), manifest.size()));
+  if (!replaceFileDurably(directory + "/graph.ckpt", manifest))
+  {
+    if (compacting)
+    {
+      remove(dataFileName(nextGeneration).c_str());
+    }
+    else
+    {
+      data.truncate(dataBytes);
+    }
+    return false;
+  }
+
+  if (stats != nullptr)
+  {
+    *stats = CheckpointStats{lsn, images.size(),
+                             compacting ? nextBytes : appended, compacting};
+  }
+  checkpointLsn = lsn;
+  dataBytes = nextBytes;
+  liveBytes = live;
+  extents.swap(next);
+  if (compacting)
+  {
+    data.close();
+    mapping.close();
+    remove(dataFileName(generation).c_str());
+    generation = nextGeneration;
+    if (!data.open(dataFileName(generation)))
+    {
+      return false; // the checkpoint is saved; later ones will fail
+    }
+  }
+  return true;
+}
+
+// Name of a data file
+string CheckpointStore::dataFileName(uint64_t generation) const
+{
+  return directory + "/graph.blocks." + to_string(generation);
+}
+
+// Write the kept and the new images to the next data file
+bool CheckpointStore::compact(const map<uint32_t, Extent> &kept,
+                              const vector<string> &framed,
+                              const vector<uint32_t> &framedBlocks,
+                              map<uint32_t, Extent> &next,
+                              uint64_t &nextBytes)
+{
+  DurableFile target;
+  if (!mapping.open(dataFileName(generation)) ||
+      !target.open(dataFileName(generation + 1)) || !target.truncate(0))
+  {
+    return false;
+  }
+  nextBytes = 0;
+  string batch;
+  auto flush = [&]() {
+    bool written = target.append(batch.data(), batch.size());
+    nextBytes += batch.size();
+    batch.clear();
+    return written;
+  };
+  for (const auto &entry : kept)
+  {
+    const Extent &extent = entry.second;
+    next[entry.first] = Extent{nextBytes + batch.size(), extent.size};
+    batch.append(mapping.data() + extent.offset, extent.size);
+    if (batch.size() >= COPY_BATCH_BYTES && !flush())
+    {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < framed.size(); ++i)
+  {
+    next[framedBlocks[i]] = Extent{nextBytes + batch.size(),
+                                   static_cast<uint32_t>(framed[i].size())};
+    batch += framed[i];
+  }
+  return flush() && target.sync();
+}
@@ -0,0 +1,154 @@
+/******************************************************************************
+    Incremental graph checkpoints:
+    CheckpointUser: One saved user with its connections.
+    CheckpointImage: The encoded users of one adjacency block.
+    CheckpointStats: What a checkpoint wrote.
+    CheckpointStore: Block images in an append-only data file, indexed by
+     an atomically replaced manifest.
+ * ****************************************************************************
+ * */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "DurableIO.h"
+#include "GraphVersion.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct CheckpointUser
+{
+  string userName;
+  string firstName;
+  string lastName;
+  string email;
+  vector<GraphVersion::Neighbor> neighbors; // both ends list a connection
+};
+
+struct CheckpointImage
+{
+  uint32_t block;  // GraphVersion block the users belong to
+  uint32_t users;  // users encoded in 'payload'
+  string payload;  // see CheckpointStore::addUser
+};
+
+struct CheckpointStats
+{
+  uint64_t lsn;          // last log record included
+  size_t blocksWritten;  // block images written (or dropped, if empty)
+  uint64_t bytesWritten; // data file bytes written
+  bool compacted;        // the live images were copied to a new data file
+};
+
+/******************************************************************************
+ * Class: CheckpointStore
+ *
+ * Description: Saves the graph one adjacency block at a time, so that a
+ *              checkpoint writes only the blocks changed since the last
+ *              one. Block images are appended to a data file
+ *              (graph.blocks.<generation>) and the manifest (graph.ckpt)
+ *              maps each block to its latest image; the manifest is
+ *              replaced atomically once the images are synced, so a crash
+ *              leaves the previous checkpoint intact. Superseded images
+ *              stay in the data file until it holds more dead bytes than
+ *              live ones; the next checkpoint then copies the live images
+ *              to a new generation. Restoring maps the data file and
+ *              decodes the images in place.
+ *
+ * Member Variables:
+ *    - directory: Where the manifest and the data files are kept.
+ *    - checkpointLsn: Last log record the saved blocks include.
+ *    - generation: Number of the current data file.
+ *    - dataBytes: Length of the data file the manifest covers.
+ *    - liveBytes: Length of the images the manifest refers to.
+ *    - extents: Block -> offset and length of its latest image.
+ *    - data: The current data file, for appending.
+ *    - mapping: The current data file, for reading.
+ *
+ *****************************************************************************/
+class CheckpointStore
+{
+public:
+  CheckpointStore();
+  CheckpointStore(const CheckpointStore &) = delete;
+  CheckpointStore &operator=(const CheckpointStore &) = delete;
+  ~CheckpointStore();
+
+  bool open(const string &directory, bool &found);
+  /*-------------------------------------------------------------------------
+    Read the manifest and map the data file, dropping image bytes that a
+    crashed checkpoint wrote after it.
+
+    Preconditions: 'directory' exists.
+    Postconditions: 'found' tells whether a checkpoint exists; without one
+                    the store is empty with LSN 0. Returns false (after
+                    reporting) if the checkpoint is corrupt or unreadable.
+  -------------------------------------------------------------------------*/
+
+  void close();
+  bool isOpen() const { return data.isOpen(); }
+  uint64_t lsn() const { return checkpointLsn; }
+
+  bool load(const function<void(uint32_t, const CheckpointUser &)> &visit);
+  /*-------------------------------------------------------------------------
+    Decode every saved block, calling 'visit' with each user and the block
+    it was saved in.
+
+    Preconditions: The store is open.
+    Postconditions: Returns false (after reporting) at the first image
+                    whose checksum or encoding is wrong.
+  -------------------------------------------------------------------------*/
+
+  static void addUser(CheckpointImage &image, const string &userName,
+                      const string &firstName, const string &lastName,
+                      const string &email,
+                      const GraphVersion::NeighborList &neighbors);
+  /*-------------------------------------------------------------------------
+    Encode one user into the image of its block.
+
+    Preconditions: None.
+    Postconditions: 'image.users' is incremented.
+  -------------------------------------------------------------------------*/
+
+  bool write(uint64_t lsn, const vector<CheckpointImage> &images,
+             CheckpointStats *stats = nullptr);
+  /*-------------------------------------------------------------------------
+    Save a checkpoint that replaces the given blocks; an image without
+    users drops its block. Blocks not in 'images' keep their saved image.
+
+    Preconditions: The store is open. 'images' holds every block changed
+                   since the last write(), as of log record 'lsn'.
+    Postconditions: Returns false (after reporting) on an I/O error; the
+                    previous checkpoint is then still the saved one.
+  -------------------------------------------------------------------------*/
+
+private:
+  struct Extent
+  {
+    uint64_t offset; // in the data file
+    uint32_t size;   // header and payload
+  };
+
+  string dataFileName(uint64_t generation) const;
+  bool compact(const map<uint32_t, Extent> &kept,
+               const vector<string> &framed,
+               const vector<uint32_t> &framedBlocks,
+               map<uint32_t, Extent> &next, uint64_t &nextBytes);
+
+  /***** Member Variables *****/
+  string directory;               // manifest and data files
+  uint64_t checkpointLsn;         // log position of the saved blocks
+  uint64_t generation;            // current data file number
+  uint64_t dataBytes;             // data file length in the manifest
+  uint64_t liveBytes;             // bytes of the images in 'extents'
+  map<uint32_t, Extent> extents;  // block -> latest image
+  DurableFile data;               // current data file, appending
+  MappedFile mapping;             // current data file, reading
+};
+
+#endif // END OF THE HEADER FILE
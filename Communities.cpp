@@ -0,0 +1,453 @@
+#include "Communities.h"
+#include "AnalyticsJob.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <random>
+
+namespace
+{
+typedef FlatGraph::Vertex Vertex;
+
+// Weighted graph of one Louvain level; vertices are communities below
+struct LevelGraph
+{
+  vector<uint32_t> offsets;
+  vector<uint32_t> targets;
+  vector<double> weights;
+  vector<double> selfLoop; // weight inside the vertex (counted once)
+  vector<double> degree;   // weighted degree, self-loop counted twice
+  double totalDegree;      // 2m
+
+  size_t size() const { return degree.size(); }
+};
+
+// Per-worker scratch space of label propagation
+struct Workspace
+{
+  vector<double> weightOf;  // neighbor weight per label
+  vector<uint32_t> touched; // labels with a nonzero weightOf
+
+  explicit Workspace(size_t n) : weightOf(n, 0.0) {}
+};
+
+// Visiting order: a seeded shuffle of all vertices
+vector<uint32_t> shuffledOrder(size_t n, uint64_t seed)
+{
+  vector<uint32_t> order(n);
+  iota(order.begin(), order.end(), 0);
+  mt19937_64 rng(seed ? seed : random_device()());
+  shuffle(order.begin(), order.end(), rng);
+  return order;
+}
+
+// Renumber communities densely, largest first; returns their count
+uint32_t renumberBySize(vector<uint32_t> &community)
+{
+  vector<uint32_t> size(community.size(), 0);
+  for (uint32_t c : community)
+  {
+    ++size[c];
+  }
+  vector<uint32_t> ids;
+  for (uint32_t c = 0; c < size.size(); ++c)
+  {
+    if (size[c] > 0)
+    {
+      ids.push_back(c);
+    }
+  }
+  sort(ids.begin(), ids.end(), [&size](uint32_t a, uint32_t b) {
+    return size[a] != size[b] ? size[a] > size[b] : a < b;
+  });
+  vector<uint32_t> newId(size.size());
+  for (uint32_t i = 0; i < ids.size(); ++i)
+  {
+    newId[ids[i]] = i;
+  }
+  for (uint32_t &c : community)
+  {
+    c = newId[c];
+  }
+  return static_cast<uint32_t>(ids.size());
+}
+
+// Label propagation with a shared, in-place label array
+uint32_t propagateLabels(const FlatGraph &graph,
+                         const CommunityOptions &options,
+                         vector<uint32_t> &community, JobContext *context)
+{
+  size_t n = graph.vertexCount();
+  unique_ptr<atomic<uint32_t>[]> labels(new atomic<uint32_t>[n]);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    labels[v].store(v, memory_order_relaxed);
+  }
+  vector<uint32_t> order = shuffledOrder(n, options.seed);
+  vector<unique_ptr<Workspace>> workspaces(workerCount());
+  vector<size_t> changed(workerCount());
+
+  uint32_t rounds = 0;
+  while (rounds < options.maxIterations)
+  {
+    if (context != nullptr && context->cancelled())
+    {
+      break;
+    }
+    fill(changed.begin(), changed.end(), 0);
+    parallelFor(0, n, 512, [&](size_t lo, size_t hi, unsigned worker) {
+      if (!workspaces[worker])
+      {
+        workspaces[worker].reset(new Workspace(n));
+      }
+      Workspace &w = *workspaces[worker];
+      for (size_t i = lo; i < hi; ++i)
+      {
+        Vertex v = order[i];
+        for (uint32_t j = 0; j < graph.degree(v); ++j)
+        {
+          uint32_t label =
+              labels[graph.neighbors(v)[j]].load(memory_order_relaxed);
+          if (w.weightOf[label] == 0.0)
+          {
+            w.touched.push_back(label);
+          }
+          w.weightOf[label] += options.weighted ? graph.weights(v)[j] : 1.0;
+        }
+
+        // Heaviest label; ties keep the current label, then the smallest
+        uint32_t current = labels[v].load(memory_order_relaxed);
+        uint32_t best = current;
+        double bestWeight = w.weightOf[current];
+        for (uint32_t label : w.touched)
+        {
+          if (w.weightOf[label] > bestWeight ||
+              (w.weightOf[label] == bestWeight && best != current &&
+               label < best))
+          {
+            best = label;
+            bestWeight = w.weightOf[label];
+          }
+        }
+        if (best != current)
+        {
+          labels[v].store(best, memory_order_relaxed);
+          ++changed[worker];
+        }
+
+        for (uint32_t label : w.touched)
+        {
+          w.weightOf[label] = 0.0;
+        }
+        w.touched.clear();
+      }
+    });
+    ++rounds;
+    if (context != nullptr)
+    {
+      context->advance();
+    }
+    size_t total = accumulate(changed.begin(), changed.end(), size_t(0));
+    if (total <= options.tolerance * n)
+    {
+      break;
+    }
+  }
+
+  community.resize(n);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    community[v] = labels[v].load(memory_order_relaxed);
+  }
+  return rounds;
+}
+
+// Level 0 of Louvain: the flat graph itself
+LevelGraph baseLevel(const FlatGraph &graph, bool weighted)
+{
+  LevelGraph level;
+  size_t n = graph.vertexCount();
+  level.offsets = graph.offsetArray();
+  level.targets = graph.adjacencyArray();
+  level.weights.resize(level.targets.size());
+  for (size_t e = 0; e < level.targets.size(); ++e)
+  {
+    level.weights[e] = weighted ? graph.weightArray()[e] : 1.0;
+  }
+  level.selfLoop.assign(n, 0.0);
+  level.degree.assign(n, 0.0);
+  level.totalDegree = 0.0;
+  for (Vertex v = 0; v < n; ++v)
+  {
+    for (uint32_t e = level.offsets[v]; e < level.offsets[v + 1]; ++e)
+    {
+      level.degree[v] += level.weights[e];
+    }
+    level.totalDegree += level.degree[v];
+  }
+  return level;
+}
+
+// Louvain local moving on one level; returns whether any vertex moved.
+// Passes are reported to 'progress' (if any); 'context' can cancel them.
+bool moveVertices(const LevelGraph &level, const CommunityOptions &options,
+                  uint64_t seed, vector<uint32_t> &community,
+                  JobContext *context, JobContext *progress)
+{
+  size_t n = level.size();
+  const double m2 = level.totalDegree;
+  community.resize(n);
+  iota(community.begin(), community.end(), 0);
+  vector<double> total = level.degree; // weighted degree per community
+  vector<double> weightTo(n, 0.0);     // weight from v to each community
+  vector<uint32_t> touched;
+  vector<uint32_t> order = shuffledOrder(n, seed);
+
+  bool moved = false;
+  for (uint32_t pass = 0; pass < options.maxIterations; ++pass)
+  {
+    if (context != nullptr && context->cancelled())
+    {
+      break;
+    }
+    if (progress != nullptr)
+    {
+      progress->advance();
+    }
+    double passGain = 0.0;
+    for (uint32_t v : order)
+    {
+      uint32_t current = community[v];
+      double k = level.degree[v];
+      touched.push_back(current);
+      for (uint32_t e = level.offsets[v]; e < level.offsets[v + 1]; ++e)
+      {
+        uint32_t c = community[level.targets[e]];
+        if (weightTo[c] == 0.0)
+        {
+          touched.push_back(c);
+        }
+        weightTo[c] += level.weights[e];
+      }
+
+      // Gain of joining c from isolation, in units of 2 / 2m
+      total[current] -= k;
+      double currentGain =
+          weightTo[current] - options.resolution * total[current] * k / m2;
+      uint32_t best = current;
+      double bestGain = currentGain;
+      for (uint32_t c : touched)
+      {
+        double gain = weightTo[c] - options.resolution * total[c] * k / m2;
+        if (gain > bestGain)
+        {
+          best = c;
+          bestGain = gain;
+        }
+      }
+      total[best] += k;
+      if (best != current)
+      {
+        community[v] = best;
+        passGain += bestGain - currentGain;
+        moved = true;
+      }
+
+      for (uint32_t c : touched)
+      {
+        weightTo[c] = 0.0;
+      }
+      touched.clear();
+    }
+    if (2.0 * passGain / m2 < options.tolerance)
+    {
+      break;
+    }
+  }
+  return moved;
+}
+
+// Collapse every community of a level into one weighted vertex
+LevelGraph collapse(const LevelGraph &level, const vector<uint32_t> &community,
+                    uint32_t count)
+{
+  // Members of each community, grouped by a counting sort
+  vector<uint32_t> start(count + 1, 0);
+  for (uint32_t c : community)
+  {
+    ++start[c + 1];
+  }
+  partial_sum(start.begin(), start.end(), start.begin());
+  vector<uint32_t> members(community.size());
+  vector<uint32_t> next(start.begin(), start.end() - 1);
+  for (uint32_t v = 0; v < community.size(); ++v)
+  {
+    members[next[community[v]]++] = v;
+  }
+
+  LevelGraph coarse;
+  coarse.offsets.push_back(0);
+  coarse.selfLoop.assign(count, 0.0);
+  coarse.degree.assign(count, 0.0);
+  coarse.totalDegree = level.totalDegree;
+  vector<double> weightTo(count, 0.0);
+  vector<uint32_t> touched;
+  for (uint32_t c = 0; c < count; ++c)
+  {
+    for (uint32_t i = start[c]; i < start[c + 1]; ++i)
+    {
+      uint32_t v = members[i];
+      coarse.selfLoop[c] += level.selfLoop[v];
+      coarse.degree[c] += level.degree[v];
+      for (uint32_t e = level.offsets[v]; e < level.offsets[v + 1]; ++e)
+      {
+        uint32_t d = community[level.targets[e]];
+        if (d == c)
+        {
+          // Internal edges are seen from both ends
+          coarse.selfLoop[c] += level.weights[e] / 2.0;
+          continue;
+        }
+        if (weightTo[d] == 0.0)
+        {
+          touched.push_back(d);
+        }
+        weightTo[d] += level.weights[e];
+      }
+    }
+    sort(touched.begin(), touched.end());
+    for (uint32_t d : touched)
+    {
+      coarse.targets.push_back(d);
+      coarse.weights.push_back(weightTo[d]);
+      weightTo[d] = 0.0;
+    }
+    touched.clear();
+    coarse.offsets.push_back(static_cast<uint32_t>(coarse.targets.size()));
+  }
+  return coarse;
+}
+
+// Multilevel Louvain; returns the number of levels
+uint32_t louvain(const FlatGraph &graph, const CommunityOptions &options,
+                 vector<uint32_t> &community, JobContext *context)
+{
+  size_t n = graph.vertexCount();
+  community.resize(n);
+  iota(community.begin(), community.end(), 0);
+  LevelGraph level = baseLevel(graph, options.weighted);
+  if (level.totalDegree == 0.0)
+  {
+    return 0;
+  }
+
+  uint64_t seed = options.seed ? options.seed : random_device()();
+  uint32_t levels = 0;
+  vector<uint32_t> levelCommunity;
+  while (true)
+  {
+    // The first level holds every vertex and takes most of the time, so
+    // only its passes count as progress
+    bool moved = moveVertices(level, options, seed + levels, levelCommunity,
+                              context, levels == 0 ? context : nullptr);
+    ++levels;
+    if (!moved || (context != nullptr && context->cancelled()))
+    {
+      break;
+    }
+    uint32_t count = renumberBySize(levelCommunity);
+    for (uint32_t &c : community)
+    {
+      c = levelCommunity[c];
+    }
+    if (count == level.size())
+    {
+      break;
+    }
+    level = collapse(level, levelCommunity, count);
+  }
+  return levels;
+}
+} // namespace
+
+// Community detection
+CommunityResult detectCommunities(const FlatGraph &graph,
+                                  const CommunityOptions &options,
+                                  JobContext *context)
+{
+  CommunityResult result;
+  if (context != nullptr)
+  {
+    context->setTotal(options.maxIterations);
+  }
+  if (options.method == CommunityMethod::LABEL_PROPAGATION)
+  {
+    result.iterations =
+        propagateLabels(graph, options, result.community, context);
+  }
+  else
+  {
+    result.iterations = louvain(graph, options, result.community, context);
+  }
+  result.communityCount = renumberBySize(result.community);
+  result.modularity = calculateModularity(graph, result.community,
+                                          options.weighted,
+                                          options.resolution);
+  return result;
+}
+
+// Modularity of a partition
+double calculateModularity(const FlatGraph &graph,
+                           const vector<uint32_t> &community, bool weighted,
+                           double resolution)
+{
+  size_t n = graph.vertexCount();
+  vector<double> internal(workerCount(), 0.0);
+  vector<vector<double>> totals(workerCount());
+  parallelFor(0, n, 1024, [&](size_t lo, size_t hi, unsigned worker) {
+    vector<double> &total = totals[worker];
+    if (total.empty())
+    {
+      total.assign(n, 0.0);
+    }
+    for (size_t v = lo; v < hi; ++v)
+    {
+      for (uint32_t i = 0; i < graph.degree(v); ++i)
+      {
+        double w = weighted ? graph.weights(v)[i] : 1.0;
+        total[community[v]] += w;
+        if (community[graph.neighbors(v)[i]] == community[v])
+        {
+          internal[worker] += w;
+        }
+      }
+    }
+  });
+
+  double m2 = 0.0, in = 0.0;
+  vector<double> total(n, 0.0);
+  for (unsigned worker = 0; worker < totals.size(); ++worker)
+  {
+    in += internal[worker];
+    for (size_t c = 0; c < totals[worker].size(); ++c)
+    {
+      total[c] += totals[worker][c];
+    }
+  }
+  for (double t : total)
+  {
+    m2 += t;
+  }
+  if (m2 == 0.0)
+  {
+    return 0.0;
+  }
+  double expected = 0.0;
+  for (double t : total)
+  {
+    expected += (t / m2) * (t / m2);
+  }
+  return in / m2 - resolution * expected;
+}
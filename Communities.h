@@ -0,0 +1,89 @@
+/******************************************************************************
+    Community detection:
+    CommunityMethod: Label propagation (fast) or Louvain (quality).
+    CommunityOptions: Method and stopping criteria.
+    CommunityResult: Community of every vertex and the modularity reached.
+    detectCommunities: Partition a flat graph into communities.
+    calculateModularity: Modularity of a given partition.
+ * ****************************************************************************
+ * */
+
+#ifndef COMMUNITIES_H
+#define COMMUNITIES_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class JobContext;
+
+enum class CommunityMethod
+{
+  LABEL_PROPAGATION, // parallel, near-linear, lower modularity
+  LOUVAIN            // multilevel modularity optimization
+};
+
+struct CommunityOptions
+{
+  CommunityMethod method = CommunityMethod::LOUVAIN;
+  bool weighted = true;        // use Connection weights as edge weights
+  double resolution = 1.0;     // > 1 favors smaller communities
+  uint32_t maxIterations = 50; // propagation rounds / moving passes per level
+  double tolerance = 1e-4;     // Louvain: minimum modularity gain of a pass;
+                               // propagation: fraction of labels changed
+  uint64_t seed = 0;           // vertex visiting order; 0 = random_device
+};
+
+struct CommunityResult
+{
+  vector<uint32_t> community; // community per vertex, 0 = largest
+  uint32_t communityCount;    // number of distinct communities
+  double modularity;          // modularity of the partition
+  uint32_t iterations;        // propagation rounds / Louvain levels
+};
+
+/******************************************************************************
+ * Function: detectCommunities
+ *
+ * Purpose: Label propagation: every vertex repeatedly adopts the label with
+ *          the largest total edge weight among its neighbors. Vertices are
+ *          visited in a shuffled order split over the parallelFor workers,
+ *          which update a shared label array in place.
+ *          Louvain: vertices move greedily to the neighboring community
+ *          with the best modularity gain until no pass gains 'tolerance';
+ *          communities are then collapsed into weighted vertices and the
+ *          process repeats on the smaller graph. Moving is sequential (as
+ *          in the original algorithm); the coarsening is cheap next to it.
+ *          'context' (if any) receives progress per propagation round or
+ *          first-level moving pass, out of 'maxIterations', and can cancel
+ *          the detection.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns the partition, indexed by vertex ID. Community
+ *                 IDs are dense and ordered by decreasing size. A cancelled
+ *                 detection is partial.
+ *****************************************************************************/
+CommunityResult detectCommunities(const FlatGraph &graph,
+                                  const CommunityOptions &options,
+                                  JobContext *context = nullptr);
+
+/******************************************************************************
+ * Function: calculateModularity
+ *
+ * Purpose: Q = sum over communities c of in(c) / 2m - r * (tot(c) / 2m)^2,
+ *          where in(c) is twice the weight inside c, tot(c) the weighted
+ *          degree of c, 2m the total weighted degree and r the resolution.
+ *          Vertices are summed in parallel.
+ *
+ * Preconditions: 'community' has one entry per vertex.
+ *
+ * Postconditions: Returns Q (0 for a graph without edges).
+ *****************************************************************************/
+double calculateModularity(const FlatGraph &graph,
+                           const vector<uint32_t> &community,
+                           bool weighted = true, double resolution = 1.0);
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,149 @@
+#include "CompressedGraph.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace
+{
+// Append a varint
+void writeVarint(vector<uint8_t> &out, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+} // namespace
+
+// Constructor: encode the flat adjacency
+CompressedGraph::CompressedGraph(const FlatGraph &graph)
+    : dictionary(graph.users()), edgeOffsets(graph.offsetArray()),
+      byteOffsets(graph.vertexCount() + 1, 0), weightWidth(1)
+{
+  // Narrowest width that holds every weight
+  for (int w : graph.weightArray())
+  {
+    if (w < 0 || w > 0xFFFF)
+    {
+      weightWidth = 4;
+      break;
+    }
+    if (w > 0xFF)
+    {
+      weightWidth = 2;
+    }
+  }
+
+  size_t n = graph.vertexCount();
+  neighborBytes.reserve(graph.adjacencyArray().size() * 2);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    const Vertex *neighbors = graph.neighbors(v);
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      Vertex u = neighbors[i];
+      if (i == 0)
+      {
+        writeVarint(neighborBytes, u >= v ? 2 * (u - v) : 2 * (v - u - 1) + 1);
+      }
+      else
+      {
+        writeVarint(neighborBytes, u - neighbors[i - 1] - 1);
+      }
+    }
+    byteOffsets[v + 1] = neighborBytes.size();
+  }
+  neighborBytes.shrink_to_fit();
+
+  const vector<int> &weights = graph.weightArray();
+  weightBytes.resize(weights.size() * weightWidth);
+  for (size_t e = 0; e < weights.size(); ++e)
+  {
+    uint8_t *p = weightBytes.data() + e * weightWidth;
+    if (weightWidth == 1)
+    {
+      *p = static_cast<uint8_t>(weights[e]);
+    }
+    else if (weightWidth == 2)
+    {
+      uint16_t w = static_cast<uint16_t>(weights[e]);
+      memcpy(p, &w, sizeof(w));
+    }
+    else
+    {
+      int32_t w = weights[e];
+      memcpy(p, &w, sizeof(w));
+    }
+  }
+}
+
+// Breadth-first search
+vector<uint32_t> CompressedGraph::bfs(Vertex source) const
+{
+  vector<uint32_t> distance(vertexCount(), UNREACHED);
+  vector<Vertex> queue;
+  queue.reserve(vertexCount());
+  distance[source] = 0;
+  queue.push_back(source);
+  for (size_t head = 0; head < queue.size(); ++head)
+  {
+    Vertex v = queue[head];
+    uint32_t next = distance[v] + 1;
+    forEachNeighbor(v, [&](Vertex u) {
+      if (distance[u] == UNREACHED)
+      {
+        distance[u] = next;
+        queue.push_back(u);
+      }
+    });
+  }
+  return distance;
+}
+
+// Dijkstra's algorithm
+vector<int64_t> CompressedGraph::dijkstra(Vertex source,
+                                          vector<Vertex> *parent) const
+{
+  typedef pair<int64_t, Vertex> Entry;
+  vector<int64_t> distance(vertexCount(), -1);
+  if (parent != nullptr)
+  {
+    parent->assign(vertexCount(), NO_VERTEX);
+  }
+  priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+  distance[source] = 0;
+  queue.push(Entry(0, source));
+  while (!queue.empty())
+  {
+    Entry top = queue.top();
+    queue.pop();
+    Vertex v = top.second;
+    if (top.first != distance[v])
+    {
+      continue; // stale entry
+    }
+    forEachWeightedNeighbor(v, [&](Vertex u, int weight) {
+      int64_t candidate = top.first + weight;
+      if (distance[u] < 0 || candidate < distance[u])
+      {
+        distance[u] = candidate;
+        if (parent != nullptr)
+        {
+          (*parent)[u] = v;
+        }
+        queue.push(Entry(candidate, u));
+      }
+    });
+  }
+  return distance;
+}
+
+// Memory of the encoded adjacency
+size_t CompressedGraph::adjacencyBytes() const
+{
+  return edgeOffsets.capacity() * sizeof(uint32_t) +
+         byteOffsets.capacity() * sizeof(uint64_t) + neighborBytes.capacity() +
+         weightBytes.capacity();
+}
@@ -0,0 +1,227 @@
+/******************************************************************************
+    Implementation of CompressedGraph class:
+    CompressedGraph: Constructor encoding a flat graph.
+    vertexCount: Number of vertices.
+    edgeCount: Number of undirected edges.
+    degree: Number of neighbors of a vertex.
+    forEachNeighbor: Decode the neighbors (and weights) of a vertex inline.
+    bfs: Hop distances from one vertex.
+    dijkstra: Weighted distances (and shortest-path tree) from one vertex.
+    adjacencyBytes: Memory used by the encoded adjacency.
+    idOf / nameOf / users: The vertex dictionary.
+ * ****************************************************************************
+ * */
+
+#ifndef COMPRESSEDGRAPH_H
+#define COMPRESSEDGRAPH_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: CompressedGraph
+ *
+ * Description: Read-only adjacency for graphs too large for Connection
+ *              objects or even a flat array. Each vertex's sorted neighbor
+ *              IDs are stored as varint deltas: the first relative to the
+ *              vertex itself (zigzag, so a reordered graph with small
+ *              neighbor gaps encodes in a byte or two), the rest as the gap
+ *              to the previous neighbor minus one. Weights live in a
+ *              separate array at the smallest fixed width (1, 2 or 4 bytes)
+ *              that fits them, so traversals that ignore weights never
+ *              touch them. Neighbors are decoded inline by the traversal
+ *              loops; there is no decompressed copy.
+ *
+ * Member Variables:
+ *    - dictionary: Username <-> vertex ID, as in the source flat graph.
+ *    - edgeOffsets: First adjacency entry of each vertex; gives degrees
+ *                   and the position of its weights.
+ *    - byteOffsets: First byte of each vertex's neighbor encoding.
+ *    - neighborBytes: Varint-encoded neighbor deltas of all vertices.
+ *    - weightBytes: Weights of all adjacency entries, 'weightWidth' bytes
+ *                   each.
+ *    - weightWidth: Bytes per weight.
+ *
+ *****************************************************************************/
+class CompressedGraph
+{
+public:
+  typedef FlatGraph::Vertex Vertex;
+  static constexpr Vertex NO_VERTEX = FlatGraph::NO_VERTEX;
+  static constexpr uint32_t UNREACHED = UINT32_MAX;
+
+  /***** Constructors *****/
+  explicit CompressedGraph(const FlatGraph &graph);
+  /*-------------------------------------------------------------------------
+    Encode the adjacency of a flat graph, keeping its vertex IDs.
+
+    Preconditions: None.
+    Postconditions: The compressed graph does not reference 'graph'.
+  -------------------------------------------------------------------------*/
+
+  /***** Graph Information *****/
+  size_t vertexCount() const { return edgeOffsets.size() - 1; }
+  size_t edgeCount() const { return edgeOffsets.back() / 2; }
+  uint32_t degree(Vertex v) const
+  {
+    return edgeOffsets[v + 1] - edgeOffsets[v];
+  }
+
+  template <typename Visit>
+  void forEachNeighbor(Vertex v, Visit visit) const;
+  /*-------------------------------------------------------------------------
+    Call visit(neighbor) for every neighbor of 'v', in increasing order.
+
+    Preconditions: 'v' is less than vertexCount().
+    Postconditions: None.
+  -------------------------------------------------------------------------*/
+
+  template <typename Visit>
+  void forEachWeightedNeighbor(Vertex v, Visit visit) const;
+  /*-------------------------------------------------------------------------
+    Call visit(neighbor, weight) for every neighbor of 'v', in increasing
+    order.
+
+    Preconditions: 'v' is less than vertexCount().
+    Postconditions: None.
+  -------------------------------------------------------------------------*/
+
+  /***** Traversals *****/
+  vector<uint32_t> bfs(Vertex source) const;
+  /*-------------------------------------------------------------------------
+    Breadth-first search from 'source'.
+
+    Preconditions: 'source' is less than vertexCount().
+    Postconditions: Returns the hop distance of every vertex, UNREACHED if
+                    it cannot be reached.
+  -------------------------------------------------------------------------*/
+
+  vector<int64_t> dijkstra(Vertex source, vector<Vertex> *parent = nullptr)
+      const;
+  /*-------------------------------------------------------------------------
+    Dijkstra's algorithm over the weights from 'source'.
+
+    Preconditions: 'source' is less than vertexCount(); weights are not
+                   negative.
+    Postconditions: Returns the distance of every vertex, -1 if it cannot
+                    be reached. If 'parent' is given, it receives each
+                    vertex's predecessor on a shortest path (NO_VERTEX for
+                    the source and unreached vertices).
+  -------------------------------------------------------------------------*/
+
+  /***** Memory *****/
+  size_t adjacencyBytes() const;
+  /*-------------------------------------------------------------------------
+    Report the memory of the encoded adjacency and its offsets.
+
+    Preconditions: None.
+    Postconditions: Returns the size in bytes, excluding the dictionary.
+  -------------------------------------------------------------------------*/
+
+  /***** Dictionary *****/
+  Vertex idOf(string_view userName) const { return dictionary.findRow(userName); }
+  string_view nameOf(Vertex v) const { return dictionary.getUserName(v); }
+  const UserStore &users() const { return dictionary; }
+
+private:
+  static uint32_t readVarint(const uint8_t *&p);
+  int weightAt(uint32_t entry) const;
+
+  /***** Member Variables *****/
+  UserStore dictionary;          // username <-> vertex ID
+  vector<uint32_t> edgeOffsets;  // first adjacency entry per vertex
+  vector<uint64_t> byteOffsets;  // first encoded byte per vertex
+  vector<uint8_t> neighborBytes; // varint neighbor deltas
+  vector<uint8_t> weightBytes;   // fixed-width weights
+  uint8_t weightWidth;           // bytes per weight: 1, 2 or 4
+};
+
+// Decode one varint and advance 'p' past it
+inline uint32_t CompressedGraph::readVarint(const uint8_t *&p)
+{
+  // Fast paths: almost every delta fits in one or two bytes
+  uint32_t value = p[0];
+  if (value < 0x80)
+  {
+    p += 1;
+    return value;
+  }
+  uint32_t next = p[1];
+  value = (value & 0x7F) | (next << 7);
+  if (next < 0x80)
+  {
+    p += 2;
+    return value;
+  }
+  value &= 0x3FFF;
+  p += 2;
+  int shift = 14;
+  uint8_t byte;
+  do
+  {
+    byte = *p++;
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+// Weight of one adjacency entry
+inline int CompressedGraph::weightAt(uint32_t entry) const
+{
+  const uint8_t *p = weightBytes.data() + static_cast<size_t>(entry) *
+                                              weightWidth;
+  switch (weightWidth)
+  {
+  case 1:
+    return *p;
+  case 2:
+  {
+    uint16_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+  }
+  default:
+  {
+    int32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+  }
+  }
+}
+
+// Decode the neighbors of a vertex
+template <typename Visit>
+void CompressedGraph::forEachNeighbor(Vertex v, Visit visit) const
+{
+  uint32_t count = degree(v);
+  if (count == 0)
+  {
+    return;
+  }
+  const uint8_t *p = neighborBytes.data() + byteOffsets[v];
+  uint32_t first = readVarint(p);
+  // Zigzag: even codes are at or above v, odd codes below
+  Vertex u = (first & 1) ? v - (first >> 1) - 1 : v + (first >> 1);
+  visit(u);
+  for (uint32_t i = 1; i < count; ++i)
+  {
+    u += readVarint(p) + 1;
+    visit(u);
+  }
+}
+
+// Decode the neighbors of a vertex with their weights
+template <typename Visit>
+void CompressedGraph::forEachWeightedNeighbor(Vertex v, Visit visit) const
+{
+  uint32_t entry = edgeOffsets[v];
+  forEachNeighbor(v, [&](Vertex u) { visit(u, weightAt(entry++)); });
+}
+
+#endif // END OF THE HEADER FILE
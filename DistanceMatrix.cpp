@@ -0,0 +1,353 @@
+#include "DistanceMatrix.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DISTANCEMATRIX_SSE2 1
+#endif
+
+namespace
+{
+const size_t TILE = 64;              // tile edge, in elements
+const char MAGIC[4] = {'D', 'M', 'A', 'T'};
+const uint32_t FORMAT_VERSION = 1;
+
+// Min-plus arithmetic per element type. Infinity is chosen so that
+// INF + anything never overflows and min() keeps it at INF.
+template <typename T> struct MinPlus;
+
+template <> struct MinPlus<int16_t>
+{
+  static constexpr int16_t INF = 0x7FFF; // saturating adds stop here
+#ifdef DISTANCEMATRIX_SSE2
+  static const size_t LANES = 8;
+  static __m128i splat(int16_t x) { return _mm_set1_epi16(x); }
+  static __m128i add(__m128i a, __m128i b) { return _mm_adds_epi16(a, b); }
+  static __m128i min(__m128i a, __m128i b) { return _mm_min_epi16(a, b); }
+#endif
+  static int16_t add(int16_t a, int16_t b)
+  {
+    int sum = a + b;
+    return static_cast<int16_t>(sum > INF ? INF : sum);
+  }
+};
+
+template <> struct MinPlus<int32_t>
+{
+  static constexpr int32_t INF = 0x3FFFFFFF; // INF + INF still fits
+#ifdef DISTANCEMATRIX_SSE2
+  static const size_t LANES = 4;
+  static __m128i splat(int32_t x) { return _mm_set1_epi32(x); }
+  static __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+  static __m128i min(__m128i a, __m128i b)
+  {
+    // SSE2 has no 32-bit min; select through a comparison mask
+    __m128i less = _mm_cmplt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+  }
+#endif
+  static int32_t add(int32_t a, int32_t b) { return a + b; }
+};
+
+// C = min(C, A (x) B) for one tile, k outermost so that A, B and C may
+// be the same tile (diagonal, row and column phases)
+template <typename T>
+void relaxTile(T *c, const T *a, const T *b, size_t stride)
+{
+  typedef MinPlus<T> Ops;
+  for (size_t k = 0; k < TILE; ++k)
+  {
+    const T *bRow = b + k * stride;
+    for (size_t i = 0; i < TILE; ++i)
+    {
+      T aik = a[i * stride + k];
+      if (aik == Ops::INF)
+      {
+        continue;
+      }
+      T *cRow = c + i * stride;
+#ifdef DISTANCEMATRIX_SSE2
+      __m128i va = Ops::splat(aik);
+      for (size_t j = 0; j < TILE; j += Ops::LANES)
+      {
+        __m128i vb =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(bRow + j));
+        __m128i vc = _mm_loadu_si128(reinterpret_cast<__m128i *>(cRow + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(cRow + j),
+                         Ops::min(vc, Ops::add(va, vb)));
+      }
+#else
+      for (size_t j = 0; j < TILE; ++j)
+      {
+        cRow[j] = min(cRow[j], Ops::add(aik, bRow[j]));
+      }
+#endif
+    }
+  }
+}
+
+// Blocked Floyd-Warshall over a padded row-major matrix
+template <typename T> void floydWarshall(vector<T> &d, size_t stride)
+{
+  size_t tiles = stride / TILE;
+  auto tile = [&](size_t row, size_t col) {
+    return d.data() + row * TILE * stride + col * TILE;
+  };
+  for (size_t k = 0; k < tiles; ++k)
+  {
+    // Phase 1: close the diagonal tile
+    T *diagonal = tile(k, k);
+    relaxTile(diagonal, diagonal, diagonal, stride);
+
+    // Phase 2: tiles in row k and column k, through the diagonal tile
+    parallelFor(0, tiles, 1, [&](size_t lo, size_t hi, unsigned) {
+      for (size_t t = lo; t < hi; ++t)
+      {
+        if (t != k)
+        {
+          relaxTile(tile(k, t), diagonal, tile(k, t), stride);
+          relaxTile(tile(t, k), tile(t, k), diagonal, stride);
+        }
+      }
+    });
+
+    // Phase 3: every other tile, through row k and column k
+    parallelFor(0, tiles, 1, [&](size_t lo, size_t hi, unsigned) {
+      for (size_t i = lo; i < hi; ++i)
+      {
+        if (i == k)
+        {
+          continue;
+        }
+        for (size_t j = 0; j < tiles; ++j)
+        {
+          if (j != k)
+          {
+            relaxTile(tile(i, j), tile(i, k), tile(k, j), stride);
+          }
+        }
+      }
+    });
+  }
+}
+
+// Fill the matrix with the edges and run Floyd-Warshall
+template <typename T>
+void computeDistances(const FlatGraph &graph, bool weighted, size_t stride,
+                      vector<T> &d)
+{
+  d.assign(stride * stride, MinPlus<T>::INF);
+  for (size_t v = 0; v < stride; ++v)
+  {
+    d[v * stride + v] = 0;
+  }
+  for (FlatGraph::Vertex v = 0; v < graph.vertexCount(); ++v)
+  {
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      T w = static_cast<T>(weighted ? graph.weights(v)[i] : 1);
+      T &entry = d[v * stride + graph.neighbors(v)[i]];
+      entry = min(entry, w);
+    }
+  }
+  floydWarshall(d, stride);
+}
+
+// Binary helpers for save() and load()
+template <typename T> void writeValue(ofstream &out, const T &value)
+{
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool readValue(ifstream &in, T &value)
+{
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+void writeString(ofstream &out, string_view s)
+{
+  writeValue(out, static_cast<uint32_t>(s.size()));
+  out.write(s.data(), s.size());
+}
+
+bool readString(ifstream &in, string &s)
+{
+  uint32_t length;
+  if (!readValue(in, length))
+  {
+    return false;
+  }
+  s.resize(length);
+  return static_cast<bool>(in.read(&s[0], length));
+}
+
+// Row length for 'count' vertices
+size_t paddedStride(size_t count)
+{
+  return (count + TILE - 1) / TILE * TILE;
+}
+} // namespace
+
+// Default constructor
+DistanceMatrix::DistanceMatrix() : count(0), stride(0) {}
+
+// Constructor: all-pairs shortest paths of a flat graph
+DistanceMatrix::DistanceMatrix(const FlatGraph &graph, bool weighted)
+    : dictionary(graph.users()), count(graph.vertexCount()),
+      stride(paddedStride(graph.vertexCount()))
+{
+  // 16 bits suffice if no simple path can reach their infinity
+  int64_t maxWeight = 1;
+  if (weighted)
+  {
+    for (int w : graph.weightArray())
+    {
+      maxWeight = max<int64_t>(maxWeight, w);
+    }
+  }
+  int64_t longest = (count > 0 ? static_cast<int64_t>(count) - 1 : 0) *
+                    maxWeight;
+  if (longest < MinPlus<int16_t>::INF)
+  {
+    computeDistances(graph, weighted, stride, narrow);
+  }
+  else
+  {
+    computeDistances(graph, weighted, stride, wide);
+  }
+}
+
+// Distance between two vertices
+int64_t DistanceMatrix::distance(Vertex from, Vertex to) const
+{
+  if (from >= count || to >= count)
+  {
+    return UNREACHABLE;
+  }
+  size_t entry = static_cast<size_t>(from) * stride + to;
+  if (!narrow.empty())
+  {
+    int16_t d = narrow[entry];
+    return d == MinPlus<int16_t>::INF ? UNREACHABLE : d;
+  }
+  int32_t d = wide[entry];
+  return d >= MinPlus<int32_t>::INF ? UNREACHABLE : d;
+}
+
+// Distance between two users
+int64_t DistanceMatrix::distance(string_view from, string_view to) const
+{
+  return distance(idOf(from), idOf(to));
+}
+
+// Write the matrix to a binary file
+bool DistanceMatrix::save(const string &fileName) const
+{
+  ofstream out(fileName, ios::binary);
+  if (!out.is_open())
+  {
+    cerr << "Error: Unable to open " << fileName << " for writing\n";
+    return false;
+  }
+  out.write(MAGIC, sizeof(MAGIC));
+  writeValue(out, FORMAT_VERSION);
+  writeValue(out, static_cast<uint64_t>(count));
+  writeValue(out, static_cast<uint8_t>(narrow.empty() ? 4 : 2));
+  for (Vertex v = 0; v < count; ++v)
+  {
+    writeValue(out, static_cast<int32_t>(dictionary.getUserId(v)));
+    writeString(out, dictionary.getUserName(v));
+    writeString(out, dictionary.getFirstName(v));
+    writeString(out, dictionary.getLastName(v));
+    writeString(out, dictionary.getEmail(v));
+  }
+  // Rows without their padding
+  for (size_t row = 0; row < count; ++row)
+  {
+    if (!narrow.empty())
+    {
+      out.write(reinterpret_cast<const char *>(&narrow[row * stride]),
+                count * sizeof(int16_t));
+    }
+    else
+    {
+      out.write(reinterpret_cast<const char *>(&wide[row * stride]),
+                count * sizeof(int32_t));
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+// Read a matrix written by save()
+bool DistanceMatrix::load(const string &fileName)
+{
+  ifstream in(fileName, ios::binary);
+  if (!in.is_open())
+  {
+    cerr << "Error: Unable to open " << fileName << " for reading\n";
+    return false;
+  }
+  char magic[sizeof(MAGIC)];
+  uint32_t version;
+  uint64_t newCount;
+  uint8_t width;
+  if (!in.read(magic, sizeof(magic)) ||
+      !equal(magic, magic + sizeof(magic), MAGIC) ||
+      !readValue(in, version) || version != FORMAT_VERSION ||
+      !readValue(in, newCount) || !readValue(in, width) ||
+      (width != 2 && width != 4))
+  {
+    cerr << "Error: " << fileName << " is not a distance matrix file\n";
+    return false;
+  }
+
+  UserStore newDictionary;
+  newDictionary.reserve(newCount, 0);
+  string userName, firstName, lastName, email;
+  for (uint64_t v = 0; v < newCount; ++v)
+  {
+    int32_t userId;
+    if (!readValue(in, userId) || !readString(in, userName) ||
+        !readString(in, firstName) || !readString(in, lastName) ||
+        !readString(in, email))
+    {
+      cerr << "Error: " << fileName << " is truncated\n";
+      return false;
+    }
+    newDictionary.addUser(userId, userName, firstName, lastName, email);
+  }
+
+  size_t newStride = paddedStride(newCount);
+  vector<int16_t> newNarrow;
+  vector<int32_t> newWide;
+  if (width == 2)
+  {
+    newNarrow.assign(newStride * newStride, MinPlus<int16_t>::INF);
+  }
+  else
+  {
+    newWide.assign(newStride * newStride, MinPlus<int32_t>::INF);
+  }
+  for (size_t row = 0; row < newCount; ++row)
+  {
+    char *target = width == 2
+                       ? reinterpret_cast<char *>(&newNarrow[row * newStride])
+                       : reinterpret_cast<char *>(&newWide[row * newStride]);
+    if (!in.read(target, newCount * width))
+    {
+      cerr << "Error: " << fileName << " is truncated\n";
+      return false;
+    }
+  }
+
+  dictionary = std::move(newDictionary);
+  count = newCount;
+  stride = newStride;
+  narrow.swap(newNarrow);
+  wide.swap(newWide);
+  return true;
+}
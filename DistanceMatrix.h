@@ -0,0 +1,115 @@
+/******************************************************************************
+    Implementation of DistanceMatrix class:
+    DistanceMatrix: Compute all-pairs shortest paths of a flat graph, or
+     construct an empty matrix to load into.
+    size: Number of vertices.
+    distance: Shortest-path distance between two vertices or users.
+    save / load: Write the matrix to a binary file and read it back.
+    idOf / nameOf / users: The vertex dictionary.
+ * ****************************************************************************
+ * */
+
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: DistanceMatrix
+ *
+ * Description: All-pairs shortest-path distances of a (sub)graph, for
+ *              repeated many-to-many distance queries. Computed with a
+ *              blocked Floyd-Warshall: the matrix is split into 64 x 64
+ *              tiles that stay in cache; for each diagonal tile, the tile
+ *              itself is closed first, then its row and column tiles, then
+ *              every other tile, with the independent tiles of each phase
+ *              spread over the parallelFor workers. The min-plus inner loop
+ *              runs on SSE2 vectors. Distances are stored as 16-bit values
+ *              when every finite distance is known to fit (hop counts,
+ *              small weights), halving memory and doubling the SIMD width,
+ *              and as 32-bit values otherwise.
+ *
+ * Member Variables:
+ *    - dictionary: Username <-> vertex ID, as in the source graph.
+ *    - count: Number of vertices.
+ *    - stride: Row length, 'count' rounded up to whole tiles.
+ *    - narrow / wide: The distances (only one is used), row-major.
+ *
+ *****************************************************************************/
+class DistanceMatrix
+{
+public:
+  typedef FlatGraph::Vertex Vertex;
+  static constexpr int64_t UNREACHABLE = -1;
+
+  /***** Constructors *****/
+  DistanceMatrix();
+  /*-------------------------------------------------------------------------
+    Construct an empty matrix, e.g. to load() into.
+
+    Preconditions: None.
+    Postconditions: size() is 0.
+  -------------------------------------------------------------------------*/
+
+  explicit DistanceMatrix(const FlatGraph &graph, bool weighted = true);
+  /*-------------------------------------------------------------------------
+    Compute the distances between all pairs of vertices of 'graph'.
+
+    Preconditions: Weights are not negative. Memory for vertexCount()^2
+                   distances (2 or 4 bytes each) is available.
+    Postconditions: Vertex IDs are those of 'graph'. Unweighted distances
+                    count hops.
+  -------------------------------------------------------------------------*/
+
+  /***** Queries *****/
+  size_t size() const { return count; }
+
+  int64_t distance(Vertex from, Vertex to) const;
+  int64_t distance(string_view from, string_view to) const;
+  /*-------------------------------------------------------------------------
+    Look up a shortest-path distance.
+
+    Preconditions: None.
+    Postconditions: Returns UNREACHABLE if there is no path, or if a vertex
+                    or user is not in the matrix.
+  -------------------------------------------------------------------------*/
+
+  /***** File I/O *****/
+  bool save(const string &fileName) const;
+  /*-------------------------------------------------------------------------
+    Write the dictionary and the distances to a binary file.
+
+    Preconditions: None.
+    Postconditions: Returns false if the file cannot be written.
+  -------------------------------------------------------------------------*/
+
+  bool load(const string &fileName);
+  /*-------------------------------------------------------------------------
+    Replace this matrix with one written by save().
+
+    Preconditions: None.
+    Postconditions: Returns false (leaving the matrix unchanged) if the file
+                    cannot be read or is not a distance matrix.
+  -------------------------------------------------------------------------*/
+
+  /***** Dictionary *****/
+  Vertex idOf(string_view userName) const { return dictionary.findRow(userName); }
+  string_view nameOf(Vertex v) const { return dictionary.getUserName(v); }
+  const UserStore &users() const { return dictionary; }
+
+private:
+  /***** Member Variables *****/
+  UserStore dictionary;  // username <-> vertex ID
+  size_t count;          // vertices
+  size_t stride;         // row length, padded to whole tiles
+  vector<int16_t> narrow; // distances when they fit in 16 bits
+  vector<int32_t> wide;   // distances otherwise
+};
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,314 @@
+#include "DurableIO.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+int openAppend(const char *name)
+{
+  return _open(name, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY,
+               _S_IREAD | _S_IWRITE);
+}
+int openWrite(const char *name)
+{
+  return _open(name, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+               _S_IREAD | _S_IWRITE);
+}
+long long writeSome(int fd, const char *data, size_t size)
+{
+  return _write(fd, data, static_cast<unsigned>(size));
+}
+int syncFd(int fd) { return _commit(fd); }
+int truncateFd(int fd, uint64_t size)
+{
+  return _chsize_s(fd, static_cast<long long>(size));
+}
+long long fileSize(int fd) { return _lseeki64(fd, 0, SEEK_END); }
+int closeFd(int fd) { return _close(fd); }
+#else
+int openAppend(const char *name)
+{
+  return ::open(name, O_WRONLY | O_CREAT | O_APPEND, 0644);
+}
+int openWrite(const char *name)
+{
+  return ::open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+long long writeSome(int fd, const char *data, size_t size)
+{
+  return ::write(fd, data, size);
+}
+int syncFd(int fd) { return ::fdatasync(fd); }
+int truncateFd(int fd, uint64_t size)
+{
+  return ::ftruncate(fd, static_cast<off_t>(size));
+}
+long long fileSize(int fd) { return ::lseek(fd, 0, SEEK_END); }
+int closeFd(int fd) { return ::close(fd); }
+#endif
+
+// Write every byte, retrying short writes
+bool writeFully(int fd, const char *data, size_t size)
+{
+  while (size > 0)
+  {
+    long long written = writeSome(fd, data, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+// Make a rename in 'fileName's directory durable
+void syncParentDirectory(const string &fileName)
+{
+#ifndef _WIN32
+  size_t slash = fileName.find_last_of('/');
+  string directory = slash == string::npos ? "." : fileName.substr(0, slash);
+  int fd = ::open(directory.c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    ::fsync(fd);
+    ::close(fd);
+  }
+#else
+  (void)fileName;
+#endif
+}
+
+// Table of the reflected IEEE polynomial
+struct CrcTable
+{
+  uint32_t entries[256];
+  CrcTable()
+  {
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+      uint32_t c = i;
+      for (int bit = 0; bit < 8; ++bit)
+      {
+        c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[i] = c;
+    }
+  }
+};
+} // namespace
+
+// CRC-32 of a byte range
+uint32_t crc32(const void *data, size_t size, uint32_t crc)
+{
+  static const CrcTable table;
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+  {
+    crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// Constructor
+DurableFile::DurableFile() : fd(-1) {}
+
+// Destructor
+DurableFile::~DurableFile() { close(); }
+
+// Open a file for appending
+bool DurableFile::open(const string &fileName)
+{
+  close();
+  path = fileName;
+  fd = openAppend(fileName.c_str());
+  if (fd < 0)
+  {
+    cerr << "Error: cannot open " << fileName << ": " << strerror(errno)
+         << endl;
+    return false;
+  }
+  return true;
+}
+
+// Append bytes at the end
+bool DurableFile::append(const void *data, size_t size)
+{
+  if (!writeFully(fd, static_cast<const char *>(data), size))
+  {
+    cerr << "Error: cannot write " << path << ": " << strerror(errno) << endl;
+    return false;
+  }
+  return true;
+}
+
+// Force the written bytes to the disk
+bool DurableFile::sync()
+{
+  if (syncFd(fd) != 0)
+  {
+    cerr << "Error: cannot sync " << path << ": " << strerror(errno) << endl;
+    return false;
+  }
+  return true;
+}
+
+// Cut the file and sync
+bool DurableFile::truncate(uint64_t size)
+{
+  if (truncateFd(fd, size) != 0)
+  {
+    cerr << "Error: cannot truncate " << path << ": " << strerror(errno)
+         << endl;
+    return false;
+  }
+  return sync();
+}
+
+// Current file size
+uint64_t DurableFile::size() const
+{
+  long long end = fileSize(fd);
+  return end < 0 ? 0 : static_cast<uint64_t>(end);
+}
+
+// Close the descriptor
+void DurableFile::close()
+{
+  if (fd >= 0)
+  {
+    closeFd(fd);
+    fd = -1;
+  }
+}
+
+// Constructor
+MappedFile::MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+
+// Destructor
+MappedFile::~MappedFile() { close(); }
+
+// Map a whole file
+bool MappedFile::open(const string &fileName)
+{
+  close();
+#ifdef _WIN32
+  if (!readWholeFile(fileName, copy))
+  {
+    cerr << "Error: cannot read " << fileName << endl;
+    return false;
+  }
+  bytes = copy.data();
+  length = copy.size();
+  return true;
+#else
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  struct stat status;
+  if (fd < 0 || ::fstat(fd, &status) != 0)
+  {
+    cerr << "Error: cannot open " << fileName << ": " << strerror(errno)
+         << endl;
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+    return false;
+  }
+  length = static_cast<size_t>(status.st_size);
+  if (length > 0)
+  {
+    void *address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED)
+    {
+      cerr << "Error: cannot map " << fileName << ": " << strerror(errno)
+           << endl;
+      ::close(fd);
+      length = 0;
+      return false;
+    }
+    bytes = static_cast<const char *>(address);
+    mapped = true;
+  }
+  ::close(fd); // the mapping stays valid
+  return true;
+#endif
+}
+
+// Unmap the file
+void MappedFile::close()
+{
+#ifndef _WIN32
+  if (mapped)
+  {
+    ::munmap(const_cast<char *>(bytes), length);
+  }
+#endif
+  bytes = nullptr;
+  length = 0;
+  mapped = false;
+  copy.clear();
+}
+
+// Read a file into memory
+bool readWholeFile(const string &fileName, string &contents)
+{
+  contents.clear();
+  ifstream file(fileName, ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+// Replace a file atomically: temporary file, sync, rename
+bool replaceFileDurably(const string &fileName, const string &contents)
+{
+  string temporary = fileName + ".tmp";
+  int fd = openWrite(temporary.c_str());
+  bool written = fd >= 0 && writeFully(fd, contents.data(), contents.size()) &&
+                 syncFd(fd) == 0;
+  if (fd >= 0)
+  {
+    closeFd(fd);
+  }
+  if (!written)
+  {
+    cerr << "Error: cannot write " << temporary << ": " << strerror(errno)
+         << endl;
+    remove(temporary.c_str());
+    return false;
+  }
+#ifdef _WIN32
+  remove(fileName.c_str()); // rename does not replace on Windows
+#endif
+  if (rename(temporary.c_str(), fileName.c_str()) != 0)
+  {
+    cerr << "Error: cannot replace " << fileName << ": " << strerror(errno)
+         << endl;
+    remove(temporary.c_str());
+    return false;
+  }
+  syncParentDirectory(fileName);
+  return true;
+}
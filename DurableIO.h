@@ -0,0 +1,246 @@
+/******************************************************************************
+    Low-level helpers for crash-safe files:
+    crc32: Checksum of a byte range.
+    ByteWriter / ByteReader: Little-endian encoding of numbers and strings.
+    DurableFile: Append-only file handle with write, sync and truncate.
+    MappedFile: Read-only memory mapping of a whole file.
+    readWholeFile: Read a file into memory.
+    replaceFileDurably: Atomically replace a file with new contents.
+ * ****************************************************************************
+ * */
+
+#ifndef DURABLEIO_H
+#define DURABLEIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+/******************************************************************************
+ * Function: crc32
+ *
+ * Purpose: CRC-32 (IEEE) of 'size' bytes, continuing from 'crc' so that a
+ *          checksum can be computed over several pieces.
+ *
+ * Preconditions: 'data' points to 'size' readable bytes.
+ *
+ * Postconditions: Returns the checksum.
+ *****************************************************************************/
+uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+/******************************************************************************
+ * Class: ByteWriter / ByteReader
+ *
+ * Description: Encode fixed-width integers (little-endian, whatever the
+ *              host order) and length-prefixed strings into a byte string,
+ *              and decode them with bounds checks, for the log and
+ *              checkpoint formats.
+ *
+ * Member Variables:
+ *    - out: String the writer appends to.
+ *    - cursor / end: Unread part of the reader's input.
+ *
+ *****************************************************************************/
+class ByteWriter
+{
+public:
+  explicit ByteWriter(string &out) : out(out) {}
+
+  void u8(uint8_t value) { out.push_back(static_cast<char>(value)); }
+  void u16(uint16_t value) { put(value, 2); }
+  void u32(uint32_t value) { put(value, 4); }
+  void u64(uint64_t value) { put(value, 8); }
+  void str(string_view value)
+  {
+    u32(static_cast<uint32_t>(value.size()));
+    out.append(value.data(), value.size());
+  }
+
+private:
+  void put(uint64_t value, int bytes)
+  {
+    for (int i = 0; i < bytes; ++i)
+    {
+      out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  string &out;
+};
+
+class ByteReader
+{
+public:
+  ByteReader(const char *data, size_t size) : cursor(data), end(data + size) {}
+
+  bool u8(uint8_t &value) { return get(value, 1); }
+  bool u16(uint16_t &value) { return get(value, 2); }
+  bool u32(uint32_t &value) { return get(value, 4); }
+  bool u64(uint64_t &value) { return get(value, 8); }
+  bool str(string &value)
+  {
+    uint32_t size;
+    if (!u32(size) || size > remaining())
+    {
+      return false;
+    }
+    value.assign(cursor, size);
+    cursor += size;
+    return true;
+  }
+  bool skip(size_t count)
+  {
+    if (count > remaining())
+    {
+      return false;
+    }
+    cursor += count;
+    return true;
+  }
+  size_t remaining() const { return static_cast<size_t>(end - cursor); }
+  const char *position() const { return cursor; }
+
+private:
+  template <typename T> bool get(T &value, int bytes)
+  {
+    if (remaining() < static_cast<size_t>(bytes))
+    {
+      return false;
+    }
+    uint64_t result = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+      result |= static_cast<uint64_t>(static_cast<unsigned char>(cursor[i]))
+                << (8 * i);
+    }
+    value = static_cast<T>(result);
+    cursor += bytes;
+    return true;
+  }
+
+  const char *cursor;
+  const char *end;
+};
+
+/******************************************************************************
+ * Class: DurableFile
+ *
+ * Description: Thin wrapper over a file descriptor opened for appending,
+ *              for files whose writes must reach the disk (fsync) before
+ *              they are reported durable. Errors are reported on cerr and
+ *              returned as false.
+ *
+ * Member Variables:
+ *    - fd: The open file descriptor, -1 when closed.
+ *    - path: Name of the file, for error messages.
+ *
+ *****************************************************************************/
+class DurableFile
+{
+public:
+  DurableFile();
+  DurableFile(const DurableFile &) = delete;
+  DurableFile &operator=(const DurableFile &) = delete;
+  ~DurableFile();
+
+  bool open(const string &fileName);
+  /*-------------------------------------------------------------------------
+    Open (or create) a file for appending.
+
+    Preconditions: None.
+    Postconditions: Returns false if the file cannot be opened.
+  -------------------------------------------------------------------------*/
+
+  bool append(const void *data, size_t size);
+  bool sync();
+  bool truncate(uint64_t size);
+  uint64_t size() const;
+  void close();
+  bool isOpen() const { return fd >= 0; }
+  /*-------------------------------------------------------------------------
+    append() writes all bytes at the end of the file; sync() forces them to
+    the disk; truncate() cuts the file to 'size' bytes and syncs.
+
+    Preconditions: The file is open.
+    Postconditions: Return false (after reporting) on an I/O error.
+  -------------------------------------------------------------------------*/
+
+private:
+  int fd;
+  string path;
+};
+
+/******************************************************************************
+ * Class: MappedFile
+ *
+ * Description: Read-only view of a whole file, mapped into memory so that
+ *              opening a large file costs nothing until its pages are
+ *              read. Where mmap is not available the file is read into
+ *              'copy' instead.
+ *
+ * Member Variables:
+ *    - bytes / length: The mapped contents (nullptr / 0 when closed or
+ *      empty).
+ *    - mapped: 'bytes' comes from mmap and must be unmapped.
+ *    - copy: The contents when the file was read rather than mapped.
+ *
+ *****************************************************************************/
+class MappedFile
+{
+public:
+  MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  bool open(const string &fileName);
+  /*-------------------------------------------------------------------------
+    Map the current contents of a file, replacing any previous mapping.
+
+    Preconditions: None.
+    Postconditions: Returns false (after reporting) if the file cannot be
+                    opened or mapped. Bytes appended to the file later are
+                    not visible until it is opened again.
+  -------------------------------------------------------------------------*/
+
+  void close();
+  const char *data() const { return bytes; }
+  size_t size() const { return length; }
+
+private:
+  const char *bytes;
+  size_t length;
+  bool mapped;
+  string copy;
+};
+
+/******************************************************************************
+ * Function: readWholeFile
+ *
+ * Purpose: Read a file into 'contents'.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns false if the file does not exist or cannot be
+ *                 read; 'contents' is then empty.
+ *****************************************************************************/
+bool readWholeFile(const string &fileName, string &contents);
+
+/******************************************************************************
+ * Function: replaceFileDurably
+ *
+ * Purpose: Write 'contents' to a temporary file, sync it, and rename it
+ *          over 'fileName', so that a crash leaves either the old or the
+ *          new file, never a partial one.
+ *
+ * Preconditions: The directory of 'fileName' exists.
+ *
+ * Postconditions: Returns false (after reporting) on an I/O error; the
+ *                 old file is then unchanged.
+ *****************************************************************************/
+bool replaceFileDurably(const string &fileName, const string &contents);
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,103 @@
+#include "EpochManager.h"
+#include <thread>
+
+// Constructor
+EpochManager::EpochManager() : globalEpoch(1)
+{
+  for (atomic<uint64_t> &slot : announced)
+  {
+    slot.store(0);
+  }
+}
+
+// Destructor: free everything still retired
+EpochManager::~EpochManager()
+{
+  for (auto &entry : retired)
+  {
+    entry.second();
+  }
+}
+
+// Pin the current epoch in a free slot
+size_t EpochManager::enter()
+{
+  // Start at a per-thread slot so that readers rarely collide
+  size_t start = hash<thread::id>()(this_thread::get_id()) % SLOTS;
+  for (;;)
+  {
+    uint64_t epoch = globalEpoch.load();
+    for (size_t i = 0; i < SLOTS; ++i)
+    {
+      size_t slot = (start + i) % SLOTS;
+      uint64_t idle = 0;
+      if (announced[slot].compare_exchange_strong(idle, epoch))
+      {
+        return slot;
+      }
+    }
+    this_thread::yield(); // every slot is pinned
+  }
+}
+
+// Unpin a slot
+void EpochManager::exit(size_t slot)
+{
+  announced[slot].store(0);
+}
+
+// Schedule an object to be freed
+void EpochManager::retire(function<void()> release)
+{
+  // Readers that pinned an epoch up to this one may still see the object
+  uint64_t epoch = globalEpoch.fetch_add(1);
+  lock_guard<mutex> guard(retiredLock);
+  retired.emplace_back(epoch, std::move(release));
+}
+
+// Free what no pinned reader can see
+void EpochManager::collect()
+{
+  uint64_t oldestPinned = UINT64_MAX;
+  for (const atomic<uint64_t> &slot : announced)
+  {
+    uint64_t epoch = slot.load();
+    if (epoch != 0 && epoch < oldestPinned)
+    {
+      oldestPinned = epoch;
+    }
+  }
+
+  vector<function<void()>> ready;
+  {
+    lock_guard<mutex> guard(retiredLock);
+    size_t kept = 0;
+    for (auto &entry : retired)
+    {
+      if (entry.first < oldestPinned)
+      {
+        ready.push_back(std::move(entry.second));
+      }
+      else
+      {
+        if (&retired[kept] != &entry)
+        {
+          retired[kept] = std::move(entry);
+        }
+        ++kept;
+      }
+    }
+    retired.resize(kept);
+  }
+  for (auto &release : ready)
+  {
+    release();
+  }
+}
+
+// Number of retired objects not yet freed
+size_t EpochManager::pendingCount()
+{
+  lock_guard<mutex> guard(retiredLock);
+  return retired.size();
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+    Implementation of EpochManager class:
+    enter / exit: Pin and unpin the current epoch for a reader.
+    retire: Hand over an object to free once no reader can still see it.
+    collect: Free the retired objects that no pinned reader can see.
+    pendingCount: Number of retired objects not yet freed.
+ * ****************************************************************************
+ * */
+
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: EpochManager
+ *
+ * Description: Epoch-based reclamation for data published through an
+ *              atomic pointer. A reader announces the global epoch in a
+ *              slot before loading the pointer and clears the slot when
+ *              done; it never touches a reference count. A writer that
+ *              replaces the pointer retires the old object with the epoch
+ *              it was replaced in, and frees it once every announced epoch
+ *              is newer. Neither side waits for the other: a slow reader
+ *              only delays freeing.
+ *
+ * Member Variables:
+ *    - globalEpoch: Advanced by every retire().
+ *    - announced: Epoch pinned by each reader slot; 0 when free.
+ *    - retiredLock: Guards 'retired'.
+ *    - retired: Objects waiting to be freed, with their retire epoch.
+ *
+ *****************************************************************************/
+class EpochManager
+{
+public:
+  static const size_t SLOTS = 128; // readers pinned at the same time
+
+  EpochManager();
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+  ~EpochManager();
+  /*-------------------------------------------------------------------------
+    Free every retired object.
+
+    Preconditions: No reader is pinned.
+    Postconditions: pendingCount() is 0.
+  -------------------------------------------------------------------------*/
+
+  size_t enter();
+  void exit(size_t slot);
+  /*-------------------------------------------------------------------------
+    Pin the current epoch, then load the published pointer; unpin with the
+    slot enter() returned when done with it.
+
+    Preconditions: exit() gets a slot returned by enter() and not yet
+                   exited.
+    Postconditions: Objects retired after enter() are not freed before the
+                    matching exit(). enter() only waits if all SLOTS are
+                    pinned.
+  -------------------------------------------------------------------------*/
+
+  void retire(function<void()> release);
+  /*-------------------------------------------------------------------------
+    Schedule 'release' to run once no pinned reader can see the object.
+
+    Preconditions: The object is no longer reachable through the published
+                   pointer.
+    Postconditions: 'release' runs in a later collect() (or destructor).
+  -------------------------------------------------------------------------*/
+
+  void collect();
+  /*-------------------------------------------------------------------------
+    Free the retired objects older than every pinned reader.
+
+    Preconditions: None.
+    Postconditions: Never waits for readers.
+  -------------------------------------------------------------------------*/
+
+  size_t pendingCount();
+
+private:
+  /***** Member Variables *****/
+  atomic<uint64_t> globalEpoch;                      // advanced by retire
+  atomic<uint64_t> announced[SLOTS];                 // pinned epochs, 0 = free
+  mutex retiredLock;                                 // guards 'retired'
+  vector<pair<uint64_t, function<void()>>> retired; // waiting to be freed
+};
+
+#endif // END OF THE HEADER FILE
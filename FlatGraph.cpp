@@ -0,0 +1,68 @@
+#include "FlatGraph.h"
+#include <algorithm>
+
+// Constructor
+FlatGraph::FlatGraph(UserStore dictionary, vector<uint32_t> offsets,
+                     vector<Vertex> adjacency, vector<int> edgeWeights)
+    : dictionary(std::move(dictionary)), offsets(std::move(offsets)),
+      adjacency(std::move(adjacency)), edgeWeights(std::move(edgeWeights))
+{
+}
+
+// Check whether two vertices are adjacent
+bool FlatGraph::hasEdge(Vertex u, Vertex v) const
+{
+  // Search the shorter of the two slices
+  if (degree(v) < degree(u))
+  {
+    swap(u, v);
+  }
+  return binary_search(neighbors(u), neighbors(u) + degree(u), v);
+}
+
+// Memory of the CSR arrays
+size_t FlatGraph::adjacencyBytes() const
+{
+  return offsets.capacity() * sizeof(uint32_t) +
+         adjacency.capacity() * sizeof(Vertex) +
+         edgeWeights.capacity() * sizeof(int);
+}
+
+// Extract the subgraph induced by a set of vertices
+FlatGraph FlatGraph::inducedSubgraph(vector<Vertex> vertices) const
+{
+  sort(vertices.begin(), vertices.end());
+  vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+
+  // Old ID -> new ID; ascending order keeps the slices sorted
+  vector<Vertex> newId(vertexCount(), NO_VERTEX);
+  UserStore subDictionary;
+  subDictionary.reserve(vertices.size(), 0);
+  for (Vertex v : vertices)
+  {
+    newId[v] = subDictionary.addUser(
+        dictionary.getUserId(v), dictionary.getUserName(v),
+        dictionary.getFirstName(v), dictionary.getLastName(v),
+        dictionary.getEmail(v));
+  }
+
+  vector<uint32_t> subOffsets(vertices.size() + 1, 0);
+  vector<Vertex> subAdjacency;
+  vector<int> subWeights;
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    Vertex v = vertices[i];
+    for (uint32_t j = 0; j < degree(v); ++j)
+    {
+      Vertex u = newId[neighbors(v)[j]];
+      if (u != NO_VERTEX)
+      {
+        subAdjacency.push_back(u);
+        subWeights.push_back(weights(v)[j]);
+      }
+    }
+    subOffsets[i + 1] = static_cast<uint32_t>(subAdjacency.size());
+  }
+  return FlatGraph(std::move(subDictionary), std::move(subOffsets),
+                   std::move(subAdjacency), std::move(subWeights));
+}
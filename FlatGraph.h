@@ -0,0 +1,120 @@
+/******************************************************************************
+    Implementation of FlatGraph class:
+    FlatGraph: Constructor from a vertex dictionary and CSR arrays.
+    vertexCount: Number of vertices.
+    edgeCount: Number of undirected edges.
+    degree: Number of neighbors of a vertex.
+    neighbors / weights: Sorted neighbor IDs of a vertex and their weights.
+    inducedSubgraph: Flat graph of a subset of the vertices.
+    adjacencyBytes: Memory used by the CSR arrays.
+    idOf: Vertex ID of a username.
+    nameOf: Username of a vertex ID.
+    users: The vertex dictionary (a UserStore, row == vertex ID).
+ * ****************************************************************************
+ * */
+
+#ifndef FLATGRAPH_H
+#define FLATGRAPH_H
+
+#include "UserStore.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: FlatGraph
+ *
+ * Description: Immutable compressed-sparse-row copy of a Graph's adjacency.
+ *              Users become dense vertex IDs (rows of a UserStore) and each
+ *              vertex's neighbors are one sorted slice of a flat array, so
+ *              whole-graph algorithms scan contiguous memory and can
+ *              intersect neighbor lists directly.
+ *
+ * Member Variables:
+ *    - dictionary: Username <-> vertex ID, plus the profile columns.
+ *    - offsets: Start of each vertex's slice; offsets[n] == neighborCount.
+ *    - adjacency: Neighbor IDs, sorted within each slice.
+ *    - edgeWeights: Connection weight of each adjacency entry.
+ *
+ *****************************************************************************/
+class FlatGraph
+{
+public:
+  typedef uint32_t Vertex;
+  static constexpr Vertex NO_VERTEX = UserStore::NO_ROW;
+
+  /***** Constructors *****/
+  FlatGraph(UserStore dictionary, vector<uint32_t> offsets,
+            vector<Vertex> adjacency, vector<int> edgeWeights);
+  /*-------------------------------------------------------------------------
+    Construct a flat graph from prepared CSR arrays.
+
+    Preconditions: 'dictionary' has no removed rows, 'offsets' has
+    dictionary.rowCount() + 1 entries, each slice of 'adjacency' is sorted
+    without duplicates and 'edgeWeights' is aligned with 'adjacency'.
+    Postconditions: The flat graph owns the arrays.
+  -------------------------------------------------------------------------*/
+
+  /***** Graph Information *****/
+  size_t vertexCount() const { return offsets.size() - 1; }
+  size_t edgeCount() const { return adjacency.size() / 2; }
+  uint32_t degree(Vertex v) const { return offsets[v + 1] - offsets[v]; }
+
+  const Vertex *neighbors(Vertex v) const
+  {
+    return adjacency.data() + offsets[v];
+  }
+  const int *weights(Vertex v) const { return edgeWeights.data() + offsets[v]; }
+  /*-------------------------------------------------------------------------
+    Access the neighbor slice of a vertex; it holds degree(v) entries.
+
+    Preconditions: 'v' is less than vertexCount().
+    Postconditions: Returns a pointer into the flat arrays.
+  -------------------------------------------------------------------------*/
+
+  const vector<uint32_t> &offsetArray() const { return offsets; }
+  const vector<Vertex> &adjacencyArray() const { return adjacency; }
+  const vector<int> &weightArray() const { return edgeWeights; }
+
+  bool hasEdge(Vertex u, Vertex v) const;
+  /*-------------------------------------------------------------------------
+    Check whether two vertices are adjacent (binary search).
+
+    Preconditions: 'u' and 'v' are less than vertexCount().
+    Postconditions: Returns true if the edge exists.
+  -------------------------------------------------------------------------*/
+
+  FlatGraph inducedSubgraph(vector<Vertex> vertices) const;
+  /*-------------------------------------------------------------------------
+    Extract the vertices and the edges between them.
+
+    Preconditions: Every entry of 'vertices' is less than vertexCount().
+    Postconditions: Returns a new flat graph; the kept vertices are
+                    renumbered in increasing order of their old IDs and
+                    duplicates are ignored.
+  -------------------------------------------------------------------------*/
+
+  size_t adjacencyBytes() const;
+  /*-------------------------------------------------------------------------
+    Report the memory of the offsets, adjacency and weight arrays.
+
+    Preconditions: None.
+    Postconditions: Returns the size in bytes, excluding the dictionary.
+  -------------------------------------------------------------------------*/
+
+  /***** Dictionary *****/
+  Vertex idOf(string_view userName) const { return dictionary.findRow(userName); }
+  string_view nameOf(Vertex v) const { return dictionary.getUserName(v); }
+  const UserStore &users() const { return dictionary; }
+
+private:
+  /***** Member Variables *****/
+  UserStore dictionary;     // username <-> vertex ID
+  vector<uint32_t> offsets; // slice start per vertex
+  vector<Vertex> adjacency; // sorted neighbor IDs
+  vector<int> edgeWeights;  // weight per adjacency entry
+};
+
+#endif // END OF THE HEADER FILE
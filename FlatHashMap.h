@@ -0,0 +1,512 @@
+/******************************************************************************
+    Implementation of FlatHashMap class template:
+    find: Look up a key (accepts string_view, no temporary string needed).
+    operator[]: Look up a key, inserting a default value if it is missing.
+    tryEmplace: Insert a key/value pair if the key is not present.
+    erase: Remove a key or the entry an iterator points at.
+    reserve: Grow the table ahead of a bulk insert.
+    clear: Remove every entry.
+    begin / end: Iterate the stored (key, value) pairs.
+ * ****************************************************************************
+ * */
+
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLATHASHMAP_SSE2 1
+#endif
+
+using namespace std;
+
+/******************************************************************************
+ * Class: FlatHashMap
+ *
+ * Description: Open-addressing hash table keyed by strings, laid out in the
+ *              style of a Swiss table. Every slot has one control byte that
+ *              is either EMPTY, DELETED or the low 7 bits of the key's hash.
+ *              A lookup loads a group of 16 control bytes and compares them
+ *              all at once (SSE2 when available), so most probes touch a
+ *              single cache line of metadata before any key is compared.
+ *
+ * Member Variables:
+ *    - ctrl: Control bytes, one per slot.
+ *    - hashes: Full hash of the key stored in each slot, kept so that a
+ *              rehash never has to hash the strings again.
+ *    - slots: Uninitialised storage for the (key, value) pairs.
+ *    - capacity: Number of slots (a power of two, multiple of 16).
+ *    - count: Number of live entries.
+ *    - tombstones: Number of DELETED control bytes.
+ *
+ *****************************************************************************/
+template <typename Value>
+class FlatHashMap
+{
+public:
+  typedef pair<string, Value> value_type;
+
+  /***** Iterator *****/
+  template <bool IsConst>
+  class BasicIterator
+  {
+  public:
+    typedef typename conditional<IsConst, const FlatHashMap,
+                                 FlatHashMap>::type map_type;
+    typedef typename conditional<IsConst, const value_type,
+                                 value_type>::type entry_type;
+
+    BasicIterator() : map(nullptr), index(0) {}
+    BasicIterator(map_type *map, size_t index) : map(map), index(index)
+    {
+      skipEmpty();
+    }
+    // Allow iterator -> const_iterator conversion
+    BasicIterator(const BasicIterator<false> &other)
+        : map(other.map), index(other.index) {}
+
+    entry_type &operator*() const { return map->slots[index]; }
+    entry_type *operator->() const { return &map->slots[index]; }
+
+    BasicIterator &operator++()
+    {
+      ++index;
+      skipEmpty();
+      return *this;
+    }
+
+    bool operator==(const BasicIterator &other) const
+    {
+      return index == other.index;
+    }
+    bool operator!=(const BasicIterator &other) const
+    {
+      return index != other.index;
+    }
+
+    // Precomputed hash of the entry's key
+    size_t hash() const { return map->hashes[index]; }
+
+  private:
+    friend class FlatHashMap;
+    friend class BasicIterator<!IsConst>;
+
+    void skipEmpty()
+    {
+      while (index < map->capacity && map->ctrl[index] < 0)
+      {
+        ++index;
+      }
+    }
+
+    map_type *map;
+    size_t index;
+  };
+
+  typedef BasicIterator<false> iterator;
+  typedef BasicIterator<true> const_iterator;
+
+  /***** Constructors and Destructor *****/
+  FlatHashMap() : slots(nullptr), capacity(0), count(0), tombstones(0) {}
+  /*-------------------------------------------------------------------------
+    Constructs an empty map. No memory is allocated until the first insert.
+
+    Preconditions: None.
+    Postconditions: An empty map is created.
+  -------------------------------------------------------------------------*/
+
+  FlatHashMap(const FlatHashMap &other)
+      : slots(nullptr), capacity(0), count(0), tombstones(0)
+  {
+    reserve(other.count);
+    for (const_iterator it = other.begin(); it != other.end(); ++it)
+    {
+      insertUnique(it.hash(), value_type(*it));
+    }
+  }
+
+  FlatHashMap(FlatHashMap &&other) noexcept
+      : ctrl(std::move(other.ctrl)), hashes(std::move(other.hashes)),
+        slots(other.slots), capacity(other.capacity), count(other.count),
+        tombstones(other.tombstones)
+  {
+    other.slots = nullptr;
+    other.capacity = other.count = other.tombstones = 0;
+  }
+
+  FlatHashMap &operator=(FlatHashMap other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  ~FlatHashMap() { destroyAll(); }
+
+  void swap(FlatHashMap &other) noexcept
+  {
+    ctrl.swap(other.ctrl);
+    hashes.swap(other.hashes);
+    std::swap(slots, other.slots);
+    std::swap(capacity, other.capacity);
+    std::swap(count, other.count);
+    std::swap(tombstones, other.tombstones);
+  }
+
+  /***** Capacity *****/
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  void reserve(size_t n)
+  /*-------------------------------------------------------------------------
+    Make room for 'n' entries without further rehashing.
+
+    Preconditions: None.
+    Postconditions: The table can hold 'n' entries under the maximum load.
+  -------------------------------------------------------------------------*/
+  {
+    size_t needed = GROUP_WIDTH;
+    while (needed * 7 / 8 < n)
+    {
+      needed *= 2;
+    }
+    if (needed > capacity)
+    {
+      rehash(needed);
+    }
+  }
+
+  /***** Lookup *****/
+  iterator find(string_view key) { return iterator(this, findIndex(key)); }
+  const_iterator find(string_view key) const
+  {
+    return const_iterator(this, findIndex(key));
+  }
+  /*-------------------------------------------------------------------------
+    Find the entry for 'key'. 'key' can be a string, a string_view or a
+    string literal; no temporary string is built.
+
+    Preconditions: None.
+    Postconditions: Returns an iterator to the entry, or end() if not found.
+  -------------------------------------------------------------------------*/
+
+  bool contains(string_view key) const { return findIndex(key) != capacity; }
+
+  // Look up 'key' and return a pointer to its value, or nullptr
+  Value *get(string_view key)
+  {
+    size_t index = findIndex(key);
+    return index == capacity ? nullptr : &slots[index].second;
+  }
+  const Value *get(string_view key) const
+  {
+    size_t index = findIndex(key);
+    return index == capacity ? nullptr : &slots[index].second;
+  }
+
+  /***** Modifiers *****/
+  template <typename... Args>
+  pair<iterator, bool> tryEmplace(string_view key, Args &&...args)
+  /*-------------------------------------------------------------------------
+    Insert 'key' with a value constructed from 'args' if it is absent.
+
+    Preconditions: None.
+    Postconditions: Returns the entry and whether it was newly inserted.
+                    The key is hashed exactly once.
+  -------------------------------------------------------------------------*/
+  {
+    size_t h = hashKey(key);
+    size_t index = findIndex(key, h);
+    if (index != capacity)
+    {
+      return make_pair(iterator(this, index), false);
+    }
+    index = insertUnique(h, value_type(piecewise_construct,
+                                       forward_as_tuple(key),
+                                       forward_as_tuple(
+                                           std::forward<Args>(args)...)));
+    return make_pair(iterator(this, index), true);
+  }
+
+  Value &operator[](string_view key) { return tryEmplace(key).first->second; }
+
+  bool erase(string_view key)
+  /*-------------------------------------------------------------------------
+    Remove 'key' from the map.
+
+    Preconditions: None.
+    Postconditions: Returns true if an entry was removed.
+  -------------------------------------------------------------------------*/
+  {
+    size_t index = findIndex(key);
+    if (index == capacity)
+    {
+      return false;
+    }
+    eraseAt(index);
+    return true;
+  }
+
+  iterator erase(iterator position)
+  {
+    size_t index = position.index;
+    eraseAt(index);
+    return iterator(this, index + 1);
+  }
+
+  void clear()
+  /*-------------------------------------------------------------------------
+    Remove every entry, keeping the allocated capacity.
+
+    Preconditions: None.
+    Postconditions: The map is empty.
+  -------------------------------------------------------------------------*/
+  {
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      if (ctrl[i] >= 0)
+      {
+        slots[i].~value_type();
+      }
+      ctrl[i] = EMPTY;
+    }
+    count = 0;
+    tombstones = 0;
+  }
+
+  /***** Iteration *****/
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, capacity); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, capacity); }
+
+  static size_t hashKey(string_view key) { return hash<string_view>()(key); }
+
+private:
+  static constexpr size_t GROUP_WIDTH = 16;
+  static constexpr int8_t EMPTY = -128; // 0b10000000
+  static constexpr int8_t DELETED = -2; // 0b11111110
+
+  static size_t h1(size_t h) { return h >> 7; }
+  static int8_t h2(size_t h) { return static_cast<int8_t>(h & 0x7F); }
+
+  // Bitmask of the bytes in the group at 'pos' equal to 'value'
+  uint32_t matchByte(size_t pos, int8_t value) const
+  {
+#ifdef FLATHASHMAP_SSE2
+    __m128i group =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ctrl[pos]));
+    __m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8(value));
+    return static_cast<uint32_t>(_mm_movemask_epi8(match));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; ++i)
+    {
+      if (ctrl[pos + i] == value)
+      {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+#endif
+  }
+
+  // Bitmask of the bytes in the group at 'pos' that are EMPTY or DELETED
+  uint32_t matchFree(size_t pos) const
+  {
+#ifdef FLATHASHMAP_SSE2
+    __m128i group =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(&ctrl[pos]));
+    // Free control bytes have their sign bit set
+    return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; ++i)
+    {
+      if (ctrl[pos + i] < 0)
+      {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+#endif
+  }
+
+  static unsigned lowestBit(uint32_t mask)
+  {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned bit = 0;
+    while (!(mask & 1u))
+    {
+      mask >>= 1;
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+
+  size_t findIndex(string_view key) const
+  {
+    return capacity == 0 ? capacity : findIndex(key, hashKey(key));
+  }
+
+  // Probe group by group (triangular sequence) until the key or an EMPTY
+  // control byte is found
+  size_t findIndex(string_view key, size_t h) const
+  {
+    if (capacity == 0)
+    {
+      return capacity;
+    }
+    size_t groups = capacity / GROUP_WIDTH;
+    size_t group = h1(h) & (groups - 1);
+    int8_t tag = h2(h);
+    for (size_t step = 1; step <= groups; ++step)
+    {
+      size_t pos = group * GROUP_WIDTH;
+      uint32_t mask = matchByte(pos, tag);
+      while (mask)
+      {
+        size_t index = pos + lowestBit(mask);
+        if (hashes[index] == h && slots[index].first == key)
+        {
+          return index;
+        }
+        mask &= mask - 1;
+      }
+      if (matchByte(pos, EMPTY))
+      {
+        return capacity;
+      }
+      group = (group + step) & (groups - 1);
+    }
+    return capacity;
+  }
+
+  // Place an entry whose key is known to be absent
+  size_t insertUnique(size_t h, value_type &&entry)
+  {
+    if (capacity == 0 || (count + tombstones + 1) > capacity * 7 / 8)
+    {
+      // Rehash in place when mostly tombstones, otherwise grow
+      size_t target = capacity == 0 ? GROUP_WIDTH : capacity;
+      if (count + 1 > target * 7 / 16)
+      {
+        target *= 2;
+      }
+      rehash(target);
+    }
+    size_t index = findFree(h);
+    if (ctrl[index] == DELETED)
+    {
+      --tombstones;
+    }
+    new (&slots[index]) value_type(std::move(entry));
+    ctrl[index] = h2(h);
+    hashes[index] = h;
+    ++count;
+    return index;
+  }
+
+  size_t findFree(size_t h) const
+  {
+    size_t groups = capacity / GROUP_WIDTH;
+    size_t group = h1(h) & (groups - 1);
+    for (size_t step = 1;; ++step)
+    {
+      size_t pos = group * GROUP_WIDTH;
+      uint32_t mask = matchFree(pos);
+      if (mask)
+      {
+        return pos + lowestBit(mask);
+      }
+      group = (group + step) & (groups - 1);
+    }
+  }
+
+  void eraseAt(size_t index)
+  {
+    slots[index].~value_type();
+    // A slot in a group that still has an EMPTY byte can never be on the
+    // probe path of another key, so it can go straight back to EMPTY
+    size_t pos = index - index % GROUP_WIDTH;
+    if (matchByte(pos, EMPTY))
+    {
+      ctrl[index] = EMPTY;
+    }
+    else
+    {
+      ctrl[index] = DELETED;
+      ++tombstones;
+    }
+    --count;
+  }
+
+  void rehash(size_t newCapacity)
+  {
+    vector<int8_t> oldCtrl;
+    oldCtrl.swap(ctrl);
+    vector<size_t> oldHashes;
+    oldHashes.swap(hashes);
+    value_type *oldSlots = slots;
+    size_t oldCapacity = capacity;
+
+    ctrl.assign(newCapacity, EMPTY);
+    hashes.assign(newCapacity, 0);
+    slots = static_cast<value_type *>(
+        ::operator new(newCapacity * sizeof(value_type)));
+    capacity = newCapacity;
+    tombstones = 0;
+
+    for (size_t i = 0; i < oldCapacity; ++i)
+    {
+      if (oldCtrl[i] >= 0)
+      {
+        size_t index = findFree(oldHashes[i]);
+        new (&slots[index]) value_type(std::move(oldSlots[i]));
+        ctrl[index] = h2(oldHashes[i]);
+        hashes[index] = oldHashes[i];
+        oldSlots[i].~value_type();
+      }
+    }
+    ::operator delete(oldSlots);
+  }
+
+  void destroyAll()
+  {
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      if (ctrl[i] >= 0)
+      {
+        slots[i].~value_type();
+      }
+    }
+    ::operator delete(slots);
+    slots = nullptr;
+    capacity = count = tombstones = 0;
+    ctrl.clear();
+    hashes.clear();
+  }
+
+  /***** Member Variables *****/
+  vector<int8_t> ctrl;  // control byte per slot
+  vector<size_t> hashes; // precomputed hash per slot
+  value_type *slots;     // (key, value) storage
+  size_t capacity;       // number of slots
+  size_t count;          // live entries
+  size_t tombstones;     // DELETED control bytes
+};
+
+#endif // END OF THE HEADER FILE
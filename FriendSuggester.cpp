@@ -0,0 +1,187 @@
+#include "FriendSuggester.h"
+#include "Parallel.h"
+#include "SetOps.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+// Constructor
+FriendSuggester::FriendSuggester(const FlatGraph &graph,
+                                 SuggestionScore scoring, uint32_t hubDegree)
+    : graph(graph), scoring(scoring), hubDegree(hubDegree),
+      partial(graph.vertexCount(), 0.0)
+{
+}
+
+// Top-k suggestions for one user
+vector<FriendSuggestion> FriendSuggester::suggest(FlatGraph::Vertex user,
+                                                  size_t k)
+{
+  typedef FlatGraph::Vertex Vertex;
+  const Vertex *friends = graph.neighbors(user);
+  uint32_t degree = graph.degree(user);
+
+  // Mark the user and its friends so they are never suggested
+  partial[user] = -1.0;
+  touched.push_back(user);
+  for (uint32_t i = 0; i < degree; ++i)
+  {
+    partial[friends[i]] = -1.0;
+    touched.push_back(friends[i]);
+  }
+
+  // First pass: walk the two-hop neighborhood
+  size_t firstCandidate = touched.size();
+  for (uint32_t i = 0; i < degree; ++i)
+  {
+    Vertex middle = friends[i];
+    uint32_t middleDegree = graph.degree(middle);
+    if (hubDegree != 0 && middleDegree > hubDegree)
+    {
+      continue;
+    }
+    double contribution = (scoring == SuggestionScore::ADAMIC_ADAR)
+                              ? 1.0 / log(static_cast<double>(middleDegree))
+                              : 1.0;
+    const Vertex *twoHop = graph.neighbors(middle);
+    for (uint32_t j = 0; j < middleDegree; ++j)
+    {
+      double &score = partial[twoHop[j]];
+      if (score < 0.0)
+      {
+        continue;
+      }
+      if (score == 0.0)
+      {
+        touched.push_back(twoHop[j]);
+      }
+      score += contribution;
+    }
+  }
+
+  // Keep the best candidates of the first pass
+  vector<Vertex> candidates(touched.begin() + firstCandidate, touched.end());
+  if (scoring == SuggestionScore::JACCARD)
+  {
+    // Rank by the (partial) Jaccard score rather than the raw count
+    for (Vertex candidate : candidates)
+    {
+      double mutual = partial[candidate];
+      partial[candidate] = mutual / (degree + graph.degree(candidate) - mutual);
+    }
+  }
+  size_t pool = max<size_t>(4 * k, k + 16);
+  if (candidates.size() > pool)
+  {
+    nth_element(candidates.begin(), candidates.begin() + pool,
+                candidates.end(), [this](Vertex a, Vertex b) {
+                  return partial[a] > partial[b];
+                });
+    candidates.resize(pool);
+  }
+
+  // Second pass: exact scores, top-k through a min-heap
+  auto worse = [](const FriendSuggestion &a, const FriendSuggestion &b) {
+    return a.score != b.score ? a.score > b.score : a.user < b.user;
+  };
+  priority_queue<FriendSuggestion, vector<FriendSuggestion>, decltype(worse)>
+      heap(worse);
+  for (Vertex candidate : candidates)
+  {
+    FriendSuggestion suggestion;
+    suggestion.user = candidate;
+    suggestion.score = exactScore(user, candidate, suggestion.mutualFriends);
+    heap.push(suggestion);
+    if (heap.size() > k)
+    {
+      heap.pop();
+    }
+  }
+
+  // Reset the scratch array for the next query
+  for (Vertex v : touched)
+  {
+    partial[v] = 0.0;
+  }
+  touched.clear();
+
+  vector<FriendSuggestion> result;
+  while (!heap.empty())
+  {
+    result.push_back(heap.top());
+    heap.pop();
+  }
+  reverse(result.begin(), result.end());
+  return result;
+}
+
+// Exact score of one candidate from the intersection of the friend lists
+double FriendSuggester::exactScore(FlatGraph::Vertex user,
+                                   FlatGraph::Vertex candidate,
+                                   uint32_t &mutualFriends)
+{
+  uint32_t du = graph.degree(user), dc = graph.degree(candidate);
+  common.resize(min(du, dc));
+  mutualFriends = static_cast<uint32_t>(
+      intersectSorted(graph.neighbors(user), du, graph.neighbors(candidate),
+                      dc, common.data()));
+  switch (scoring)
+  {
+  case SuggestionScore::ADAMIC_ADAR:
+  {
+    double score = 0.0;
+    for (uint32_t i = 0; i < mutualFriends; ++i)
+    {
+      score += 1.0 / log(static_cast<double>(graph.degree(common[i])));
+    }
+    return score;
+  }
+  case SuggestionScore::JACCARD:
+    return static_cast<double>(mutualFriends) / (du + dc - mutualFriends);
+  default:
+    return mutualFriends;
+  }
+}
+
+// Suggestions for every user, streamed in vertex order
+size_t FriendSuggester::suggestForAll(const FlatGraph &graph, size_t k,
+                                      SuggestionScore scoring,
+                                      uint32_t hubDegree, ostream &out)
+{
+  const size_t BLOCK = 4096;
+  size_t n = graph.vertexCount();
+
+  // One suggester (and scratch array) per worker
+  vector<FriendSuggester> suggesters;
+  for (unsigned i = 0; i < workerCount(); ++i)
+  {
+    suggesters.emplace_back(graph, scoring, hubDegree);
+  }
+
+  vector<vector<FriendSuggestion>> results(BLOCK);
+  for (size_t blockBegin = 0; blockBegin < n; blockBegin += BLOCK)
+  {
+    size_t blockEnd = min(n, blockBegin + BLOCK);
+    parallelFor(blockBegin, blockEnd, 16,
+                [&](size_t lo, size_t hi, unsigned worker) {
+                  for (size_t v = lo; v < hi; ++v)
+                  {
+                    results[v - blockBegin] = suggesters[worker].suggest(
+                        static_cast<FlatGraph::Vertex>(v), k);
+                  }
+                });
+
+    // Write the finished block before computing the next one
+    for (size_t v = blockBegin; v < blockEnd; ++v)
+    {
+      out << graph.nameOf(static_cast<FlatGraph::Vertex>(v)) << ":";
+      for (const FriendSuggestion &suggestion : results[v - blockBegin])
+      {
+        out << " " << graph.nameOf(suggestion.user) << "("
+            << suggestion.score << ")";
+      }
+      out << "\n";
+    }
+  }
+  return n;
+}
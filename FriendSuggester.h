@@ -0,0 +1,105 @@
+/******************************************************************************
+    Implementation of FriendSuggester class:
+    FriendSuggester: Constructor binding a flat graph and a scoring method.
+    suggest: Top-k "people you may know" for one user.
+    suggestForAll: Suggestions for every user, computed in parallel and
+     streamed to an output stream.
+ * ****************************************************************************
+ * */
+
+#ifndef FRIENDSUGGESTER_H
+#define FRIENDSUGGESTER_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// How two-hop candidates are ranked
+enum class SuggestionScore
+{
+  MUTUAL_FRIENDS, // number of mutual friends
+  ADAMIC_ADAR,    // mutual friends weighted by 1 / log(their degree)
+  JACCARD         // mutual friends / union of both friend lists
+};
+
+struct FriendSuggestion
+{
+  FlatGraph::Vertex user; // suggested user
+  double score;           // score under the chosen method
+  uint32_t mutualFriends; // number of mutual friends
+};
+
+/******************************************************************************
+ * Class: FriendSuggester
+ *
+ * Description: Scores friends-of-friends of a user. A first pass walks the
+ *              two-hop neighborhood accumulating approximate scores in a
+ *              dense per-vertex array (optionally not expanding through hub
+ *              users whose degree exceeds 'hubDegree'); the best candidates
+ *              are then rescored exactly by intersecting sorted neighbor
+ *              arrays (SetOps), and a size-k heap keeps the top results.
+ *              One instance holds scratch buffers sized to the graph, so
+ *              use one instance per thread.
+ *
+ * Member Variables:
+ *    - graph: The flat graph being queried.
+ *    - scoring: Ranking method.
+ *    - hubDegree: Intermediaries above this degree are not expanded in
+ *                 the first pass (0 = expand all).
+ *    - partial: Approximate score per vertex (negative marks a friend).
+ *    - touched: Vertices whose 'partial' entry must be reset.
+ *    - common: Scratch buffer for exact intersections.
+ *
+ *****************************************************************************/
+class FriendSuggester
+{
+public:
+  /***** Constructors *****/
+  FriendSuggester(const FlatGraph &graph,
+                  SuggestionScore scoring = SuggestionScore::MUTUAL_FRIENDS,
+                  uint32_t hubDegree = 0);
+  /*-------------------------------------------------------------------------
+    Bind a suggester to a flat graph.
+
+    Preconditions: 'graph' outlives the suggester.
+    Postconditions: Scratch buffers are sized to the graph.
+  -------------------------------------------------------------------------*/
+
+  /***** Queries *****/
+  vector<FriendSuggestion> suggest(FlatGraph::Vertex user, size_t k);
+  /*-------------------------------------------------------------------------
+    Suggest up to 'k' users who are not yet friends of 'user'.
+
+    Preconditions: 'user' is less than graph.vertexCount().
+    Postconditions: Returns the suggestions, best first (ties by vertex ID).
+  -------------------------------------------------------------------------*/
+
+  static size_t suggestForAll(const FlatGraph &graph, size_t k,
+                              SuggestionScore scoring, uint32_t hubDegree,
+                              ostream &out);
+  /*-------------------------------------------------------------------------
+    Compute suggestions for every user in parallel, block by block, and
+    stream them in vertex order as lines of the form
+      user: candidate(score) candidate(score) ...
+
+    Preconditions: 'out' is writable.
+    Postconditions: Returns the number of lines written.
+  -------------------------------------------------------------------------*/
+
+private:
+  double exactScore(FlatGraph::Vertex user, FlatGraph::Vertex candidate,
+                    uint32_t &mutualFriends);
+
+  /***** Member Variables *****/
+  const FlatGraph &graph;            // graph being queried
+  SuggestionScore scoring;           // ranking method
+  uint32_t hubDegree;                // expansion cutoff (0 = none)
+  vector<double> partial;            // approximate score per vertex
+  vector<FlatGraph::Vertex> touched; // entries of 'partial' to reset
+  vector<FlatGraph::Vertex> common;  // intersection scratch
+};
+
+#endif // END OF THE HEADER FILE
@@ -1,100 +1,191 @@
 #include "Graph.h"
 #include "Connection.h"
+#include "Parallel.h"
+#include "SetOps.h"
 #include "UserProfile.h"
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <limits>
 #include <unordered_map>
 #include <unordered_set>
 
-// Default constructor
-Graph::Graph() {}
+// Constructor
+Graph::Graph(bool threadSafe)
+    : graphLock(threadSafe), componentsStale(false), adjacencyEntries(0),
+      totalWeight(0), maxDegree(0), version(0), flatCacheVersion(0),
+      compressedCacheVersion(0), mutationDepth(0), batchDepth(0),
+      rebuildVersion(false), dirtyBlocks(GraphVersion::BLOCKS, false)
+{
+}
 
 // Destructor to clean up dynamically allocated memory
 Graph::~Graph()
 {
+  // Save and close the storage; the teardown below is not a mutation to log
+  closeStorage();
+
   // Clear the adjacency list
   clearGraph();
 
   // Delete user profiles
-  for (auto &user : users)
-  {
-    delete user.second;
-  }
-  users.clear();
+  clearUsers();
 }
 
 // Function to add a user to the graph
 bool Graph::addUser(UserProfile *user)
 {
-  if (user == nullptr)
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
+  if (user == nullptr || users.contains(user->getUserName()))
   {
     return false;
   }
 
-  string username = user->getUserName();
-  if (users.find(username) == users.end())
+  // The email index rejects an email that is already registered
+  if (!index.addUser(user))
   {
-    users[username] = user;
-    return true;
+    return false;
   }
-  return false;
+  users.tryEmplace(user->getUserName(), user);
+  fuzzyIndex.addUser(user);
+  componentIds[user->getUserName()] = components.add();
+  user->setListener(this);
+  dirtyUsers.push_back(user->getUserName());
+  if (degreeCounts.empty())
+  {
+    degreeCounts.push_back(0);
+  }
+  ++degreeCounts[0];
+  ++version;
+  logMutation(LogOp::AddUser, {user->getUserName(), user->getFirstName(),
+                               user->getLastName(), user->getEmail()});
+  return true;
 }
 
 // Function to add an edge/connection between user1 and user2
 bool Graph::addConnection(Connection *connection)
 {
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
   // Check if the connection is valid
   if (connection != nullptr)
   {
     string user1 = connection->getSource()->getUserName();
     string user2 = connection->getDestination()->getUserName();
-    // Check if the users are already connected
-    if (!isConnected(user1, user2))
+    // Check if the users are already connected; a self-loop would be
+    // listed twice in one adjacency list, which removals do not expect
+    if (user1 != user2 && !isConnected(user1, user2))
     {
-      // Add the connection to the adjacency list (undirected graph)
-      adj[user1].push_back(connection);
-      adj[user2].push_back(
-          new Connection(users[user2], users[user1], connection->getWeight()));
+      linkUsers(connection);
+      logMutation(LogOp::AddConnection, {user1, user2},
+                  connection->getWeight());
       return true;
     }
   }
 
   return false;
 }
+
+// Function to store a connection in both adjacency lists
+void Graph::linkUsers(Connection *connection)
+{
+  const string &user1 = connection->getSource()->getUserName();
+  const string &user2 = connection->getDestination()->getUserName();
+  // Add the connection to the adjacency list (undirected graph)
+  list<Connection *> &list1 = adj[user1];
+  list1.push_back(connection);
+  degreeChanged(user1, list1.size() - 1, list1.size());
+  list<Connection *> &list2 = adj[user2];
+  list2.push_back(new Connection(connection->getDestination(),
+                                 connection->getSource(),
+                                 connection->getWeight()));
+  degreeChanged(user2, list2.size() - 1, list2.size());
+  neighborLists[user1].push_back(
+      GraphVersion::Neighbor{user2, connection->getWeight()});
+  neighborLists[user2].push_back(
+      GraphVersion::Neighbor{user1, connection->getWeight()});
+  adjacencyEntries += 2;
+  totalWeight += connection->getWeight();
+  dirtyUsers.push_back(user1);
+  dirtyUsers.push_back(user2);
+  // Merging components is incremental; only removals need a rebuild
+  const uint32_t *id1 = componentIds.get(user1);
+  const uint32_t *id2 = componentIds.get(user2);
+  if (id1 != nullptr && id2 != nullptr)
+  {
+    components.unite(*id1, *id2);
+  }
+  ++version;
+}
+
 // Function to delete all connections of a user
 void Graph::deleteConnectionsOfUser(const string &username)
 {
-  if (adj.find(username) != adj.end())
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
+  auto entry = adj.find(username);
+  if (entry != adj.end())
   {
-    for (auto connection : adj[username])
+    for (auto connection : entry->second)
     {
-      string dest = connection->getDestination()->getUserName();
-      adj[dest].remove(connection);
+      // Remove the mirrored connection from the neighbor's list
+      const string &neighborName = connection->getDestination()->getUserName();
+      auto neighbor = adj.find(neighborName);
+      if (neighbor != adj.end())
+      {
+        size_t before = neighbor->second.size();
+        neighbor->second.remove_if([&username](Connection *mirror) {
+          if (mirror->getDestination()->getUserName() == username)
+          {
+            delete mirror;
+            return true;
+          }
+          return false;
+        });
+        degreeChanged(neighborName, before, neighbor->second.size());
+        adjacencyEntries -= before - neighbor->second.size();
+        neighborLists.get(neighborName)->erase(username);
+        dirtyUsers.push_back(neighborName);
+      }
+      totalWeight -= connection->getWeight();
       delete connection;
     }
-    adj[username].clear();
-
-    // Remove any connections pointing to the user
-    for (auto &entry : adj)
-    {
-      entry.second.remove_if([username](Connection *connection) {
-        return connection->getDestination()->getUserName() == username;
-      });
-    }
+    degreeChanged(username, entry->second.size(), 0);
+    adjacencyEntries -= entry->second.size();
+    entry->second.clear();
+    neighborLists.erase(username);
+    dirtyUsers.push_back(username);
+    componentsStale = true;
+    ++version;
+    logMutation(LogOp::DeleteConnections, {username});
   }
 }
 
 // Function to remove a user from the graph
 bool Graph::removeUser(const string &username)
 {
-  if (users.find(username) != users.end())
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
+  auto user = users.find(username);
+  if (user != users.end())
   {
     // Delete all connections of the user
     deleteConnectionsOfUser(username);
+    adj.erase(username);
+    index.removeUser(user->second);
+    fuzzyIndex.removeUser(user->second);
     // Delete the user profile
-    delete users[username];
-    users.erase(username);
+    delete user->second;
+    users.erase(user);
+    componentIds.erase(username);
+    vertexRank.erase(username);
+    --degreeCounts[0]; // its connections are gone: degree 0
+    dirtyUsers.push_back(username);
+    componentsStale = true;
+    ++version;
+    logMutation(LogOp::RemoveUser, {username});
     return true;
   }
   return false;
@@ -103,71 +194,238 @@ bool Graph::removeUser(const string &username)
 // Function to remove an edge/connection between user1 and user2
 bool Graph::removeConnection(const string &src, const string &dest)
 {
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
   // Check if the source user and destination exist in the graph
-  if (adj.find(src) != adj.end())
+  auto srcEntry = adj.find(src);
+  auto destEntry = adj.find(dest);
+  if (srcEntry == adj.end() || destEntry == adj.end())
+  {
+    return false;
+  }
+
+  // Remove the connection from both adjacency lists
+  bool removed = false;
+  for (auto *entry : {&srcEntry->second, &destEntry->second})
   {
-    // Iterate through the connections of the source user
-    for (auto connection : adj[src])
+    bool fromSource = entry == &srcEntry->second;
+    const string &other = fromSource ? dest : src;
+    for (auto it = entry->begin(); it != entry->end(); ++it)
     {
-      // Check if the destination user is connected to the source user
-      if (connection->getDestination()->getUserName() == dest)
+      if ((*it)->getDestination()->getUserName() == other)
       {
-        // Remove the connection from the adjacency list
-        adj[src].remove(connection);
-        // adj[dest].remove(connection);
-        delete connection;
-        for(auto connection2 : adj[dest]){
-          if(connection2->getDestination()->getUserName() == src){
-            adj[dest].remove(connection2);
-            delete connection2;
-            return true;
-          }
+        if (fromSource)
+        {
+          totalWeight -= (*it)->getWeight();
         }
+        delete *it;
+        entry->erase(it);
+        neighborLists.get(fromSource ? src : dest)->erase(other);
+        degreeChanged(fromSource ? src : dest, entry->size() + 1,
+                      entry->size());
+        --adjacencyEntries;
+        removed = true;
+        break;
       }
     }
   }
-  return false;
+  if (removed)
+  {
+    dirtyUsers.push_back(src);
+    dirtyUsers.push_back(dest);
+    componentsStale = true;
+    ++version;
+    logMutation(LogOp::RemoveConnection, {src, dest});
+  }
+  return removed;
 }
 
 bool Graph::isUserNameTaken(const string &userName)
 {
-  if (users.find(userName) != users.end())
-  {
-    return true;
-  }
-  return false;
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return users.contains(userName);
 }
 
 void Graph::displayUserInfo(const string &userName)
 {
-  // Check if the user exists in the graph
-  if (users.find(userName) != users.end())
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  // Check if the user exists in the graph and retrieve the profile
+  auto user = users.find(userName);
+  if (user != users.end())
   {
-    // Retrieve the user profile
-    UserProfile *user = users[userName];
-
     // Display user information using the UserProfile function
-    cout << user->displayUserInfo() << endl;
+    cout << user->second->displayUserInfo() << endl;
   }
   else
   {
     cout << "User '" << userName << "' not found." << endl;
+
+    // Offer close matches for a misspelled name
+    vector<UserProfile *> suggestions = suggestUsers(userName, 3);
+    if (!suggestions.empty())
+    {
+      cout << "Did you mean: ";
+      for (size_t i = 0; i < suggestions.size(); ++i)
+      {
+        cout << (i ? ", " : "") << suggestions[i]->getUserName();
+      }
+      cout << "?" << endl;
+    }
   }
 }
 
 // Function to search for a user in the graph
 UserProfile *Graph::searchUser(const string &username)
 {
-  if (users.find(username) != users.end())
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  UserProfile **user = users.get(username);
+  return user ? *user : nullptr;
+}
+
+// Function to search for a user by email through the email index
+UserProfile *Graph::searchUserByEmail(const string &email) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return index.findByEmail(email);
+}
+
+bool Graph::isEmailTaken(const string &email) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return index.findByEmail(email) != nullptr;
+}
+
+// Function to search users by first/last name prefix
+vector<UserProfile *> Graph::searchUsersByNamePrefix(const string &prefix,
+                                                     size_t limit) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return index.findByNamePrefix(prefix, limit);
+}
+
+// Function to search users by first/last name range
+vector<UserProfile *> Graph::searchUsersByNameRange(const string &low,
+                                                    const string &high,
+                                                    size_t limit) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return index.findByNameRange(low, high, limit);
+}
+
+// Function to suggest users with similar names ("did you mean")
+vector<UserProfile *> Graph::suggestUsers(const string &query,
+                                          size_t limit) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  vector<UserProfile *> result;
+  for (const TrigramIndex::Match &match : fuzzyIndex.suggest(query, limit))
+  {
+    result.push_back(match.user);
+  }
+  return result;
+}
+
+// Function to search users by a substring of their username or names
+vector<UserProfile *> Graph::searchUsersBySubstring(const string &query,
+                                                    size_t limit) const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  if (query.size() < 3)
   {
-    return users[username];
+    return index.findByNamePrefix(query, limit);
   }
-  return nullptr;
+  return fuzzyIndex.findSubstring(query, limit);
+}
+
+// Function to change the attributes of a user
+bool Graph::updateProfile(const string &userName, const string &newUserName,
+                          const string &firstName, const string &lastName,
+                          const string &email)
+{
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  UserProfile **user = users.get(userName);
+  return user != nullptr &&
+         changeProfile(**user, newUserName, firstName, lastName, email);
+}
+
+// Called by the setters of a graph-owned profile: validate, write and
+// re-index it under one write lock, so no reader sees a half-made change
+bool Graph::changeProfile(UserProfile &user, const string &newUserName,
+                          const string &firstName, const string &lastName,
+                          const string &email)
+{
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
+  if (newUserName != user.getUserName() && users.contains(newUserName))
+  {
+    return false;
+  }
+  UserProfile *emailOwner = index.findByEmail(email);
+  if (emailOwner != nullptr && emailOwner != &user)
+  {
+    return false;
+  }
+  index.removeUser(&user);
+  fuzzyIndex.removeUser(&user);
+  // The arguments may be the attributes being overwritten; assign() copies
+  string oldUserName = user.getUserName();
+  assign(user, newUserName, firstName, lastName, email);
+
+  const string &userName = user.getUserName();
+  if (userName != oldUserName)
+  {
+    users.erase(oldUserName);
+    users.tryEmplace(userName, &user);
+
+    auto entry = adj.find(oldUserName);
+    if (entry != adj.end())
+    {
+      list<Connection *> connections = std::move(entry->second);
+      adj.erase(entry);
+      adj[userName] = std::move(connections);
+    }
+    GraphVersion::NeighborList *neighbors = neighborLists.get(oldUserName);
+    if (neighbors != nullptr)
+    {
+      GraphVersion::NeighborList moved = std::move(*neighbors);
+      neighborLists.erase(oldUserName);
+      neighborLists[userName] = std::move(moved);
+    }
+    uint32_t componentId = *componentIds.get(oldUserName);
+    componentIds.erase(oldUserName);
+    componentIds[userName] = componentId;
+    const uint32_t *rank = vertexRank.get(oldUserName);
+    if (rank != nullptr)
+    {
+      uint32_t position = *rank;
+      vertexRank.erase(oldUserName);
+      vertexRank[userName] = position;
+    }
+    // Neighbors list the user by name
+    dirtyUsers.push_back(oldUserName);
+    dirtyUsers.push_back(userName);
+    for (auto connection : connectionsOf(userName))
+    {
+      const string &neighborName = connection->getDestination()->getUserName();
+      neighborLists.get(neighborName)->rename(oldUserName, userName);
+      dirtyUsers.push_back(neighborName);
+    }
+    ++version;
+  }
+  index.addUser(&user);
+  fuzzyIndex.addUser(&user);
+  // Checkpoints save the profile with the user's adjacency block
+  dirtyBlocks[GraphVersion::blockOf(userName)] = true;
+  logMutation(LogOp::UpdateProfile,
+              {oldUserName, userName, user.getFirstName(), user.getLastName(),
+               user.getEmail()});
+  return true;
 }
 
 // Function to print the adjacency list representation of the graph
 void Graph::printGraph()
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   if (adj.empty())
   {
     cout << "Graph is empty" << endl;
@@ -189,17 +447,19 @@ void Graph::printGraph()
 // Function to check if a user is connected to another user
 bool Graph::isConnected(const string &src, const string &dest)
 {
-  // Check if the source user exists in the graph
-  if (adj.find(src) != adj.end())
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  // Both users list the connection; a hub's list is the long one
+  const list<Connection *> &fromSource = connectionsOf(src);
+  const list<Connection *> &fromDest = connectionsOf(dest);
+  bool bySource = fromSource.size() <= fromDest.size();
+  const string &other = bySource ? dest : src;
+  // Iterate through the connections of the user with fewer of them
+  for (auto connection : bySource ? fromSource : fromDest)
   {
-    // Iterate through the connections of the source user
-    for (auto connection : adj[src])
+      // Check if the other user is among them
+    if (connection->getDestination()->getUserName() == other)
     {
-      // Check if the destination user is connected to the source user
-      if (connection->getDestination()->getUserName() == dest)
-      {
-        return true;
-      }
+      return true;
     }
   }
   return false;
@@ -208,42 +468,520 @@ bool Graph::isConnected(const string &src, const string &dest)
 // Function to empty the graph
 void Graph::clearGraph()
 {
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
   // Clear the adjacency list
   for (auto &pair : adj)
   {
     pair.second.clear();
   }
   adj.clear();
+  neighborLists.clear();
+  // Every user is left with degree 0
+  degreeCounts.assign(1, users.size());
+  maxDegree = 0;
+  adjacencyEntries = 0;
+  totalWeight = 0;
+  rebuildVersion = true;
+  componentsStale = true;
+  ++version;
+  logMutation(LogOp::ClearGraph, {});
 }
 
 // Function to remove all users
 void Graph::clearUsers()
 {
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  PublishScope publish(*this);
   // Clear the adjacency list
   clearGraph();
 
-  // Clear the users map
+  // Clear the users map and its indexes
   for (auto &user : users)
   {
     delete user.second;
   }
   users.clear();
+  index.clear();
+  fuzzyIndex.clear();
+  components.clear();
+  componentIds.clear();
+  vertexRank.clear();
+  degreeCounts.clear();
+  rebuildVersion = true;
+  componentsStale = false;
+  logMutation(LogOp::ClearUsers, {});
 }
 
 // Function to get the number of users in the graph
-int Graph::getNumOfUsers() { return users.size(); }
+int Graph::getNumOfUsers()
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return users.size();
+}
 
 // Function to get the number of connections in the graph
 int Graph::getNumOfConnections()
 {
-  int count = 0;
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  // Since each connection is counted twice in an undirected graph
+  // we divide the total count by 2 to get the actual number of connections
+  return static_cast<int>(adjacencyEntries / 2);
+}
+
+// Function to get the total weight of the connections
+long long Graph::getTotalWeight() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return totalWeight;
+}
+
+// Function to get the largest number of connections of any user
+size_t Graph::getMaxDegree() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return maxDegree;
+}
+
+// Function to get the number of users per degree
+vector<size_t> Graph::getDegreeHistogram() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  return degreeCounts;
+}
+
+// Function to move a user between degree histogram buckets
+void Graph::degreeChanged(const string &userName, size_t from, size_t to)
+{
+  // Adjacency lists of unregistered users are not counted
+  if (!users.contains(userName))
+  {
+    return;
+  }
+  --degreeCounts[from];
+  if (to >= degreeCounts.size())
+  {
+    degreeCounts.resize(to + 1, 0);
+  }
+  ++degreeCounts[to];
+  if (to > maxDegree)
+  {
+    maxDegree = to;
+  }
+  // Degrees drop one step at a time, so this loop is O(1) amortized
+  while (maxDegree > 0 && degreeCounts[maxDegree] == 0)
+  {
+    --maxDegree;
+  }
+}
+
+// Function to copy the user profiles into a column-oriented store
+UserStore Graph::buildUserStore() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  vector<const UserProfile *> profiles;
+  profiles.reserve(users.size());
+  size_t textBytes = 0;
+  for (const auto &entry : users)
+  {
+    const UserProfile *user = entry.second;
+    profiles.push_back(user);
+    textBytes += user->getUserName().size() + user->getFirstName().size() +
+                 user->getLastName().size() + user->getEmail().size();
+  }
+  // Order of the last reorder(); unranked users last, by user ID
+  auto rankOf = [this](const UserProfile *user) {
+    const uint32_t *rank = vertexRank.get(user->getUserName());
+    return rank ? *rank : UINT32_MAX;
+  };
+  sort(profiles.begin(), profiles.end(),
+       [&rankOf](const UserProfile *a, const UserProfile *b) {
+         uint32_t rankA = rankOf(a), rankB = rankOf(b);
+         return rankA != rankB ? rankA < rankB
+                               : a->getUserId() < b->getUserId();
+       });
+
+  UserStore store;
+  store.reserve(profiles.size(), textBytes);
+  for (const UserProfile *user : profiles)
+  {
+    store.addUser(*user);
+  }
+  return store;
+}
+
+// Function to get (and lazily rebuild) the flat CSR copy of the graph
+shared_ptr<const FlatGraph> Graph::flatGraph() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  if (flatCache && flatCacheVersion == version)
+  {
+    return flatCache;
+  }
+
+  UserStore dictionary = buildUserStore();
+  size_t n = dictionary.rowCount();
+  vector<uint32_t> offsets(n + 1, 0);
+  vector<FlatGraph::Vertex> adjacency;
+  vector<int> weights;
+  vector<pair<FlatGraph::Vertex, int>> slice;
+  for (FlatGraph::Vertex v = 0; v < n; ++v)
+  {
+    slice.clear();
+    for (auto connection : connectionsOf(dictionary.getUserName(v)))
+    {
+      FlatGraph::Vertex dest =
+          dictionary.findRow(connection->getDestination()->getUserName());
+      if (dest != FlatGraph::NO_VERTEX && dest != v)
+      {
+        slice.emplace_back(dest, connection->getWeight());
+      }
+    }
+    sort(slice.begin(), slice.end());
+    for (size_t i = 0; i < slice.size(); ++i)
+    {
+      if (i == 0 || slice[i].first != slice[i - 1].first)
+      {
+        adjacency.push_back(slice[i].first);
+        weights.push_back(slice[i].second);
+      }
+    }
+    offsets[v + 1] = static_cast<uint32_t>(adjacency.size());
+  }
+
+  flatCache = make_shared<const FlatGraph>(std::move(dictionary),
+                                           std::move(offsets),
+                                           std::move(adjacency),
+                                           std::move(weights));
+  flatCacheVersion = version;
+  return flatCache;
+}
+
+// Function to relabel the flat graph's vertices for locality
+ReorderStats Graph::reorder(ReorderStrategy strategy)
+{
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  shared_ptr<const FlatGraph> before = flatGraph();
+  ReorderStats stats;
+  stats.gapBefore = averageNeighborGap(*before);
+
+  vector<FlatGraph::Vertex> order = computeOrdering(*before, strategy);
+  vertexRank.clear();
+  vertexRank.reserve(order.size());
+  for (uint32_t position = 0; position < order.size(); ++position)
+  {
+    vertexRank[before->nameOf(order[position])] = position;
+  }
+
+  // Same users and connections, new IDs: rebuild the flat copies
+  flatCache.reset();
+  compressedCache.reset();
+  stats.gapAfter = averageNeighborGap(*flatGraph());
+  return stats;
+}
+
+// Function to get (and lazily rebuild) the compressed copy of the graph
+shared_ptr<const CompressedGraph> Graph::compressedGraph() const
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  if (compressedCache && compressedCacheVersion == version)
+  {
+    return compressedCache;
+  }
+  compressedCache = make_shared<const CompressedGraph>(*flatGraph());
+  compressedCacheVersion = version;
+  return compressedCache;
+}
+
+// Function to suggest friends of friends for a user
+vector<pair<UserProfile *, double>>
+Graph::suggestFriends(const string &userName, size_t k,
+                      SuggestionScore scoring)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  FlatGraph::Vertex user = flat->idOf(userName);
+  if (user == FlatGraph::NO_VERTEX)
+  {
+    return {};
+  }
+
+  // Each thread keeps its suggester while the flat graph is current, so
+  // the per-vertex scratch array is allocated once per version instead of
+  // zero-filled on every call. The weak pointer expires with the graph
+  // the suggester refers to.
+  struct CachedSuggester
+  {
+    weak_ptr<const FlatGraph> graph;
+    SuggestionScore scoring;
+    unique_ptr<FriendSuggester> suggester;
+  };
+  thread_local CachedSuggester cached;
+  if (!cached.suggester || cached.scoring != scoring ||
+      cached.graph.lock() != flat)
+  {
+    cached.suggester.reset(); // drop the old scratch array first
+    cached.suggester.reset(new FriendSuggester(*flat, scoring));
+    cached.graph = flat;
+    cached.scoring = scoring;
+  }
+
+  vector<pair<UserProfile *, double>> result;
+  for (const FriendSuggestion &suggestion :
+       cached.suggester->suggest(user, k))
+  {
+    result.emplace_back(searchUser(string(flat->nameOf(suggestion.user))),
+                        suggestion.score);
+  }
+  return result;
+}
+
+// Function to write suggestions for every user to a file
+bool Graph::writeFriendSuggestions(const string &fileName, size_t k,
+                                   SuggestionScore scoring)
+{
+  ofstream file(fileName);
+  if (!file.is_open())
+  {
+    cerr << "Error: Unable to open " << fileName << " for writing\n";
+    return false;
+  }
+  FriendSuggester::suggestForAll(*flatGraph(), k, scoring, 0, file);
+  return true;
+}
+
+// Function to rank users with PageRank, warm-started from the last run
+PageRankResult Graph::calculatePageRank(const PageRankOptions &options)
+{
+  return calculatePageRank(flatGraph(), options);
+}
+
+// Function to rank the users of one flat graph with PageRank
+PageRankResult Graph::calculatePageRank(const shared_ptr<const FlatGraph> &flat,
+                                        const PageRankOptions &options)
+{
+  size_t n = flat->vertexCount();
+
+  vector<double> warmStart;
+  {
+    lock_guard<recursive_mutex> cacheGuard(cacheLock);
+    if (!lastPageRank.empty() && n > 0)
+    {
+      warmStart.resize(n);
+      for (FlatGraph::Vertex v = 0; v < n; ++v)
+      {
+        const double *score = lastPageRank.get(flat->nameOf(v));
+        warmStart[v] = score ? *score : 1.0 / n;
+      }
+    }
+  }
+
+  PageRankResult result = PageRank(*flat, options).run(warmStart);
+
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  lastPageRank.clear();
+  lastPageRank.reserve(n);
+  for (FlatGraph::Vertex v = 0; v < n; ++v)
+  {
+    lastPageRank[flat->nameOf(v)] = result.scores[v];
+  }
+  return result;
+}
+
+// Function to pick the highest scores and resolve them to profiles
+static vector<pair<UserProfile *, double>>
+topScores(Graph &graph, const FlatGraph &flat, const vector<double> &scores,
+          size_t k, FlatGraph::Vertex exclude)
+{
+  vector<FlatGraph::Vertex> order;
+  order.reserve(scores.size());
+  for (FlatGraph::Vertex v = 0; v < scores.size(); ++v)
+  {
+    if (v != exclude)
+    {
+      order.push_back(v);
+    }
+  }
+  k = min(k, order.size());
+  partial_sort(order.begin(), order.begin() + k, order.end(),
+               [&scores](FlatGraph::Vertex a, FlatGraph::Vertex b) {
+                 return scores[a] != scores[b] ? scores[a] > scores[b]
+                                               : a < b;
+               });
+
+  vector<pair<UserProfile *, double>> result;
+  for (size_t i = 0; i < k; ++i)
+  {
+    result.emplace_back(graph.searchUser(string(flat.nameOf(order[i]))),
+                        scores[order[i]]);
+  }
+  return result;
+}
+
+// Function to get the most influential users
+vector<pair<UserProfile *, double>>
+Graph::topInfluencers(size_t k, const PageRankOptions &options)
+{
+  // Scores and names must come from the same flat graph
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  PageRankResult result = calculatePageRank(flat, options);
+  return topScores(*this, *flat, result.scores, k, FlatGraph::NO_VERTEX);
+}
+
+// Function to rank users as seen from one user
+vector<pair<UserProfile *, double>>
+Graph::personalizedPageRank(const string &userName, size_t k,
+                            const PageRankOptions &options)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  FlatGraph::Vertex user = flat->idOf(userName);
+  if (user == FlatGraph::NO_VERTEX)
+  {
+    return {};
+  }
+  vector<double> teleport(flat->vertexCount(), 0.0);
+  teleport[user] = 1.0;
+  PageRankResult result = PageRank(*flat, options).run(teleport, teleport);
+  return topScores(*this, *flat, result.scores, k, user);
+}
+
+// Function to recommend users with random walks with restart
+vector<pair<UserProfile *, double>>
+Graph::recommendByRandomWalk(const string &userName, size_t k,
+                             const RandomWalkOptions &options)
+{
+  // Walk the published version: nothing is rebuilt after a mutation and
+  // alias tables are only built for the users the walks reach
+  GraphSnapshot pinned = snapshot();
+  if (pinned->find(userName) == nullptr)
+  {
+    return {};
+  }
+
+  vector<pair<UserProfile *, double>> result;
+  for (const auto &score :
+       RandomWalker(*pinned).personalizedScores(userName, k, options))
+  {
+    // Skip users removed since the version was published
+    UserProfile *user = searchUser(score.first);
+    if (user != nullptr)
+    {
+      result.emplace_back(user, score.second);
+    }
+  }
+  return result;
+}
+
+// Function to compute betweenness centrality
+BetweennessResult Graph::calculateBetweenness(
+    const BetweennessOptions &options)
+{
+  return ::calculateBetweenness(*flatGraph(), options);
+}
+
+// Function to get the users with the highest betweenness
+vector<pair<UserProfile *, double>>
+Graph::topBrokers(size_t k, const BetweennessOptions &options)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  BetweennessResult result = ::calculateBetweenness(*flat, options);
+  return topScores(*this, *flat, result.centrality, k, FlatGraph::NO_VERTEX);
+}
+
+// Function to detect communities
+CommunityResult Graph::detectCommunities(const CommunityOptions &options)
+{
+  return ::detectCommunities(*flatGraph(), options);
+}
+
+// Function to compute the core number of every user
+vector<uint32_t> Graph::coreNumbers(bool parallel)
+{
+  return computeCoreNumbers(*flatGraph(), parallel);
+}
+
+// Function to extract the k-core
+FlatGraph Graph::kCoreSubgraph(uint32_t k, bool parallel)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  vector<uint32_t> cores = computeCoreNumbers(*flat, parallel);
+  return flat->inducedSubgraph(kCoreVertices(cores, k));
+}
+
+// Function to get the component of a user
+int Graph::componentOf(const string &userName)
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  refreshComponents();
+  const uint32_t *id = componentIds.get(userName);
+  return id ? static_cast<int>(components.find(*id)) : -1;
+}
+
+// Function to check whether two users can reach each other
+bool Graph::sameComponent(const string &userName1, const string &userName2)
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  refreshComponents();
+  const uint32_t *id1 = componentIds.get(userName1);
+  const uint32_t *id2 = componentIds.get(userName2);
+  return id1 != nullptr && id2 != nullptr &&
+         components.find(*id1) == components.find(*id2);
+}
+
+// Function to get the number of connected components
+int Graph::getNumOfComponents()
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  refreshComponents();
+  return static_cast<int>(components.setCount());
+}
+
+// Function to get the number of components of each size
+map<size_t, size_t> Graph::getComponentSizeHistogram()
+{
+  ReaderWriterLock::ReadGuard guard(graphLock);
+  lock_guard<recursive_mutex> cacheGuard(cacheLock);
+  refreshComponents();
+  return components.sizeHistogram();
+}
+
+// Function to rebuild the union-find after removals
+void Graph::refreshComponents()
+{
+  if (!componentsStale)
+  {
+    return;
+  }
+  components.clear();
+  componentIds.clear();
+  componentIds.reserve(users.size());
+  for (const auto &entry : users)
+  {
+    componentIds[entry.first] = components.add();
+  }
+  // Connections may name users that were never added; they have no id
   for (const auto &entry : adj)
   {
-    count += entry.second.size();
+    const uint32_t *id = componentIds.get(entry.first);
+    if (id == nullptr)
+    {
+      continue;
+    }
+    for (auto connection : entry.second)
+    {
+      const uint32_t *other =
+          componentIds.get(connection->getDestination()->getUserName());
+      if (other != nullptr)
+      {
+        components.unite(*id, *other);
+      }
+    }
   }
-  // Since each connection is counted twice in an undirected graph
-  // we divide the total count by 2 to get the actual number of connections
-  return count / 2;
+  componentsStale = false;
 }
 
 // Function to perform Breadth First Search traversal
@@ -251,7 +989,9 @@ vector<string> Graph::bfsTraversal(const string &startUserName)
 {
   vector<string> traversalResult;
 
-  if (users.find(startUserName) == users.end())
+  // Traverse one version; concurrent mutations publish later versions
+  GraphSnapshot snapshot = versions.pin();
+  if (snapshot->find(startUserName) == nullptr)
   {
     cout << "User name : " << startUserName << " is not found." << endl;
     return traversalResult;
@@ -269,16 +1009,13 @@ vector<string> Graph::bfsTraversal(const string &startUserName)
 
     traversalResult.push_back(currentUser);
 
-    if (adj.find(currentUser) != adj.end())
+    for (const GraphVersion::Neighbor &neighbor :
+         snapshot->neighborsOf(currentUser))
     {
-      for (auto connection : adj[currentUser])
+      if (visited.find(neighbor.userName) == visited.end())
       {
-        string neighborUserName = connection->getDestination()->getUserName();
-        if (visited.find(neighborUserName) == visited.end())
-        {
-          visited.insert(neighborUserName);
-          userQueue.push(neighborUserName);
-        }
+        visited.insert(neighbor.userName);
+        userQueue.push(neighbor.userName);
       }
     }
   }
@@ -286,10 +1023,67 @@ vector<string> Graph::bfsTraversal(const string &startUserName)
   return traversalResult;
 }
 
+// Function to compute all-pairs distances within a group of users
+shared_ptr<DistanceMatrix>
+Graph::allPairsDistances(const vector<string> &userNames, bool weighted)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  vector<FlatGraph::Vertex> members;
+  members.reserve(userNames.size());
+  for (const string &userName : userNames)
+  {
+    FlatGraph::Vertex v = flat->idOf(userName);
+    if (v == FlatGraph::NO_VERTEX)
+    {
+      cout << "User name : " << userName << " is not found." << endl;
+      continue;
+    }
+    members.push_back(v);
+  }
+  return make_shared<DistanceMatrix>(flat->inducedSubgraph(members),
+                                     weighted);
+}
+
+// Function to get the users within k hops of a user
+EgoNetwork Graph::kHopNeighborhood(const string &userName, uint32_t k,
+                                   size_t limit) const
+{
+  GraphSnapshot pinned = snapshot();
+  return ::kHopNeighborhood(*pinned, userName, k, limit);
+}
+
+// Function to get the subgraph within k hops of a user
+KHopResult Graph::kHopSubgraph(const string &userName, uint32_t k,
+                               size_t limit)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  FlatGraph::Vertex user = flat->idOf(userName);
+  if (user == FlatGraph::NO_VERTEX)
+  {
+    KHopResult empty;
+    empty.truncated = false;
+    return empty;
+  }
+  return ::kHopNeighborhood(*flat, user, k, limit, true);
+}
+
+// Function to split the graph into shards
+shared_ptr<ShardedGraph> Graph::shardedGraph(size_t shardCount)
+{
+  return make_shared<ShardedGraph>(*flatGraph(), shardCount);
+}
+
+// Function to partition the graph with few cut connections
+PartitionResult Graph::partition(const PartitionOptions &options)
+{
+  return partitionGraph(*flatGraph(), options);
+}
+
 // A star algorithm to find the shortest path between two users
 vector<UserProfile *> Graph::astar(const string &startUserName,
                                    const string &goalUserName)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   // Heuristic function: estimate of the distance from a node to the goal
   auto heuristic = [](UserProfile *current, UserProfile *goal)
   {
@@ -312,12 +1106,18 @@ vector<UserProfile *> Graph::astar(const string &startUserName,
   // Map to store g-score (cost from start to current)
   unordered_map<UserProfile *, int> gScore;
 
+  UserProfile *start = searchUser(startUserName);
+  UserProfile *goal = searchUser(goalUserName);
+  if (start == nullptr || goal == nullptr)
+  {
+    return {};
+  }
+
   // Initialize g-score for start node
-  gScore[users[startUserName]] = 0;
+  gScore[start] = 0;
 
   // Add start node to open set with estimated total cost (f-score)
-  openSet.emplace(heuristic(users[startUserName], users[goalUserName]),
-                  users[startUserName]);
+  openSet.emplace(heuristic(start, goal), start);
 
   while (!openSet.empty())
   {
@@ -342,7 +1142,7 @@ vector<UserProfile *> Graph::astar(const string &startUserName,
     closedSet.insert(current);
 
     // Iterate through the neighbors of the current node
-    for (auto connection : adj[current->getUserName()])
+    for (auto connection : connectionsOf(current->getUserName()))
     {
       auto neighbor = connection->getDestination();
 
@@ -362,8 +1162,7 @@ vector<UserProfile *> Graph::astar(const string &startUserName,
         gScore[neighbor] = tentativeGScore;
 
         // Add neighbor to the open set with estimated total cost (f-score)
-        int fscore = tentativeGScore + heuristic(neighbor,
-                                                 users[goalUserName]);
+        int fscore = tentativeGScore + heuristic(neighbor, goal);
         openSet.emplace(fscore, neighbor);
       }
     }
@@ -377,6 +1176,7 @@ vector<UserProfile *> Graph::astar(const string &startUserName,
 vector<UserProfile *> Graph::dijkstra(const string &startUserName,
                                       const string &endUserName)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   // Priority queue to store vertices according to their distances
   priority_queue<pair<int, string>, vector<pair<int, string>>,
                  greater<pair<int, string>>>
@@ -406,7 +1206,7 @@ vector<UserProfile *> Graph::dijkstra(const string &startUserName,
     string u = pq.top().second;
     pq.pop();
 
-    for (const auto &connection : adj[u])
+    for (const auto &connection : connectionsOf(u))
     {
       string v = connection->getDestination()->getUserName();
       int weight = connection->getWeight();
@@ -428,11 +1228,11 @@ vector<UserProfile *> Graph::dijkstra(const string &startUserName,
     string currentVertex = endUserName;
     while (currentVertex != startUserName)
     {
-      shortestPath.push_back(users[currentVertex]);
+      shortestPath.push_back(searchUser(currentVertex));
       currentVertex = parent[currentVertex];
     }
 
-    shortestPath.push_back(users[startUserName]);
+    shortestPath.push_back(searchUser(startUserName));
 
     reverse(shortestPath.begin(), shortestPath.end());
   }
@@ -443,6 +1243,7 @@ vector<UserProfile *> Graph::dijkstra(const string &startUserName,
 unordered_map<string, pair<int, string>>
 Graph::bellmanFordShortestPath(const string &startNode)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   // Initialize distance map with infinite distance for all nodes
   unordered_map<string, pair<int, string>> distance;
   for (auto &entry : users)
@@ -497,6 +1298,7 @@ Graph::bellmanFordShortestPath(const string &startNode)
 vector<string> Graph::shortestPathUsingBellmandFord(const string &startNode,
                                                     const string &endNode)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   // Use Bellman-Ford to find shortest paths
   unordered_map<string, pair<int, string>> shortestPaths =
       bellmanFordShortestPath(startNode);
@@ -523,25 +1325,25 @@ vector<string> Graph::shortestPathUsingBellmandFord(const string &startNode,
 
 vector<string> Graph::getConnectedUsers(const string &userName)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   vector<string> connectedUsers;
 
-  if (users.find(userName) != users.end())
+  if (users.contains(userName))
   {
-    if (adj.find(userName) != adj.end())
+    const list<Connection *> &connections = connectionsOf(userName);
+    connectedUsers.reserve(connections.size());
+    for (auto connection : connections)
     {
-      for (auto connection : adj[userName])
-      {
-        string connectedUserName = connection->getDestination()->getUserName();
-        connectedUsers.push_back(connectedUserName);
-      }
+      connectedUsers.push_back(connection->getDestination()->getUserName());
     }
   }
 
   return connectedUsers;
 }
 
-void Graph::generateDOTFile(const string &fileName)
+void Graph::generateDOTFile(const string &fileName, bool colorByCommunity)
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   ofstream dotFile(fileName);
   if (!dotFile.is_open())
   {
@@ -558,10 +1360,29 @@ void Graph::generateDOTFile(const string &fileName)
              "penwidth=3];\n";
 
   // Write node properties
+  shared_ptr<const FlatGraph> flat;
+  CommunityResult communities;
+  if (colorByCommunity)
+  {
+    flat = flatGraph();
+    communities = ::detectCommunities(*flat, CommunityOptions());
+  }
+  // Largest communities get the first colors; the palette wraps around
+  static const char *const PALETTE[] = {
+      "#8dd3c7", "#ffffb3", "#bebada", "#fb8072", "#80b1d3", "#fdb462",
+      "#b3de69", "#fccde5", "#d9d9d9", "#bc80bd", "#ccebc5", "#ffed6f"};
+  const size_t PALETTE_SIZE = sizeof(PALETTE) / sizeof(PALETTE[0]);
   for (const auto &entry : users)
   {
     string userName = entry.first;
-    dotFile << "  " << userName << ";\n";
+    dotFile << "  " << userName;
+    if (colorByCommunity)
+    {
+      uint32_t community = communities.community[flat->idOf(userName)];
+      dotFile << " [fillcolor=\"" << PALETTE[community % PALETTE_SIZE]
+              << "\"]";
+    }
+    dotFile << ";\n";
   }
 
   // Write edge properties
@@ -612,6 +1433,9 @@ void Graph::renderGraph(const string &dotFileName,
 // Function to perform Depth First Search traversal
 vector<string> Graph::dfsTraversal(const string &startUserName)
 {
+  // Traverse one version; concurrent mutations publish later versions
+  GraphSnapshot snapshot = versions.pin();
+
   // Vector to store the path of visited nodes
   vector<string> path;
 
@@ -619,28 +1443,25 @@ vector<string> Graph::dfsTraversal(const string &startUserName)
   unordered_set<string> visited;
 
   // Perform DFS traversal
-  dfsUtil(startUserName, visited, path);
+  dfsUtil(*snapshot, startUserName, visited, path);
 
   return path;
 }
 
 // Utility function for DFS traversal
-void Graph::dfsUtil(const string &node, unordered_set<string> &visited,
-                    vector<string> &path)
+void Graph::dfsUtil(const GraphVersion &snapshot, const string &node,
+                    unordered_set<string> &visited, vector<string> &path)
 {
   // Mark the current node as visited
   visited.insert(node);
   path.push_back(node);
 
   // Traverse all adjacent nodes of the current node
-  for (auto connection : adj[node])
+  for (const GraphVersion::Neighbor &neighbor : snapshot.neighborsOf(node))
   {
-    string neighbor = (connection->getSource()->getUserName() == node)
-                          ? connection->getDestination()->getUserName()
-                          : connection->getSource()->getUserName();
-    if (visited.find(neighbor) == visited.end())
+    if (visited.find(neighbor.userName) == visited.end())
     {
-      dfsUtil(neighbor, visited, path);
+      dfsUtil(snapshot, neighbor.userName, visited, path);
     }
   }
 }
@@ -648,48 +1469,105 @@ void Graph::dfsUtil(const string &node, unordered_set<string> &visited,
 // Function to calculate the average degree of the graph
 double Graph::calculateAverageDegree()
 {
+  ReaderWriterLock::ReadGuard guard(graphLock);
   if (adj.empty() || users.empty())
   {
     return 0.0;
   }
 
-  double totalDegree = 0.0;
-  for (const auto &entry : adj)
+  return static_cast<double>(adjacencyEntries) / users.size();
+}
+
+// Longest finite hop distance: one BFS per vertex, spread over workers.
+// 'context' (if any) receives progress per vertex and can cancel the run.
+static int diameterOf(const CompressedGraph &compressed, JobContext *context)
+{
+  vector<uint32_t> longest(workerCount(), 0);
+  if (context != nullptr)
   {
-    totalDegree += entry.second.size();
+    context->setTotal(compressed.vertexCount());
   }
-
-  return totalDegree / users.size();
+  parallelFor(0, compressed.vertexCount(), 16,
+              [&](size_t lo, size_t hi, unsigned worker) {
+                if (context != nullptr && context->cancelled())
+                {
+                  return;
+                }
+                for (size_t src = lo; src < hi; ++src)
+                {
+                  // Find the maximum finite distance from this user
+                  for (uint32_t d : compressed.bfs(
+                           static_cast<CompressedGraph::Vertex>(src)))
+                  {
+                    if (d != CompressedGraph::UNREACHED &&
+                        d > longest[worker])
+                    {
+                      longest[worker] = d;
+                    }
+                  }
+                }
+                if (context != nullptr)
+                {
+                  context->advance(hi - lo);
+                }
+              });
+
+  return static_cast<int>(*max_element(longest.begin(), longest.end()));
 }
 
 // Function to calculate the diameter of the graph
 int Graph::calculateDiameter()
 {
-  if (users.empty())
+  // Runs on an immutable copy: writers only wait while it is built
+  shared_ptr<const CompressedGraph> compressed = compressedGraph();
+  if (compressed->vertexCount() == 0)
   {
     return -1;
   }
+  return diameterOf(*compressed, nullptr);
+}
 
-  int diameter = 0;
-  const int INF = std::numeric_limits<int>::max(); // Declare INF constant
+// Function to calculate the diameter in the background
+shared_ptr<AnalyticsJob<int>> Graph::submitDiameter()
+{
+  shared_ptr<const CompressedGraph> snapshot = compressedGraph();
+  return jobs.submit<int>([snapshot](JobContext &context) {
+    return snapshot->vertexCount() == 0 ? -1 : diameterOf(*snapshot, &context);
+  });
+}
 
-  // Iterate through each vertex and find the maximum shortest path
-  for (const auto &entry : users)
-  {
-    const string &src = entry.first;
-    vector<int> dist = shortestPath(src);
+// Function to cancel the background jobs
+void Graph::cancelJobs() { jobs.cancelAll(); }
 
-    // Find the maximum distance in the shortest paths
-    for (int d : dist)
-    {
-      if (d != INF && d > diameter)
-      {
-        diameter = d;
-      }
-    }
+// Function to count triangles and clustering coefficients
+TriangleStats Graph::calculateTriangles()
+{
+  return countTriangles(*flatGraph());
+}
+
+// Function to calculate the clustering coefficient of one user
+double Graph::calculateClusteringCoefficient(const string &userName)
+{
+  shared_ptr<const FlatGraph> flat = flatGraph();
+  FlatGraph::Vertex user = flat->idOf(userName);
+  uint32_t degree = user == FlatGraph::NO_VERTEX ? 0 : flat->degree(user);
+  if (degree < 2)
+  {
+    return 0.0;
   }
 
-  return diameter;
+  // Count the edges among the user's connections
+  const FlatGraph::Vertex *friends = flat->neighbors(user);
+  vector<FlatGraph::Vertex> common(degree);
+  uint64_t links = 0;
+  for (uint32_t i = 0; i < degree; ++i)
+  {
+    links += intersectSorted(friends, degree, flat->neighbors(friends[i]),
+                             flat->degree(friends[i]), common.data());
+  }
+  // Each link was seen from both ends
+  return static_cast<double>(links) / (static_cast<double>(degree) *
+                                       (degree - 1));
 }
 
 // Function to calculate shortest paths from a source node
@@ -716,7 +1594,7 @@ vector<int> Graph::shortestPath(const string &src)
     string u = q.front();
     q.pop();
     // Iterate through all adjacent nodes of u
-    for (auto connection : adj[u])
+    for (auto connection : connectionsOf(u))
     {
       string v = (connection->getSource()->getUserName() == u)
                      ? connection->getDestination()->getUserName()
@@ -738,3 +1616,388 @@ vector<int> Graph::shortestPath(const string &src)
   }
   return dist;
 }
+
+// Function to look up the connections of a user without inserting into adj
+const list<Connection *> &Graph::connectionsOf(string_view userName) const
+{
+  static const list<Connection *> noConnections;
+  const list<Connection *> *connections = adj.get(userName);
+  return connections ? *connections : noConnections;
+}
+
+// Function to pin the latest published version of the adjacency
+GraphSnapshot Graph::snapshot() const { return versions.pin(); }
+
+// Open a mutation; the outermost one publishes its changes on exit
+Graph::PublishScope::PublishScope(Graph &graph) : graph(graph)
+{
+  ++graph.mutationDepth;
+}
+
+Graph::PublishScope::~PublishScope()
+{
+  if (--graph.mutationDepth == 0 && graph.batchDepth == 0)
+  {
+    graph.publishVersion();
+  }
+}
+
+// Function to hold back publishing until endBatch()
+void Graph::beginBatch()
+{
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  ++batchDepth;
+}
+
+// Function to publish the mutations of a batch
+void Graph::endBatch()
+{
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  if (batchDepth > 0 && --batchDepth == 0 && mutationDepth == 0)
+  {
+    publishVersion();
+  }
+}
+
+// Function to publish the users changed by the last mutation
+void Graph::publishVersion()
+{
+  if (!rebuildVersion && dirtyUsers.empty())
+  {
+    return;
+  }
+  // The entry shares the chunks of the user's neighbor list
+  auto entryOf = [this](const string &userName)
+      -> shared_ptr<const GraphVersion::UserEntry> {
+    const GraphVersion::NeighborList *neighbors = neighborLists.get(userName);
+    bool connected = neighbors != nullptr && !neighbors->empty();
+    if (!users.contains(userName) && !connected)
+    {
+      return nullptr; // removed
+    }
+    shared_ptr<GraphVersion::UserEntry> entry =
+        make_shared<GraphVersion::UserEntry>();
+    entry->userName = userName;
+    if (connected)
+    {
+      entry->neighbors = *neighbors;
+    }
+    return entry;
+  };
+
+  vector<VersionedAdjacency::Change> changes;
+  if (rebuildVersion)
+  {
+    // Every user, plus adjacency lists of users that were never added
+    for (const auto &entry : users)
+    {
+      changes.emplace_back(entry.first, entryOf(entry.first));
+    }
+    for (const auto &entry : adj)
+    {
+      if (!users.contains(entry.first) && !entry.second.empty())
+      {
+        changes.emplace_back(entry.first, entryOf(entry.first));
+      }
+    }
+  }
+  else
+  {
+    sort(dirtyUsers.begin(), dirtyUsers.end());
+    dirtyUsers.erase(unique(dirtyUsers.begin(), dirtyUsers.end()),
+                     dirtyUsers.end());
+    for (const string &userName : dirtyUsers)
+    {
+      changes.emplace_back(userName, entryOf(userName));
+    }
+  }
+  versions.publish(changes, rebuildVersion);
+  if (rebuildVersion)
+  {
+    dirtyBlocks.assign(GraphVersion::BLOCKS, true); // emptied ones too
+  }
+  else
+  {
+    for (const VersionedAdjacency::Change &change : changes)
+    {
+      dirtyBlocks[GraphVersion::blockOf(change.first)] = true;
+    }
+  }
+  dirtyUsers.clear();
+  rebuildVersion = false;
+}
+
+// Function to log a mutation to storage
+void Graph::logMutation(LogOp op, initializer_list<string_view> args,
+                        int32_t weight)
+{
+  // Nested mutations are redone by the outer one on replay
+  if (mutationDepth == 1 && mutationLog.isOpen())
+  {
+    mutationLog.append(op, args, weight);
+  }
+}
+
+// Function to redo a logged mutation
+void Graph::applyLogRecord(const LogRecord &record)
+{
+  // Names each operation needs, indexed by LogOp
+  static const size_t ARG_COUNTS[] = {0, 4, 1, 2, 2, 1, 0, 0, 5};
+  const vector<string> &args = record.args;
+  if (args.size() < ARG_COUNTS[static_cast<size_t>(record.op)])
+  {
+    cerr << "Warning: skipped malformed log record " << record.lsn << endl;
+    return;
+  }
+  switch (record.op)
+  {
+  case LogOp::AddUser:
+  {
+    UserProfile *user = new UserProfile(args[0], args[1], args[2], args[3]);
+    if (!addUser(user))
+    {
+      delete user;
+    }
+    break;
+  }
+  case LogOp::RemoveUser:
+    removeUser(args[0]);
+    break;
+  case LogOp::AddConnection:
+  {
+    UserProfile *source = searchUser(args[0]);
+    UserProfile *destination = searchUser(args[1]);
+    if (source != nullptr && destination != nullptr)
+    {
+      Connection *connection =
+          new Connection(source, destination, record.weight);
+      if (!addConnection(connection))
+      {
+        delete connection;
+      }
+    }
+    break;
+  }
+  case LogOp::RemoveConnection:
+    removeConnection(args[0], args[1]);
+    break;
+  case LogOp::DeleteConnections:
+    deleteConnectionsOfUser(args[0]);
+    break;
+  case LogOp::ClearGraph:
+    clearGraph();
+    break;
+  case LogOp::ClearUsers:
+    clearUsers();
+    break;
+  case LogOp::UpdateProfile:
+  {
+    updateProfile(args[0], args[1], args[2], args[3], args[4]);
+    break;
+  }
+  }
+}
+
+// Function to restore the graph from storage and start logging
+bool Graph::openStorage(const string &directory, const StorageOptions &options,
+                        RecoveryStats *stats)
+{
+  auto started = chrono::steady_clock::now();
+  ReaderWriterLock::WriteGuard guard(graphLock);
+  error_code error;
+  filesystem::create_directories(directory, error);
+  if (error)
+  {
+    cerr << "Error: cannot create " << directory << ": " << error.message()
+         << endl;
+    return false;
+  }
+  string logFile = directory + "/graph.log";
+
+  bool found = false;
+  LogReplayStats replayed;
+  {
+    // Replayed mutations publish one version at the end, not one each
+    PublishScope publish(*this);
+
+    // The last checkpoint first
+    if (!checkpoints.open(directory, found) || !restoreCheckpoint())
+    {
+      checkpoints.close();
+      return false;
+    }
+
+    // Then the mutations logged after it
+    if (!MutationLog::replay(
+            logFile, checkpoints.lsn(),
+            [this](const LogRecord &record) { applyLogRecord(record); },
+            replayed))
+    {
+      checkpoints.close();
+      return false;
+    }
+  }
+  if (replayed.tornTail)
+  {
+    cerr << "Warning: dropped an incomplete record at the end of " << logFile
+         << endl;
+  }
+  if (!mutationLog.open(logFile, replayed,
+                        max(checkpoints.lsn(), replayed.lastLsn), options.log))
+  {
+    checkpoints.close();
+    return false;
+  }
+  storageDirectory = directory;
+  if (graphLock.isEnabled() && options.checkpointIntervalSeconds > 0)
+  {
+    checkpointer.start(chrono::seconds(options.checkpointIntervalSeconds),
+                       [this]() { checkpoint(); });
+  }
+  if (stats != nullptr)
+  {
+    stats->found = found || replayed.validBytes > 0;
+    stats->checkpointLsn = checkpoints.lsn();
+    stats->replayedRecords = replayed.records;
+    stats->tornTail = replayed.tornTail;
+    stats->seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - started)
+            .count();
+  }
+  return true;
+}
+
+// Function to rebuild the graph from the saved blocks
+bool Graph::restoreCheckpoint()
+{
+  bool moved = false;
+  {
+    PublishScope publish(*this);
+    // Users first; each connection is listed by both of its users, so it
+    // is linked from the one whose name sorts first once both exist
+    vector<pair<UserProfile *, GraphVersion::Neighbor>> connections;
+    bool loaded = checkpoints.load([&](uint32_t block,
+                                       const CheckpointUser &saved) {
+      // Blocks are placed by a hash that another build may compute
+      // differently; such a checkpoint is then rewritten whole
+      moved = moved || GraphVersion::blockOf(saved.userName) != block;
+      UserProfile *user = new UserProfile(saved.userName, saved.firstName,
+                                          saved.lastName, saved.email);
+      if (!addUser(user))
+      {
+        delete user;
+        return;
+      }
+      for (const GraphVersion::Neighbor &neighbor : saved.neighbors)
+      {
+        if (saved.userName < neighbor.userName)
+        {
+          connections.emplace_back(user, neighbor);
+        }
+      }
+    });
+    if (!loaded)
+    {
+      return false;
+    }
+    for (const auto &saved : connections)
+    {
+      UserProfile **destination = users.get(saved.second.userName);
+      if (destination != nullptr)
+      {
+        linkUsers(
+            new Connection(saved.first, *destination, saved.second.weight));
+      }
+    }
+  }
+  // What is published now is what the checkpoint holds
+  publishVersion();
+  dirtyBlocks.assign(GraphVersion::BLOCKS, moved);
+  return true;
+}
+
+// Function to save the changed blocks and truncate the log
+bool Graph::checkpoint(CheckpointStats *stats)
+{
+  lock_guard<mutex> serialize(checkpointLock);
+  vector<CheckpointImage> images;
+  uint64_t lsn;
+  {
+    // The write lock keeps the flags, the LSN and the profiles consistent
+    // while the changed blocks are encoded; the files are written after it
+    // is released
+    ReaderWriterLock::WriteGuard guard(graphLock);
+    if (!mutationLog.isOpen() || !checkpoints.isOpen())
+    {
+      cerr << "Error: no storage is open." << endl;
+      return false;
+    }
+    lsn = mutationLog.lastLsn();
+    publishVersion(); // what an open batch changed so far
+    GraphSnapshot snapshot = versions.pin();
+    for (size_t block = 0; block < GraphVersion::BLOCKS; ++block)
+    {
+      if (!dirtyBlocks[block])
+      {
+        continue;
+      }
+      dirtyBlocks[block] = false;
+      images.push_back(
+          CheckpointImage{static_cast<uint32_t>(block), 0, string()});
+      CheckpointImage &image = images.back();
+      snapshot->forEachInBlock(
+          block, [&](const GraphVersion::UserEntry &entry) {
+            // Connections of users that were never added are not saved
+            UserProfile *const *user = users.get(entry.userName);
+            if (user != nullptr)
+            {
+              CheckpointStore::addUser(image, entry.userName,
+                                       (*user)->getFirstName(),
+                                       (*user)->getLastName(),
+                                       (*user)->getEmail(), entry.neighbors);
+            }
+          });
+    }
+  }
+  if (images.empty() && lsn == checkpoints.lsn())
+  {
+    if (stats != nullptr)
+    {
+      *stats = CheckpointStats{lsn, 0, 0, false};
+    }
+    return true; // nothing changed since the last one
+  }
+
+  if (!checkpoints.write(lsn, images, stats))
+  {
+    // Still unsaved: the next checkpoint writes these blocks again
+    ReaderWriterLock::WriteGuard guard(graphLock);
+    for (const CheckpointImage &image : images)
+    {
+      dirtyBlocks[image.block] = true;
+    }
+    return false;
+  }
+  return mutationLog.truncateThrough(lsn);
+}
+
+// Function to take a last checkpoint and stop logging
+bool Graph::closeStorage()
+{
+  checkpointer.stop();
+  if (!mutationLog.isOpen())
+  {
+    return true;
+  }
+  bool saved = checkpoint();
+  mutationLog.close();
+  lock_guard<mutex> serialize(checkpointLock);
+  checkpoints.close();
+  return saved;
+}
+
+// Function to wait for the logged mutations to be durable
+bool Graph::syncStorage() { return mutationLog.sync(); }
+
+// Function to report the log counters
+LogStats Graph::storageStats() const { return mutationLog.stats(); }
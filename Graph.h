@@ -1,8 +1,36 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include "AnalyticsJob.h"
+#include "Betweenness.h"
+#include "Checkpoint.h"
+#include "Communities.h"
+#include "CompressedGraph.h"
+#include "DistanceMatrix.h"
+#include "FlatGraph.h"
+#include "FlatHashMap.h"
+#include "FriendSuggester.h"
+#include "GraphVersion.h"
+#include "KCore.h"
+#include "KHop.h"
+#include "MutationLog.h"
+#include "PageRank.h"
+#include "Partitioner.h"
+#include "ReaderWriterLock.h"
+#include "RandomWalker.h"
+#include "Reorder.h"
+#include "ShardedGraph.h"
+#include "Triangles.h"
+#include "TrigramIndex.h"
+#include "UnionFind.h"
+#include "UserIndex.h"
+#include "UserProfile.h"
+#include "UserStore.h"
 #include <iostream>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -10,9 +38,24 @@
 
 using namespace std;
 
-// Forward declaration of Connection and UserProfile classes
+// Forward declaration of Connection class
 class Connection;
-class UserProfile;
+
+struct RecoveryStats
+{
+  bool found;             // a checkpoint or a log existed
+  uint64_t checkpointLsn; // last log record included in the checkpoint
+  size_t replayedRecords; // log records applied after the checkpoint
+  bool tornTail;          // an incomplete last record was dropped
+  double seconds;         // time taken to restore
+};
+
+struct StorageOptions
+{
+  LogOptions log;                          // group commit of the log
+  unsigned checkpointIntervalSeconds = 60; // background checkpoints of a
+                                           // thread-safe graph; 0 = none
+};
 
 /******************************************************************************
  * Class: Graph
@@ -21,22 +64,72 @@ class UserProfile;
  *                                   store users and connections between them.
  *
  * Member Variables:
- *    - users: An unordered map to store user profiles.
- *    - adj: An unordered map representing the adjacency list
+ *    - graphLock: Reader-writer lock over the graph (a no-op unless the
+ *                 graph is thread-safe).
+ *    - users: A flat hash map to store user profiles.
+ *    - adj: A flat hash map representing the adjacency list
  *                                          to store connections between users.
+ *    - index: Secondary indexes (email, first/last name) over the users,
+ *             kept in sync through addUser/removeUser and profile setters.
+ *    - fuzzyIndex: Trigram index for typo-tolerant and substring search,
+ *                  maintained alongside 'index'.
+ *    - components: Union-find over the users, merged on addConnection and
+ *                  rebuilt lazily after removals.
+ *    - componentIds: Username -> element of 'components'.
+ *    - componentsStale: Set by removals; the next component query rebuilds.
+ *    - adjacencyEntries / totalWeight / degreeCounts / maxDegree: Summary
+ *      counters kept up to date by every mutation, so that the connection
+ *      count, average degree and degree distribution are O(1) to read.
+ *    - lastPageRank: Scores of the last PageRank run by username, used to
+ *                    warm-start the next run after mutations.
+ *    - vertexRank: Username -> position in the flat vertex order chosen by
+ *                  the last reorder(); users added since come last.
+ *    - version: Incremented by every mutation.
+ *    - flatCache: Flat (CSR) copy of the adjacency, rebuilt on demand when
+ *                 'version' has moved on since it was built.
+ *    - compressedCache: Delta + varint copy of 'flatCache', rebuilt the
+ *                       same way. A derived, read-only copy held next to
+ *                       'adj' and 'flatCache': it adds to resident memory.
+ *    - cacheLock: Guards the caches that queries fill in under the shared
+ *                 lock: the flat copies, 'components' (union-find queries
+ *                 compress paths) and 'lastPageRank'.
+ *    - versions: Published copy-on-write versions of the adjacency for
+ *                snapshot readers.
+ *    - neighborLists: The connections of each user as published: the
+ *                     entries of 'adj' by name, in chunks shared with the
+ *                     versions, so publishing a user copies no neighbors.
+ *    - dirtyUsers / rebuildVersion: Users changed by the current mutation,
+ *                or a whole new version after clearGraph/clearUsers.
+ *    - mutationDepth: Nesting of the current mutation's PublishScopes.
+ *    - batchDepth: Nesting of beginBatch(); publishing waits for 0.
+ *    - mutationLog: Write-ahead log of the mutations since the last
+ *                   checkpoint, once openStorage() succeeded.
+ *    - storageDirectory: Where the checkpoint and the log are kept.
+ *    - checkpoints: Saved adjacency blocks of the last checkpoint.
+ *    - dirtyBlocks: Blocks (GraphVersion::blockOf) changed since the last
+ *                   checkpoint; only these are written by the next one.
+ *    - checkpointLock: Lets one checkpoint run at a time.
+ *    - checkpointer: Background thread taking periodic checkpoints.
+ *    - jobs: Threads of background analytics; declared last so that they
+ *            are cancelled and joined before anything else is destroyed.
  *
  *****************************************************************************/
-class Graph
+class Graph : private UserProfileListener
 {
 public:
   /***** Constructors and Destructor *****/
-  // Default Constructor
-  Graph();
+  // Constructor
+  explicit Graph(bool threadSafe = false);
   /*-------------------------------------------------------------------------
-    Constructs an empty graph.
+    Constructs an empty graph. A thread-safe graph may be used from many
+    threads at once: queries run concurrently under a shared lock, and
+    mutations (including profile changes) take it exclusively.
 
     Preconditions: None.
-    Postconditions: An empty graph object is created.
+    Postconditions: An empty graph object is created. Without 'threadSafe'
+    the graph takes no locks and must be used from one thread at a time.
+    In either mode, a returned UserProfile pointer is only valid until that
+    user is removed.
   -------------------------------------------------------------------------*/
 
   // Destructor to clean up dynamically allocated memory
@@ -57,7 +150,8 @@ public:
     Preconditions:
       - 'connection' is a valid Connection object.
 
-    Postconditions: The connection is added to the graph.
+    Postconditions: The connection is added to the graph. Returns false if
+    the users are already connected or are the same user.
   -------------------------------------------------------------------------*/
 
   // Function to remove an edge/connection between user1 and user2
@@ -127,6 +221,86 @@ public:
     Postconditions:
    - Returns a pointer to the UserProfile object if found; otherwise, nullptr.
       */
+  bool updateProfile(const string &userName, const string &newUserName,
+                     const string &firstName, const string &lastName,
+                     const string &email);
+  /*-------------------------------------------------------------------------
+    Change every attribute of a user at once; the setters of a graph-owned
+    UserProfile come here too. Validation, the new attributes, the new key
+    and the indexes are all applied under one exclusive lock.
+
+    Preconditions: None.
+
+    Postconditions: Returns false, leaving the user unchanged, if the user
+    is not found or the new username or email belongs to another user.
+  -------------------------------------------------------------------------*/
+  UserProfile *searchUserByEmail(const string &email) const;
+  /*-------------------------------------------------------------------------
+    Search for a user by email (case-insensitive) through the email index.
+
+    Preconditions: None.
+
+    Postconditions:
+   - Returns a pointer to the UserProfile object if found; otherwise, nullptr.
+      */
+
+  bool isEmailTaken(const string &email) const;
+  /*-------------------------------------------------------------------------
+    Check if an email is already registered.
+
+    Preconditions: None.
+
+    Postconditions:
+      - Returns true if another user already uses the email; otherwise, false.
+      */
+
+  vector<UserProfile *> searchUsersByNamePrefix(const string &prefix,
+                                                size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Search for users whose first or last name starts with a prefix.
+
+    Preconditions: None.
+
+    Postconditions:
+      - Returns at most 'limit' users, ordered by the matching name.
+      */
+
+  vector<UserProfile *> searchUsersByNameRange(const string &low,
+                                               const string &high,
+                                               size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Search for users whose first or last name lies in [low, high).
+
+    Preconditions:
+      - 'high' is empty (no upper bound) or not less than 'low'.
+
+    Postconditions:
+      - Returns at most 'limit' users, ordered by the matching name.
+      */
+
+  vector<UserProfile *> suggestUsers(const string &query, size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Suggest users whose username, first or last name resembles 'query'
+    ("did you mean"), tolerating typos.
+
+    Preconditions: None.
+
+    Postconditions:
+      - Returns at most 'limit' users, most similar first.
+      */
+
+  vector<UserProfile *> searchUsersBySubstring(const string &query,
+                                               size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Search for users whose username, first or last name contains 'query'.
+    Queries shorter than a trigram fall back to the name prefix index.
+
+    Preconditions: None.
+
+    Postconditions:
+      - Returns at most 'limit' users.
+      */
+
   bool addUser(UserProfile *user);
   /*-------------------------------------------------------------------------
     Add a new user to the graph.
@@ -135,7 +309,10 @@ public:
       - 'user' is a valid pointer to a UserProfile object.
 
     Postconditions:
-      - If the user is successfully added, returns true; otherwise, false.
+      - If the user is successfully added, returns true; otherwise, false
+        (the username or the email is already taken).
+      - Later changes made through the profile's setters keep the graph's
+        username key and indexes up to date.
       */
 
   bool removeUser(const string &username);
@@ -166,6 +343,42 @@ public:
 
     Postconditions: Returns the total number of connections in the graph.
     */
+  long long getTotalWeight() const;
+  /*-------------------------------------------------------------------------
+    Get the sum of the weights of all connections.
+
+    Preconditions: None.
+
+    Postconditions: Returns the total weight, each connection counted once
+    with the weight it was added with.
+    */
+  size_t getMaxDegree() const;
+  /*-------------------------------------------------------------------------
+    Get the largest number of connections of any user.
+
+    Preconditions: None.
+
+    Postconditions: Returns the maximum degree, 0 for an empty graph.
+    */
+  vector<size_t> getDegreeHistogram() const;
+  /*-------------------------------------------------------------------------
+    Get the degree distribution of the users.
+
+    Preconditions: None.
+
+    Postconditions: Entry d is the number of users with exactly d
+    connections; the vector may have trailing zero entries.
+    */
+  UserStore buildUserStore() const;
+  /*-------------------------------------------------------------------------
+    Copy every user profile into a column-oriented UserStore.
+
+    Preconditions: None.
+
+    Postconditions: Returns a store with one row per user, in the order
+    set by reorder() (by user ID before any reorder, and for users added
+    after it).
+    */
   bool isConnected(const string &src, const string &dest);
   /*-------------------------------------------------------------------------
     Check if there is a connection between two users.
@@ -177,6 +390,265 @@ public:
   - Returns true if there is a connection between the users; otherwise, false.
       */
 
+  shared_ptr<const FlatGraph> flatGraph() const;
+  /*-------------------------------------------------------------------------
+    Get a flat (CSR) copy of the graph with dense vertex IDs and sorted
+    neighbor arrays, for whole-graph algorithms.
+
+    Preconditions: None.
+
+    Postconditions: Returns the cached copy, rebuilding it first if the graph
+    changed since it was built. The copy itself never changes, so callers
+    may keep it after further mutations.
+    */
+
+  GraphSnapshot snapshot() const;
+  /*-------------------------------------------------------------------------
+    Pin the latest published version of the adjacency. Every mutation
+    publishes a new version when it completes (removeUser with all of its
+    connections at once), copying only the changed users' blocks; inside
+    beginBatch()/endBatch() the version is published at endBatch().
+
+    Preconditions: None.
+
+    Postconditions: Returns without locking. The version stays unchanged
+    and valid while the snapshot is in scope; writers never wait for it.
+    Old versions are freed once no snapshot pins them.
+    */
+
+  void beginBatch();
+  void endBatch();
+  /*-------------------------------------------------------------------------
+    Group many mutations (loading a file, replaying the log) into one
+    published version. Every mutation is still applied and logged at once;
+    snapshot() readers see none of them until the outermost endBatch().
+
+    Preconditions: Every beginBatch() is matched by one endBatch(). While a
+    batch is open, the mutations of other threads are held back with it.
+
+    Postconditions: endBatch() publishes what the batch changed. A
+    checkpoint taken during a batch publishes what it changed so far.
+  -------------------------------------------------------------------------*/
+
+  shared_ptr<const CompressedGraph> compressedGraph() const;
+  /*-------------------------------------------------------------------------
+    Get a compressed (delta + varint) copy of the adjacency for read-mostly
+    traversals; a few bytes per connection instead of a Connection object.
+    The copy is derived from flatGraph() and cached next to it and the
+    live adjacency, so it does not reduce the Graph's resident memory:
+    it lets traversals (calculateDiameter) scan fewer bytes, and a
+    process that only needs the encoded form can keep this object and
+    drop the Graph.
+
+    Preconditions: None.
+
+    Postconditions: Returns the cached copy, re-encoding flatGraph() first
+    if the graph changed. Vertex IDs are those of flatGraph().
+    */
+
+  /***** Recommendations *****/
+  vector<pair<UserProfile *, double>>
+  suggestFriends(const string &userName, size_t k,
+                 SuggestionScore scoring = SuggestionScore::MUTUAL_FRIENDS);
+  /*-------------------------------------------------------------------------
+    Suggest "people you may know": friends of friends ranked by mutual
+    friend count, Adamic-Adar or Jaccard similarity.
+
+    Preconditions: None.
+
+    Postconditions: Returns up to 'k' (user, score) pairs, best first; empty
+    if the user is not found.
+    */
+
+  bool writeFriendSuggestions(const string &fileName, size_t k,
+                              SuggestionScore scoring =
+                                  SuggestionScore::MUTUAL_FRIENDS);
+  /*-------------------------------------------------------------------------
+    Compute suggestions for every user in parallel and stream them to a
+    file, one line per user.
+
+    Preconditions:
+      - 'fileName' is a valid filename.
+
+    Postconditions: Returns false if the file cannot be opened.
+    */
+
+  ReorderStats reorder(ReorderStrategy strategy);
+  /*-------------------------------------------------------------------------
+    Relabel the vertices of flatGraph() so that connected users get nearby
+    IDs (degree sort, Reverse Cuthill-McKee or Gorder). The new order is
+    kept across later rebuilds of the flat graph.
+
+    Preconditions: None.
+
+    Postconditions: flatGraph() and its username <-> ID dictionary use the
+    new order; returns the average neighbor-ID gap before and after.
+    Vertex IDs obtained earlier are no longer valid.
+    */
+
+  /***** Influence Ranking *****/
+  PageRankResult calculatePageRank(const PageRankOptions &options =
+                                       PageRankOptions());
+  /*-------------------------------------------------------------------------
+    Rank users by influence with PageRank over the weighted connections.
+    The power iteration starts from the scores of the previous run (new
+    users start at the average), so refreshing after a few mutations only
+    takes a few iterations.
+
+    Preconditions: None.
+
+    Postconditions: Returns the scores, indexed by the vertex IDs of
+    flatGraph(), and remembers them for the next run.
+    */
+
+  vector<pair<UserProfile *, double>>
+  topInfluencers(size_t k, const PageRankOptions &options = PageRankOptions());
+  /*-------------------------------------------------------------------------
+    Get the 'k' users with the highest PageRank.
+
+    Preconditions: None.
+
+    Postconditions: Returns up to 'k' (user, score) pairs, best first.
+    */
+
+  vector<pair<UserProfile *, double>>
+  personalizedPageRank(const string &userName, size_t k,
+                       const PageRankOptions &options = PageRankOptions());
+  /*-------------------------------------------------------------------------
+    Rank users by influence as seen from one user (personalized PageRank:
+    every random jump returns to 'userName').
+
+    Preconditions: None.
+
+    Postconditions: Returns up to 'k' other users with their scores, best
+    first; empty if the user is not found.
+    */
+
+  vector<pair<UserProfile *, double>>
+  recommendByRandomWalk(const string &userName, size_t k,
+                        const RandomWalkOptions &options =
+                            RandomWalkOptions());
+  /*-------------------------------------------------------------------------
+    Recommend users with Monte Carlo random walks with restart from
+    'userName', following connections in proportion to their weight. A
+    cheaper, local alternative to personalizedPageRank: the walks run on
+    the latest snapshot(), so the cost depends only on the users they
+    reach.
+
+    Preconditions: None.
+
+    Postconditions: Returns up to 'k' (user, share of visits) pairs, best
+    first; empty if the user is not found.
+    */
+
+  /***** Brokerage *****/
+  BetweennessResult calculateBetweenness(const BetweennessOptions &options =
+                                             BetweennessOptions());
+  /*-------------------------------------------------------------------------
+    Measure how often each user lies on the shortest paths between other
+    users (betweenness centrality). Exact by default; set 'samples' or
+    'epsilon' in the options for a faster sampled estimate.
+
+    Preconditions: None.
+
+    Postconditions: Returns the scores, indexed by the vertex IDs of
+    flatGraph().
+    */
+
+  vector<pair<UserProfile *, double>>
+  topBrokers(size_t k, const BetweennessOptions &options =
+                           BetweennessOptions());
+  /*-------------------------------------------------------------------------
+    Get the 'k' users with the highest betweenness: the brokers that
+    connect otherwise distant parts of the network.
+
+    Preconditions: None.
+
+    Postconditions: Returns up to 'k' (user, score) pairs, best first.
+    */
+
+  /***** Communities *****/
+  CommunityResult detectCommunities(const CommunityOptions &options =
+                                        CommunityOptions());
+  /*-------------------------------------------------------------------------
+    Split users into communities: groups densely connected inside and
+    loosely connected to each other. Louvain by default; set the method to
+    LABEL_PROPAGATION for a faster, parallel, lower-quality result.
+
+    Preconditions: None.
+
+    Postconditions: Returns the community of every user, indexed by the
+    vertex IDs of flatGraph(), and the modularity of the partition.
+    */
+
+  /***** Core Decomposition *****/
+  vector<uint32_t> coreNumbers(bool parallel = false);
+  /*-------------------------------------------------------------------------
+    Compute the core number of every user: the largest k such that the
+    user belongs to a group where everyone has at least k connections
+    inside the group. Low core numbers flag weakly embedded accounts.
+
+    Preconditions: None.
+
+    Postconditions: Returns the core numbers, indexed by the vertex IDs of
+    flatGraph(). 'parallel' peels level by level on all workers, for very
+    large graphs; the result is the same.
+    */
+
+  FlatGraph kCoreSubgraph(uint32_t k, bool parallel = false);
+  /*-------------------------------------------------------------------------
+    Extract the k-core: the users with core number at least 'k' and the
+    connections between them.
+
+    Preconditions: None.
+
+    Postconditions: Returns the k-core as a flat graph with its own vertex
+    IDs (empty if no user has core number 'k').
+    */
+
+  /***** Connected Components *****/
+  int componentOf(const string &userName);
+  /*-------------------------------------------------------------------------
+    Get the component (group of users reachable from each other) that a
+    user belongs to.
+
+    Preconditions: None.
+
+    Postconditions: Returns an ID shared by exactly the users of the same
+    component, or -1 if the user is not found. IDs are only meaningful
+    until the next mutation.
+    */
+
+  bool sameComponent(const string &userName1, const string &userName2);
+  /*-------------------------------------------------------------------------
+    Check whether two users can reach each other through connections,
+    without a traversal.
+
+    Preconditions: None.
+
+    Postconditions: Returns true if both users exist and are in the same
+    component.
+    */
+
+  int getNumOfComponents();
+  /*-------------------------------------------------------------------------
+    Get the number of connected components.
+
+    Preconditions: None.
+
+    Postconditions: Returns the number of components (isolated users count
+    as components of size 1).
+    */
+
+  map<size_t, size_t> getComponentSizeHistogram();
+  /*-------------------------------------------------------------------------
+    Get how many components there are of each size.
+
+    Preconditions: None.
+
+    Postconditions: Returns a map from component size to component count.
+    */
+
   /***** Graph Operations *****/
   void clearGraph();
   /*-------------------------------------------------------------------------
@@ -211,6 +683,8 @@ public:
       - 'startUserName' is a valid username in the graph.
 
   Postconditions: Returns a vector containing the usernames visited during DFS.
+  The traversal sees one published version: concurrent mutations are
+  either entirely visible or not at all.
 */
   vector<string> bfsTraversal(const string &startUserName);
   /*-------------------------------------------------------------------------
@@ -220,6 +694,72 @@ Perform Breadth First Search (BFS) traversal starting from the specified user.
       - 'startUserName' is a valid username in the graph.
 
 Postconditions: Returns a vector containing the usernames visited during BFS.
+  The traversal sees one published version: concurrent mutations are
+  either entirely visible or not at all.
+    */
+  shared_ptr<DistanceMatrix>
+  allPairsDistances(const vector<string> &userNames, bool weighted = true);
+  /*-------------------------------------------------------------------------
+    Compute the shortest-path distances between every pair of the given
+    users (a community, a company's employees, ...), through connections
+    among those users only. Meant for up to tens of thousands of users:
+    the matrix holds one 2- or 4-byte entry per pair.
+
+    Preconditions: None.
+
+    Postconditions: Returns the matrix; unknown users are reported and left
+    out. Distances count hops unless 'weighted'.
+    */
+
+  EgoNetwork kHopNeighborhood(const string &userName, uint32_t k,
+                              size_t limit = SIZE_MAX) const;
+  /*-------------------------------------------------------------------------
+    Get the users within 'k' hops of a user (the ego network), e.g. friends
+    of friends for k = 2. Unlike bfsTraversal, the search stops at depth
+    'k' or after 'limit' users instead of exploring the whole component.
+    It runs on the latest snapshot(), so a query after a write does not
+    wait for a flat copy to be rebuilt.
+
+    Preconditions: None.
+
+    Postconditions: Returns the reached users by name, the hop of each and
+    the number of users per hop. Empty if the user is not found.
+    */
+
+  KHopResult kHopSubgraph(const string &userName, uint32_t k,
+                          size_t limit = SIZE_MAX);
+  /*-------------------------------------------------------------------------
+    Run the same search on flatGraph() and build the subgraph the reached
+    users induce together with 'userName'.
+
+    Preconditions: None.
+
+    Postconditions: Returns the reached users as vertex IDs of flatGraph(),
+    the hop of each, the number of users per hop and the induced subgraph.
+    Empty if the user is not found.
+    */
+  shared_ptr<ShardedGraph> shardedGraph(size_t shardCount);
+  /*-------------------------------------------------------------------------
+    Split flatGraph() into 'shardCount' hash-partitioned shards that run
+    BFS, k-hop and component queries as message-passing supersteps, one
+    thread per shard, to measure cross-shard traffic before scaling out.
+
+    Preconditions: 'shardCount' > 0.
+
+    Postconditions: Returns a sharded copy with the vertex IDs of
+    flatGraph().
+    */
+  PartitionResult partition(const PartitionOptions &options =
+                                PartitionOptions());
+  /*-------------------------------------------------------------------------
+    Split the users into balanced parts that cut as little connection
+    weight as possible, e.g. as the shard assignment of shardedGraph()
+    instead of hashing.
+
+    Preconditions: options.parts > 0.
+
+    Postconditions: Returns the part of every vertex of flatGraph(), the
+    edge cut and the balance.
     */
   vector<UserProfile *> astar(const string &startUserName,
                               const string &goalUserName);
@@ -266,7 +806,8 @@ Postconditions: Returns a vector containing the usernames visited during BFS.
     Postconditions: Returns a vector containing the usernames representing the
     shortest path between the nodes.
     */
-  void generateDOTFile(const string &fileName);
+  void generateDOTFile(const string &fileName,
+                       bool colorByCommunity = false);
   /*-------------------------------------------------------------------------
     Generate a DOT file representation of the graph.
 
@@ -274,6 +815,8 @@ Postconditions: Returns a vector containing the usernames visited during BFS.
       - 'fileName' is a valid filename for the DOT file.
 
     Postconditions: Generates a DOT file representing the graph structure.
+    With 'colorByCommunity', users are filled with the color of their
+    community (detectCommunities() with the default options).
     */
   void renderGraph(const string &dotFileName, const string &outputFileName);
   /*-------------------------------------------------------------------------
@@ -301,15 +844,125 @@ Postconditions: Returns a vector containing the usernames visited during BFS.
 
     Postconditions: Returns the diameter of the graph.
   -------------------------------------------------------------------------*/
+  shared_ptr<AnalyticsJob<int>> submitDiameter();
+  /*-------------------------------------------------------------------------
+    Calculate the diameter in the background, on a snapshot of the graph.
+
+    Preconditions: None.
+
+    Postconditions: Returns at once; the job's result is what
+    calculateDiameter() returns for the graph as it is now, whatever
+    mutations follow. A cancelled job has no result (get() throws
+    JobCancelled).
+  -------------------------------------------------------------------------*/
+  template <typename T>
+  shared_ptr<AnalyticsJob<T>>
+  submitAnalytics(function<T(const FlatGraph &, JobContext &)> analytic);
+  /*-------------------------------------------------------------------------
+    Run any whole-graph analytic in the background on an immutable
+    snapshot (the current flatGraph()).
+
+    Preconditions:
+      - 'analytic' only reads the snapshot it is given, and should report
+        progress and poll for cancellation through the JobContext.
+
+    Postconditions: Returns at once with the job's handle; the graph may be
+    mutated while the job runs.
+  -------------------------------------------------------------------------*/
+  void cancelJobs();
+  /*-------------------------------------------------------------------------
+    Cancel every background job.
+
+    Preconditions: None.
+
+    Postconditions: Running jobs stop at their next cancellation check.
+  -------------------------------------------------------------------------*/
+  TriangleStats calculateTriangles();
+  /*-------------------------------------------------------------------------
+    Count triangles per user and overall, with local clustering
+    coefficients, average clustering and transitivity (parallel).
+
+    Preconditions: None.
+
+    Postconditions: Returns the statistics; per-user vectors are indexed by
+    the vertex IDs of flatGraph().
+  -------------------------------------------------------------------------*/
+  double calculateClusteringCoefficient(const string &userName);
+  /*-------------------------------------------------------------------------
+    Calculate the local clustering coefficient of one user: the fraction of
+    pairs of their connections that are connected to each other.
+
+    Preconditions: None.
+
+    Postconditions: Returns the coefficient, or 0 if the user is not found
+    or has fewer than two connections.
+  -------------------------------------------------------------------------*/
+
+  /***** Persistence *****/
+  bool openStorage(const string &directory,
+                   const StorageOptions &options = StorageOptions(),
+                   RecoveryStats *stats = nullptr);
+  /*-------------------------------------------------------------------------
+    Restore the graph saved in 'directory' (the last checkpoint, then the
+    mutations logged after it) and log every later mutation there. A
+    thread-safe graph also checkpoints every checkpointIntervalSeconds in
+    the background.
+
+    Preconditions: The graph is empty.
+
+    Postconditions: Returns false (after reporting) if the directory, the
+    checkpoint or the log cannot be used; the graph is then not logged and
+    may hold part of the saved data. 'stats', if given, describes what was
+    restored.
+  -------------------------------------------------------------------------*/
+
+  bool checkpoint(CheckpointStats *stats = nullptr);
+  /*-------------------------------------------------------------------------
+    Save the adjacency blocks changed since the last checkpoint and drop
+    the log records it covers, so that the next openStorage() replays a
+    short log. The changed blocks are encoded under the write lock, so
+    mutations and locking readers wait for that but not for the writes;
+    snapshot() readers never wait.
+
+    Preconditions: openStorage() succeeded.
+
+    Postconditions: Returns false (after reporting) on an I/O error; the
+    previous checkpoint and the log are then still valid, and the blocks
+    are written by the next checkpoint.
+  -------------------------------------------------------------------------*/
+
+  bool closeStorage();
+  /*-------------------------------------------------------------------------
+    Stop the background checkpoints, take a last checkpoint and close the
+    log. Called by the destructor.
+
+    Preconditions: None.
+
+    Postconditions: Later mutations are not logged. Returns false if the
+    last checkpoint failed; the log then still holds its mutations.
+  -------------------------------------------------------------------------*/
+
+  bool syncStorage();
+  LogStats storageStats() const;
+  /*-------------------------------------------------------------------------
+    syncStorage() waits until every logged mutation is on the disk (they
+    are otherwise committed in batches, within LogOptions::
+    commitIntervalMicros); storageStats() reports the log counters.
+
+    Preconditions: None.
+
+    Postconditions: syncStorage() returns false if the log failed.
+  -------------------------------------------------------------------------*/
 
 private:
   /***** Private Functions *****/
-  void dfsUtil(const string &node, unordered_set<string> &visited,
-               vector<string> &path);
+  void dfsUtil(const GraphVersion &snapshot, const string &node,
+               unordered_set<string> &visited, vector<string> &path);
   /*-------------------------------------------------------------------------
     Utility function for Depth First Search (DFS) traversal.
 
     Parameters:
+      - 'snapshot': The version of the graph being traversed.
       - 'node': The current node being visited.
       - 'visited': Set containing visited nodes.
       - 'path': Vector representing the path traversed during DFS.
@@ -339,9 +992,174 @@ private:
                        from the source node to all other nodes.
   -------------------------------------------------------------------------*/
 
+  bool changeProfile(UserProfile &user, const string &newUserName,
+                     const string &firstName, const string &lastName,
+                     const string &email) override;
+  /*-------------------------------------------------------------------------
+    UserProfileListener hook called by the setters of a graph-owned
+    profile; the work of updateProfile().
+
+    Preconditions:
+      - 'user' belongs to this graph.
+
+    Postconditions:
+      - A change to a username or email already used by another user is
+        rejected; otherwise the user is re-keyed and re-indexed.
+  -------------------------------------------------------------------------*/
+
+  const list<Connection *> &connectionsOf(string_view userName) const;
+
+  struct PublishScope
+  {
+    explicit PublishScope(Graph &graph);
+    ~PublishScope();
+    Graph &graph;
+  };
+  /*-------------------------------------------------------------------------
+    Taken by every mutator after its write lock. Nested mutations (e.g.
+    removeUser -> deleteConnectionsOfUser) publish one version together.
+
+    Preconditions: None.
+
+    Postconditions: When the outermost scope ends outside a batch, the
+    changed users are published to 'versions'.
+  -------------------------------------------------------------------------*/
+
+  void publishVersion();
+
+  void logMutation(LogOp op, initializer_list<string_view> args,
+                   int32_t weight = 0);
+  /*-------------------------------------------------------------------------
+    Append a mutation to the storage log.
+
+    Preconditions: Called by a mutator, after it succeeded, under its write
+    lock.
+
+    Postconditions: Logged only if storage is open and the mutation is not
+    nested in another one (removeUser logs itself, not the
+    deleteConnectionsOfUser it runs).
+  -------------------------------------------------------------------------*/
+
+  void applyLogRecord(const LogRecord &record);
+  /*-------------------------------------------------------------------------
+    Redo a logged mutation during openStorage().
+
+    Preconditions: The log is not open yet.
+
+    Postconditions: The mutation is applied through the public mutators.
+  -------------------------------------------------------------------------*/
+
+  bool restoreCheckpoint();
+  /*-------------------------------------------------------------------------
+    Rebuild the users and connections of the saved blocks.
+
+    Preconditions: 'checkpoints' is open; under the write lock.
+
+    Postconditions: Returns false if a block is corrupt. Connections are
+    linked directly, without checking for duplicates.
+  -------------------------------------------------------------------------*/
+
+  void linkUsers(Connection *connection);
+  /*-------------------------------------------------------------------------
+    Store a connection in both adjacency lists and update the counters.
+
+    Preconditions: Under a PublishScope; the users are not connected yet.
+
+    Postconditions: The connection is part of the graph.
+  -------------------------------------------------------------------------*/
+
+  void degreeChanged(const string &userName, size_t from, size_t to);
+  /*-------------------------------------------------------------------------
+    Move a user between buckets of the degree histogram.
+
+    Preconditions:
+      - The user's degree was 'from' and is now 'to'.
+
+    Postconditions:
+      - 'degreeCounts' and 'maxDegree' are updated; users not in 'users'
+        are ignored.
+  -------------------------------------------------------------------------*/
+
+  PageRankResult calculatePageRank(const shared_ptr<const FlatGraph> &flat,
+                                   const PageRankOptions &options);
+  /*-------------------------------------------------------------------------
+    Run PageRank over the given flat graph, so callers that also resolve
+    vertex IDs use the same version the scores were computed on.
+
+    Preconditions:
+      - 'flat' was returned by flatGraph().
+
+    Postconditions:
+      - Same as the public overload.
+  -------------------------------------------------------------------------*/
+
+  void refreshComponents();
+  /*-------------------------------------------------------------------------
+    Rebuild the union-find from the current users and connections if a
+    removal made it stale.
+
+    Preconditions: None.
+
+    Postconditions: 'components' reflects the current graph.
+  -------------------------------------------------------------------------*/
+  /*-------------------------------------------------------------------------
+    Look up the adjacency list of a user without inserting into 'adj'.
+
+    Parameters:
+      - 'userName': The user whose connections are requested.
+
+    Preconditions: None.
+
+    Postconditions:
+      - Returns the user's connection list, or an empty list if the user has
+        no entry in 'adj'.
+  -------------------------------------------------------------------------*/
+
   /***** Member Variables *****/
-  unordered_map<string, UserProfile *> users;    // user profiles
-  unordered_map<string, list<Connection *>> adj; // adjacency list
+  ReaderWriterLock graphLock;          // queries shared, mutations exclusive
+  FlatHashMap<UserProfile *> users;    // user profiles
+  FlatHashMap<list<Connection *>> adj; // adjacency list
+  UserIndex index;                     // email and name indexes
+  TrigramIndex fuzzyIndex;             // typo-tolerant name search
+  UnionFind components;                // connected components
+  FlatHashMap<uint32_t> componentIds;  // username -> union-find element
+  bool componentsStale;                // rebuild before next query
+  size_t adjacencyEntries;             // sum of adjacency list lengths
+  long long totalWeight;               // sum of connection weights
+  vector<size_t> degreeCounts;         // users per degree
+  size_t maxDegree;                    // highest degree with users
+  FlatHashMap<double> lastPageRank;    // warm start for PageRank
+  FlatHashMap<uint32_t> vertexRank;    // username -> flat vertex position
+  unsigned long long version;          // mutation counter
+  mutable shared_ptr<const FlatGraph> flatCache; // CSR copy of the graph
+  mutable unsigned long long flatCacheVersion;   // version it was built at
+  mutable shared_ptr<const CompressedGraph> compressedCache; // encoded copy
+  mutable unsigned long long compressedCacheVersion; // version it was built at
+  mutable recursive_mutex cacheLock;   // caches filled in by queries
+  VersionedAdjacency versions;         // snapshots for lock-free readers
+  FlatHashMap<GraphVersion::NeighborList> neighborLists; // published 'adj'
+  vector<string> dirtyUsers;           // changed by the current mutation
+  unsigned mutationDepth;              // nested PublishScopes
+  unsigned batchDepth;                 // nested beginBatch() calls
+  bool rebuildVersion;                 // publish a whole new version
+  MutationLog mutationLog;             // write-ahead log of mutations
+  string storageDirectory;             // checkpoint and log location
+  CheckpointStore checkpoints;         // blocks of the last checkpoint
+  vector<bool> dirtyBlocks;            // blocks changed since then
+  mutex checkpointLock;                // one checkpoint at a time
+  PeriodicTask checkpointer;           // background checkpoints
+  JobRunner jobs;                      // background analytics
 };
 
+// Submit an analytic over a snapshot of the graph
+template <typename T>
+shared_ptr<AnalyticsJob<T>>
+Graph::submitAnalytics(function<T(const FlatGraph &, JobContext &)> analytic)
+{
+  shared_ptr<const FlatGraph> snapshot = flatGraph();
+  return jobs.submit<T>([snapshot, analytic](JobContext &context) {
+    return analytic(*snapshot, context);
+  });
+}
+
 #endif
\ No newline at end of file
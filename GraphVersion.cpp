@@ -0,0 +1,293 @@
+#include "GraphVersion.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+
+namespace
+{
+typedef GraphVersion::UserEntry UserEntry;
+
+// Order block entries by user name
+bool entryBefore(const shared_ptr<const UserEntry> &entry, string_view name)
+{
+  return string_view(entry->userName) < name;
+}
+} // namespace
+
+// Block of a user
+size_t GraphVersion::blockOf(string_view userName)
+{
+  return hash<string_view>()(userName) % BLOCKS;
+}
+
+// Visit the entries of one block
+void GraphVersion::forEachInBlock(
+    size_t block, const function<void(const UserEntry &)> &visit) const
+{
+  const shared_ptr<const Page> &page = pages[block / FANOUT];
+  if (!page)
+  {
+    return;
+  }
+  const shared_ptr<const Block> &entries = (*page)[block % FANOUT];
+  if (!entries)
+  {
+    return;
+  }
+  for (const shared_ptr<const UserEntry> &entry : *entries)
+  {
+    visit(*entry);
+  }
+}
+
+// Look up a user
+const GraphVersion::UserEntry *GraphVersion::find(string_view userName) const
+{
+  size_t block = blockOf(userName);
+  const shared_ptr<const Page> &page = pages[block / FANOUT];
+  if (!page)
+  {
+    return nullptr;
+  }
+  const shared_ptr<const Block> &entries = (*page)[block % FANOUT];
+  if (!entries)
+  {
+    return nullptr;
+  }
+  auto it = lower_bound(entries->begin(), entries->end(), userName,
+                        entryBefore);
+  return it != entries->end() && (*it)->userName == userName ? it->get()
+                                                             : nullptr;
+}
+
+// Look up the connections of a user
+const GraphVersion::NeighborList &
+GraphVersion::neighborsOf(string_view userName) const
+{
+  static const NeighborList noNeighbors;
+  const UserEntry *entry = find(userName);
+  return entry ? entry->neighbors : noNeighbors;
+}
+
+// Get a chunk to change, copying it if another list shares it
+GraphVersion::NeighborList::Chunk &
+GraphVersion::NeighborList::writable(size_t chunk)
+{
+  shared_ptr<Chunk> &shared = chunks[chunk];
+  // Versions let go of their copies only in publish(), which runs under
+  // the same writer's lock as this edit
+  if (shared.use_count() == 1)
+  {
+    return *shared;
+  }
+  shared = make_shared<Chunk>(*shared);
+  return *shared;
+}
+
+// Append a neighbor to the last chunk, or to a new one if it is full
+void GraphVersion::NeighborList::push_back(const Neighbor &neighbor)
+{
+  if (chunks.empty() || chunks.back()->size() == CHUNK)
+  {
+    chunks.push_back(make_shared<Chunk>());
+  }
+  writable(chunks.size() - 1).push_back(neighbor);
+  ++count;
+}
+
+// Find the chunk and position of a neighbor; chunks.size() if absent
+size_t GraphVersion::NeighborList::chunkOf(string_view userName,
+                                           size_t &position) const
+{
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+  {
+    const Chunk &neighbors = *chunks[chunk];
+    for (position = 0; position < neighbors.size(); ++position)
+    {
+      if (neighbors[position].userName == userName)
+      {
+        return chunk;
+      }
+    }
+  }
+  return chunks.size();
+}
+
+// Remove a neighbor, merging its chunk with the next one if both fit
+bool GraphVersion::NeighborList::erase(string_view userName)
+{
+  size_t position;
+  size_t chunk = chunkOf(userName, position);
+  if (chunk == chunks.size())
+  {
+    return false;
+  }
+  Chunk &neighbors = writable(chunk);
+  neighbors.erase(neighbors.begin() + position);
+  // Keeps removals from leaving a list of slivers
+  if (chunk + 1 < chunks.size() &&
+      neighbors.size() + chunks[chunk + 1]->size() <= CHUNK)
+  {
+    const Chunk &next = *chunks[chunk + 1];
+    neighbors.insert(neighbors.end(), next.begin(), next.end());
+    chunks.erase(chunks.begin() + chunk + 1);
+  }
+  if (neighbors.empty())
+  {
+    chunks.erase(chunks.begin() + chunk);
+  }
+  --count;
+  return true;
+}
+
+// Rename a neighbor in place
+bool GraphVersion::NeighborList::rename(string_view userName,
+                                        const string &newUserName)
+{
+  size_t position;
+  size_t chunk = chunkOf(userName, position);
+  if (chunk == chunks.size())
+  {
+    return false;
+  }
+  writable(chunk)[position].userName = newUserName;
+  return true;
+}
+
+// Constructor for a pinned version
+GraphSnapshot::GraphSnapshot(EpochManager *epochs, size_t slot,
+                             const GraphVersion *version)
+    : epochs(epochs), slot(slot), version(version)
+{
+}
+
+// Move constructor
+GraphSnapshot::GraphSnapshot(GraphSnapshot &&other)
+    : epochs(other.epochs), slot(other.slot), version(other.version)
+{
+  other.epochs = nullptr;
+}
+
+// Destructor: unpin
+GraphSnapshot::~GraphSnapshot()
+{
+  if (epochs != nullptr)
+  {
+    epochs->exit(slot);
+  }
+}
+
+// Constructor: an empty first version
+VersionedAdjacency::VersionedAdjacency()
+{
+  GraphVersion *first = new GraphVersion();
+  first->versionNumber = 0;
+  first->users = 0;
+  first->adjacencyEntries = 0;
+  current.store(first);
+}
+
+// Destructor
+VersionedAdjacency::~VersionedAdjacency()
+{
+  delete current.load();
+  // 'epochs' frees the retired versions
+}
+
+// Pin the latest version
+GraphSnapshot VersionedAdjacency::pin() const
+{
+  // Announce the epoch before loading, so the version cannot be freed
+  size_t slot = epochs.enter();
+  return GraphSnapshot(&epochs, slot, current.load());
+}
+
+// Build and publish the next version
+void VersionedAdjacency::publish(const vector<Change> &changes,
+                                 bool replaceAll)
+{
+  const GraphVersion *previous = current.load();
+  GraphVersion *next = new GraphVersion();
+  next->versionNumber = previous->versionNumber + 1;
+  if (replaceAll)
+  {
+    next->users = 0;
+    next->adjacencyEntries = 0;
+  }
+  else
+  {
+    // Share every page until it is changed
+    next->users = previous->users;
+    next->adjacencyEntries = previous->adjacencyEntries;
+    next->pages = previous->pages;
+  }
+
+  // Group the changes by block; the last change of a user wins
+  map<size_t, map<string_view, const Change *>> byBlock;
+  for (const Change &change : changes)
+  {
+    byBlock[GraphVersion::blockOf(change.first)][change.first] = &change;
+  }
+
+  shared_ptr<GraphVersion::Page> page;
+  size_t pageIndex = GraphVersion::FANOUT;
+  for (const auto &blockChanges : byBlock)
+  {
+    size_t block = blockChanges.first;
+    if (block / GraphVersion::FANOUT != pageIndex)
+    {
+      // Copy the page on its first change
+      pageIndex = block / GraphVersion::FANOUT;
+      const shared_ptr<const GraphVersion::Page> &old = next->pages[pageIndex];
+      page = old ? make_shared<GraphVersion::Page>(*old)
+                 : make_shared<GraphVersion::Page>();
+      next->pages[pageIndex] = page;
+    }
+
+    // Copy the block and apply its changes in name order
+    shared_ptr<const GraphVersion::Block> &slot =
+        (*page)[block % GraphVersion::FANOUT];
+    GraphVersion::Block entries;
+    if (slot)
+    {
+      entries = *slot;
+    }
+    for (const auto &userChange : blockChanges.second)
+    {
+      const Change &change = *userChange.second;
+      auto it = lower_bound(entries.begin(), entries.end(), userChange.first,
+                            entryBefore);
+      bool present = it != entries.end() && (*it)->userName == change.first;
+      if (present)
+      {
+        --next->users;
+        next->adjacencyEntries -= (*it)->neighbors.size();
+      }
+      if (change.second)
+      {
+        ++next->users;
+        next->adjacencyEntries += change.second->neighbors.size();
+        if (present)
+        {
+          *it = change.second;
+        }
+        else
+        {
+          entries.insert(it, change.second);
+        }
+      }
+      else if (present)
+      {
+        entries.erase(it);
+      }
+    }
+    slot = entries.empty()
+               ? nullptr
+               : make_shared<const GraphVersion::Block>(std::move(entries));
+  }
+
+  // Readers that already pinned 'previous' keep it until they unpin
+  current.store(next);
+  epochs.retire([previous]() { delete previous; });
+  epochs.collect();
+}
@@ -0,0 +1,280 @@
+/******************************************************************************
+    Multi-version adjacency for consistent reads during mutations:
+    GraphVersion: One immutable version of the users and their connections.
+    GraphSnapshot: A pinned version; keeps it alive while in scope.
+    VersionedAdjacency: Publishes new versions copy-on-write and reclaims
+     old ones by epoch.
+ * ****************************************************************************
+ * */
+
+#ifndef GRAPHVERSION_H
+#define GRAPHVERSION_H
+
+#include "EpochManager.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: GraphVersion
+ *
+ * Description: Immutable copy of the adjacency as of one mutation. Users
+ *              are hashed into FANOUT x FANOUT blocks, reached through
+ *              FANOUT pages; each block holds its users' entries sorted by
+ *              name. A new version copies only the root, the pages and
+ *              blocks of the users that changed, and those users' entries,
+ *              whose neighbor lists share their chunks: everything else is
+ *              shared with the previous version.
+ *
+ * Member Variables:
+ *    - versionNumber: Position in the sequence of published versions.
+ *    - users: Number of user entries.
+ *    - adjacencyEntries: Sum of the neighbor list lengths.
+ *    - pages: Root of the block tree; null pages and blocks are empty.
+ *
+ *****************************************************************************/
+class GraphVersion
+{
+public:
+  static const size_t FANOUT = 64;
+  static const size_t BLOCKS = FANOUT * FANOUT;
+
+  struct Neighbor
+  {
+    string userName; // the connected user
+    int weight;      // connection weight
+  };
+
+  /**************************************************************************
+   * Class: NeighborList
+   *
+   * Description: A user's connections in chunks of at most CHUNK
+   *              neighbors. Chunks are shared by copies of the list, so a
+   *              copy costs one pointer per chunk; an edit copies the
+   *              chunk it changes if another copy shares it, and changes
+   *              it in place otherwise.
+   *
+   * Member Variables:
+   *    - chunks: The neighbors, in order; no chunk is empty.
+   *    - count: Number of neighbors.
+   *
+   *************************************************************************/
+  class NeighborList
+  {
+  public:
+    static const size_t CHUNK = 64;
+
+    class const_iterator
+    {
+    public:
+      const_iterator(const NeighborList *list, size_t chunk)
+          : list(list), chunk(chunk), position(0) {}
+      const Neighbor &operator*() const
+      {
+        return (*list->chunks[chunk])[position];
+      }
+      const Neighbor *operator->() const { return &**this; }
+      const_iterator &operator++()
+      {
+        if (++position == list->chunks[chunk]->size())
+        {
+          ++chunk;
+          position = 0;
+        }
+        return *this;
+      }
+      bool operator==(const const_iterator &other) const
+      {
+        return chunk == other.chunk && position == other.position;
+      }
+      bool operator!=(const const_iterator &other) const
+      {
+        return !(*this == other);
+      }
+
+    private:
+      const NeighborList *list; // the list walked
+      size_t chunk;             // current chunk
+      size_t position;          // neighbor within the chunk
+    };
+
+    NeighborList() : count(0) {}
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, chunks.size()); }
+
+    void push_back(const Neighbor &neighbor);
+    bool erase(string_view userName);
+    bool rename(string_view userName, const string &newUserName);
+    /*-----------------------------------------------------------------------
+      Append a neighbor; remove or rename the first neighbor named
+      'userName'.
+
+      Preconditions: Copies held by published versions are released only
+                     by VersionedAdjacency::publish(), never concurrently
+                     with an edit.
+      Postconditions: erase() and rename() return false if no neighbor is
+                      named 'userName'. Other copies of the list are not
+                      changed.
+    -----------------------------------------------------------------------*/
+
+  private:
+    typedef vector<Neighbor> Chunk;
+    size_t chunkOf(string_view userName, size_t &position) const;
+    Chunk &writable(size_t chunk);
+
+    /***** Member Variables *****/
+    vector<shared_ptr<Chunk>> chunks; // the neighbors, in order
+    size_t count;                           // number of neighbors
+  };
+
+  struct UserEntry
+  {
+    string userName;        // the user
+    NeighborList neighbors; // connections, in insertion order
+  };
+
+  /***** Queries *****/
+  uint64_t number() const { return versionNumber; }
+  size_t userCount() const { return users; }
+  size_t connectionCount() const { return adjacencyEntries / 2; }
+
+  const UserEntry *find(string_view userName) const;
+  /*-------------------------------------------------------------------------
+    Look up a user.
+
+    Preconditions: None.
+    Postconditions: Returns nullptr if the user is not in this version.
+  -------------------------------------------------------------------------*/
+
+  const NeighborList &neighborsOf(string_view userName) const;
+  /*-------------------------------------------------------------------------
+    Look up a user's connections.
+
+    Preconditions: None.
+    Postconditions: Returns an empty list if the user is not in this
+                    version.
+  -------------------------------------------------------------------------*/
+
+  static size_t blockOf(string_view userName);
+  void forEachInBlock(size_t block,
+                      const function<void(const UserEntry &)> &visit) const;
+  /*-------------------------------------------------------------------------
+    blockOf() is the block (below BLOCKS) that holds a user's entry;
+    forEachInBlock() visits the entries of one block in name order.
+
+    Preconditions: 'block' < BLOCKS.
+    Postconditions: An empty block visits nothing.
+  -------------------------------------------------------------------------*/
+
+private:
+  friend class VersionedAdjacency;
+  typedef vector<shared_ptr<const UserEntry>> Block; // sorted by name
+  typedef array<shared_ptr<const Block>, FANOUT> Page;
+
+  /***** Member Variables *****/
+  uint64_t versionNumber;                     // publish sequence number
+  size_t users;                               // user entries
+  size_t adjacencyEntries;                    // neighbor list entries
+  array<shared_ptr<const Page>, FANOUT> pages; // block tree root
+};
+
+/******************************************************************************
+ * Class: GraphSnapshot
+ *
+ * Description: A reader's pin on one GraphVersion. While the snapshot is
+ *              in scope the version stays valid and unchanged, however
+ *              many versions writers publish meanwhile.
+ *
+ * Member Variables:
+ *    - epochs: Reclamation of the versions; nullptr once moved from.
+ *    - slot: The reader slot pinned in 'epochs'.
+ *    - version: The pinned version.
+ *
+ *****************************************************************************/
+class GraphSnapshot
+{
+public:
+  GraphSnapshot(GraphSnapshot &&other);
+  GraphSnapshot(const GraphSnapshot &) = delete;
+  GraphSnapshot &operator=(const GraphSnapshot &) = delete;
+  ~GraphSnapshot();
+
+  const GraphVersion &operator*() const { return *version; }
+  const GraphVersion *operator->() const { return version; }
+
+private:
+  friend class VersionedAdjacency;
+  GraphSnapshot(EpochManager *epochs, size_t slot,
+                const GraphVersion *version);
+
+  /***** Member Variables *****/
+  EpochManager *epochs;        // unpinned on destruction
+  size_t slot;                 // reader slot
+  const GraphVersion *version; // the pinned version
+};
+
+/******************************************************************************
+ * Class: VersionedAdjacency
+ *
+ * Description: The published GraphVersion and its history. Readers pin the
+ *              current version without locking; a writer builds the next
+ *              version copy-on-write from a batch of changed users,
+ *              publishes it with one atomic store and retires the previous
+ *              one to the epoch manager, so writers never wait for readers
+ *              and a reader never sees part of a batch.
+ *
+ * Member Variables:
+ *    - current: The latest published version.
+ *    - epochs: Reader pins and retired versions.
+ *
+ *****************************************************************************/
+class VersionedAdjacency
+{
+public:
+  typedef pair<string, shared_ptr<const GraphVersion::UserEntry>> Change;
+
+  VersionedAdjacency();
+  VersionedAdjacency(const VersionedAdjacency &) = delete;
+  VersionedAdjacency &operator=(const VersionedAdjacency &) = delete;
+  ~VersionedAdjacency();
+
+  GraphSnapshot pin() const;
+  /*-------------------------------------------------------------------------
+    Pin the latest version.
+
+    Preconditions: None.
+    Postconditions: The snapshot sees exactly the changes of the batches
+                    published before this call.
+  -------------------------------------------------------------------------*/
+
+  void publish(const vector<Change> &changes, bool replaceAll);
+  /*-------------------------------------------------------------------------
+    Publish the next version.
+
+    Preconditions: One writer at a time. Each change names a user and its
+                   new entry, or nullptr to remove the user.
+    Postconditions: With 'replaceAll' the new version holds only the
+                    changed users; otherwise it is the previous version
+                    with the changes applied. Unreachable old versions are
+                    freed.
+  -------------------------------------------------------------------------*/
+
+  size_t retainedVersions() { return epochs.pendingCount(); }
+
+private:
+  /***** Member Variables *****/
+  atomic<const GraphVersion *> current; // latest version
+  mutable EpochManager epochs;          // pins and reclamation
+};
+
+#endif // END OF THE HEADER FILE
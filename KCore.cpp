@@ -0,0 +1,218 @@
+#include "KCore.h"
+#include "AnalyticsJob.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+typedef FlatGraph::Vertex Vertex;
+
+// Vertices peeled between progress reports of the sequential mode
+const size_t REPORT_EVERY = 4096;
+
+// Bucket peeling (Batagelj and Zaversnik)
+vector<uint32_t> peelSequential(const FlatGraph &graph, JobContext *context)
+{
+  size_t n = graph.vertexCount();
+  vector<uint32_t> degree(n);
+  uint32_t maxDegree = 0;
+  for (Vertex v = 0; v < n; ++v)
+  {
+    degree[v] = graph.degree(v);
+    maxDegree = max(maxDegree, degree[v]);
+  }
+
+  // Counting sort by degree: 'order' holds the vertices, 'start[d]' the
+  // first slot of bucket d and 'position[v]' the slot of v
+  vector<uint32_t> start(maxDegree + 2, 0);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    ++start[degree[v] + 1];
+  }
+  for (uint32_t d = 1; d < start.size(); ++d)
+  {
+    start[d] += start[d - 1];
+  }
+  vector<Vertex> order(n);
+  vector<uint32_t> position(n);
+  vector<uint32_t> next(start.begin(), start.end() - 1);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    position[v] = next[degree[v]]++;
+    order[position[v]] = v;
+  }
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (context != nullptr && i % REPORT_EVERY == 0 && i > 0)
+    {
+      context->advance(REPORT_EVERY);
+      if (context->cancelled())
+      {
+        break;
+      }
+    }
+    Vertex v = order[i];
+    for (uint32_t j = 0; j < graph.degree(v); ++j)
+    {
+      Vertex u = graph.neighbors(v)[j];
+      if (degree[u] > degree[v])
+      {
+        // Swap u with the first vertex of its bucket, then shrink the
+        // bucket from the front so u lands in bucket degree[u] - 1
+        uint32_t du = degree[u];
+        uint32_t pu = position[u];
+        uint32_t pw = start[du];
+        Vertex w = order[pw];
+        if (u != w)
+        {
+          order[pu] = w;
+          position[w] = pu;
+          order[pw] = u;
+          position[u] = pw;
+        }
+        ++start[du];
+        --degree[u];
+      }
+    }
+  }
+  return degree;
+}
+
+// Level-synchronous peeling over the parallelFor workers
+vector<uint32_t> peelParallel(const FlatGraph &graph, JobContext *context)
+{
+  size_t n = graph.vertexCount();
+  unique_ptr<atomic<uint32_t>[]> degree(new atomic<uint32_t>[n]);
+  vector<uint32_t> core(n);
+  vector<uint8_t> removed(n, 0);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    degree[v].store(graph.degree(v), memory_order_relaxed);
+  }
+
+  unsigned workers = workerCount();
+  vector<vector<Vertex>> found(workers);
+  vector<uint32_t> lowest(workers);
+  vector<Vertex> frontier;
+  size_t remaining = n;
+  uint32_t level = 0;
+  while (remaining > 0)
+  {
+    if (context != nullptr && context->cancelled())
+    {
+      break;
+    }
+    // Collect the vertices at this level; note the lowest degree above it
+    fill(lowest.begin(), lowest.end(), UINT32_MAX);
+    parallelFor(0, n, 4096, [&](size_t lo, size_t hi, unsigned worker) {
+      for (size_t v = lo; v < hi; ++v)
+      {
+        if (removed[v])
+        {
+          continue;
+        }
+        uint32_t d = degree[v].load(memory_order_relaxed);
+        if (d <= level)
+        {
+          found[worker].push_back(static_cast<Vertex>(v));
+        }
+        else
+        {
+          lowest[worker] = min(lowest[worker], d);
+        }
+      }
+    });
+    frontier.clear();
+    for (auto &part : found)
+    {
+      frontier.insert(frontier.end(), part.begin(), part.end());
+      part.clear();
+    }
+    if (frontier.empty())
+    {
+      level = *min_element(lowest.begin(), lowest.end());
+      continue;
+    }
+
+    // Remove the frontier; neighbors that fall to the level join the next
+    while (!frontier.empty())
+    {
+      for (Vertex v : frontier)
+      {
+        removed[v] = 1;
+        core[v] = level;
+      }
+      remaining -= frontier.size();
+      if (context != nullptr)
+      {
+        context->advance(frontier.size());
+      }
+      parallelFor(0, frontier.size(), 64,
+                  [&](size_t lo, size_t hi, unsigned worker) {
+                    for (size_t i = lo; i < hi; ++i)
+                    {
+                      Vertex v = frontier[i];
+                      for (uint32_t j = 0; j < graph.degree(v); ++j)
+                      {
+                        Vertex u = graph.neighbors(v)[j];
+                        if (removed[u] ||
+                            degree[u].load(memory_order_relaxed) <= level)
+                        {
+                          continue;
+                        }
+                        uint32_t before =
+                            degree[u].fetch_sub(1, memory_order_relaxed);
+                        if (before == level + 1)
+                        {
+                          found[worker].push_back(u);
+                        }
+                        else if (before <= level)
+                        {
+                          // Lost a race below the level; undo
+                          degree[u].fetch_add(1, memory_order_relaxed);
+                        }
+                      }
+                    }
+                  });
+      frontier.clear();
+      for (auto &part : found)
+      {
+        frontier.insert(frontier.end(), part.begin(), part.end());
+        part.clear();
+      }
+    }
+    ++level;
+  }
+  return core;
+}
+} // namespace
+
+// Core number of every vertex
+vector<uint32_t> computeCoreNumbers(const FlatGraph &graph, bool parallel,
+                                    JobContext *context)
+{
+  if (context != nullptr)
+  {
+    context->setTotal(graph.vertexCount());
+  }
+  return parallel ? peelParallel(graph, context)
+                  : peelSequential(graph, context);
+}
+
+// Vertices of the k-core
+vector<FlatGraph::Vertex> kCoreVertices(const vector<uint32_t> &coreNumbers,
+                                        uint32_t k)
+{
+  vector<FlatGraph::Vertex> vertices;
+  for (FlatGraph::Vertex v = 0; v < coreNumbers.size(); ++v)
+  {
+    if (coreNumbers[v] >= k)
+    {
+      vertices.push_back(v);
+    }
+  }
+  return vertices;
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+    k-core decomposition:
+    computeCoreNumbers: Core number of every vertex of a flat graph.
+    kCoreVertices: Vertices of the k-core, given the core numbers.
+ * ****************************************************************************
+ * */
+
+#ifndef KCORE_H
+#define KCORE_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class JobContext;
+
+/******************************************************************************
+ * Function: computeCoreNumbers
+ *
+ * Purpose: The core number of a vertex is the largest k such that it
+ *          belongs to a subgraph where every vertex has at least k
+ *          neighbors. Sequential mode is the O(V + E) bucket peeling of
+ *          Batagelj and Zaversnik: vertices sorted by degree in buckets,
+ *          always removing a minimum-degree vertex and moving its
+ *          neighbors down one bucket in O(1). Parallel mode peels level by
+ *          level instead: all vertices of the current level are removed
+ *          at once by the parallelFor workers, which decrement neighbor
+ *          degrees atomically and collect the vertices that drop to the
+ *          level into the next frontier. 'context' (if any) receives
+ *          progress per peeled vertex and can cancel the peeling.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns the core numbers, indexed by vertex ID. Both
+ *                 modes give the same result. A cancelled run is partial.
+ *****************************************************************************/
+vector<uint32_t> computeCoreNumbers(const FlatGraph &graph,
+                                    bool parallel = false,
+                                    JobContext *context = nullptr);
+
+/******************************************************************************
+ * Function: kCoreVertices
+ *
+ * Purpose: Select the vertices whose core number is at least 'k'; they
+ *          form the k-core (possibly empty).
+ *
+ * Preconditions: 'coreNumbers' comes from computeCoreNumbers.
+ *
+ * Postconditions: Returns the vertex IDs in increasing order.
+ *****************************************************************************/
+vector<FlatGraph::Vertex> kCoreVertices(const vector<uint32_t> &coreNumbers,
+                                        uint32_t k);
+
+#endif // END OF THE HEADER FILE
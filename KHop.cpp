@@ -0,0 +1,156 @@
+#include "KHop.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+// Visited marks of the calling thread: stamp[v] == epoch means visited
+struct VisitStamps
+{
+  vector<uint32_t> stamp;
+  uint32_t epoch = 0;
+
+  // Start a query over 'n' vertices; returns its epoch
+  uint32_t begin(size_t n)
+  {
+    if (stamp.size() < n)
+    {
+      stamp.resize(n, 0);
+    }
+    if (++epoch == 0)
+    {
+      // Wrapped around: old stamps could match again
+      fill(stamp.begin(), stamp.end(), 0);
+      epoch = 1;
+    }
+    return epoch;
+  }
+};
+
+thread_local VisitStamps visits;
+
+// Visited users of the calling thread's version query; empty between calls
+thread_local unordered_set<string_view> visitedUsers;
+} // namespace
+
+// Bounded breadth-first search
+KHopResult kHopNeighborhood(const FlatGraph &graph, FlatGraph::Vertex source,
+                            uint32_t k, size_t limit, bool induce)
+{
+  KHopResult result;
+  result.hopCounts.assign(k + 1, 0);
+  result.hopCounts[0] = 1;
+  result.truncated = false;
+
+  uint32_t epoch = visits.begin(graph.vertexCount());
+  vector<uint32_t> &stamp = visits.stamp;
+  stamp[source] = epoch;
+
+  // The result doubles as the BFS queue, with the source in front until
+  // the search ends; hop h occupies [levelBegin, levelEnd)
+  vector<FlatGraph::Vertex> &queue = result.vertices;
+  queue.push_back(source);
+  size_t levelBegin = 0;
+  for (uint32_t hop = 1; hop <= k && !result.truncated; ++hop)
+  {
+    size_t levelEnd = queue.size();
+    for (size_t i = levelBegin; i < levelEnd && !result.truncated; ++i)
+    {
+      FlatGraph::Vertex v = queue[i];
+      for (uint32_t j = 0; j < graph.degree(v); ++j)
+      {
+        FlatGraph::Vertex u = graph.neighbors(v)[j];
+        if (stamp[u] == epoch)
+        {
+          continue;
+        }
+        if (queue.size() - 1 == limit)
+        {
+          result.truncated = true;
+          break;
+        }
+        stamp[u] = epoch;
+        queue.push_back(u);
+        result.hops.push_back(hop);
+        ++result.hopCounts[hop];
+      }
+    }
+    if (queue.size() == levelEnd)
+    {
+      break; // nothing new reached; deeper hops are empty too
+    }
+    levelBegin = levelEnd;
+  }
+  queue.erase(queue.begin());
+
+  if (induce)
+  {
+    vector<FlatGraph::Vertex> members(result.vertices);
+    members.push_back(source);
+    result.subgraph =
+        make_shared<const FlatGraph>(graph.inducedSubgraph(members));
+  }
+  return result;
+}
+
+// Bounded breadth-first search over a graph version
+EgoNetwork kHopNeighborhood(const GraphVersion &graph, string_view source,
+                            uint32_t k, size_t limit)
+{
+  EgoNetwork result;
+  result.truncated = false;
+  const GraphVersion::UserEntry *entry = graph.find(source);
+  if (entry == nullptr)
+  {
+    return result;
+  }
+  result.hopCounts.assign(k + 1, 0);
+  result.hopCounts[0] = 1;
+
+  // Names point into the pinned version; hop h occupies
+  // [levelBegin, levelEnd) of the queue, the source in front
+  vector<string_view> queue{entry->userName};
+  visitedUsers.insert(queue.front());
+  size_t levelBegin = 0;
+  for (uint32_t hop = 1; hop <= k && !result.truncated; ++hop)
+  {
+    size_t levelEnd = queue.size();
+    for (size_t i = levelBegin; i < levelEnd && !result.truncated; ++i)
+    {
+      for (const GraphVersion::Neighbor &neighbor :
+           graph.neighborsOf(queue[i]))
+      {
+        if (visitedUsers.count(neighbor.userName) != 0)
+        {
+          continue;
+        }
+        if (queue.size() - 1 == limit)
+        {
+          result.truncated = true;
+          break;
+        }
+        visitedUsers.insert(neighbor.userName);
+        queue.push_back(neighbor.userName);
+        result.hops.push_back(hop);
+        ++result.hopCounts[hop];
+      }
+    }
+    if (queue.size() == levelEnd)
+    {
+      break; // nothing new reached; deeper hops are empty too
+    }
+    levelBegin = levelEnd;
+  }
+
+  // Leave the set empty: its names belong to this version
+  result.users.reserve(queue.size() - 1);
+  for (size_t i = 0; i < queue.size(); ++i)
+  {
+    visitedUsers.erase(queue[i]);
+    if (i > 0)
+    {
+      result.users.emplace_back(queue[i]);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+    Bounded k-hop neighborhood (ego network) queries:
+    KHopResult: Vertices reached, their hop distance and per-hop counts.
+    EgoNetwork: The same for a graph version, by username.
+    kHopNeighborhood: Breadth-first search limited by depth and result count.
+ * ****************************************************************************
+ * */
+
+#ifndef KHOP_H
+#define KHOP_H
+
+#include "FlatGraph.h"
+#include "GraphVersion.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+struct KHopResult
+{
+  vector<FlatGraph::Vertex> vertices;  // reached vertices in BFS order
+  vector<uint32_t> hops;               // hop distance of each entry above
+  vector<size_t> hopCounts;            // vertices per hop; [0] is the source
+  bool truncated;                      // stopped early by the limit
+  shared_ptr<const FlatGraph> subgraph; // induced subgraph, if asked for
+};
+
+struct EgoNetwork
+{
+  vector<string> users;     // reached users in BFS order
+  vector<uint32_t> hops;    // hop distance of each entry above
+  vector<size_t> hopCounts; // users per hop; [0] is the source
+  bool truncated;           // stopped early by the limit
+};
+
+/******************************************************************************
+ * Function: kHopNeighborhood
+ *
+ * Purpose: Breadth-first search from 'source' that stops after 'k' hops or
+ *          once 'limit' vertices have been reached, so a query only costs
+ *          the part of the graph it returns. Visited vertices are marked
+ *          with the query's epoch in a per-thread stamp array, so no set is
+ *          allocated or cleared per query. Optionally builds the subgraph
+ *          induced by the source and the reached vertices.
+ *
+ * Preconditions: 'source' is less than graph.vertexCount().
+ *
+ * Postconditions: Returns the reached vertices (source excluded), at most
+ *                 'limit' of them. hopCounts has k + 1 entries. Safe to
+ *                 call concurrently from different threads.
+ *****************************************************************************/
+KHopResult kHopNeighborhood(const FlatGraph &graph, FlatGraph::Vertex source,
+                            uint32_t k, size_t limit, bool induce = false);
+
+/******************************************************************************
+ * Function: kHopNeighborhood
+ *
+ * Purpose: The same bounded search over a pinned GraphVersion, following
+ *          the users' neighbor lists by name, so no flat copy of the graph
+ *          has to be built first. Visited users go into a per-thread hash
+ *          set that is emptied entry by entry afterwards, so a query only
+ *          costs the neighborhood it returns.
+ *
+ * Preconditions: 'graph' stays pinned during the call.
+ *
+ * Postconditions: Returns the reached users (source excluded), at most
+ *                 'limit' of them. hopCounts has k + 1 entries; all of it
+ *                 is empty if 'source' is not in the version. Safe to call
+ *                 concurrently from different threads.
+ *****************************************************************************/
+EgoNetwork kHopNeighborhood(const GraphVersion &graph, string_view source,
+                            uint32_t k, size_t limit);
+
+#endif // END OF THE HEADER FILE
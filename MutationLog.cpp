@@ -0,0 +1,329 @@
+#include "MutationLog.h"
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+const size_t HEADER_BYTES = 8; // payload length, payload CRC
+
+// Decode the next record; false if it is incomplete or corrupt
+bool readRecord(ByteReader &input, LogRecord &record)
+{
+  uint32_t size, checksum;
+  if (!input.u32(size) || !input.u32(checksum) || size > input.remaining())
+  {
+    return false;
+  }
+  const char *payload = input.position();
+  if (crc32(payload, size) != checksum)
+  {
+    return false;
+  }
+  ByteReader fields(payload, size);
+  uint8_t op;
+  uint32_t weight;
+  uint16_t argCount;
+  if (!fields.u64(record.lsn) || !fields.u8(op) || !fields.u32(weight) ||
+      !fields.u16(argCount) || op < static_cast<uint8_t>(LogOp::AddUser) ||
+      op > static_cast<uint8_t>(LogOp::UpdateProfile))
+  {
+    return false;
+  }
+  record.op = static_cast<LogOp>(op);
+  record.weight = static_cast<int32_t>(weight);
+  record.args.resize(argCount);
+  for (string &arg : record.args)
+  {
+    if (!fields.str(arg))
+    {
+      return false;
+    }
+  }
+  return input.skip(size);
+}
+} // namespace
+
+// Constructor
+MutationLog::MutationLog()
+    : appendedLsn(0), durableLsn(0), writing(false), syncWaiters(0),
+      failed(false), stopping(false), records(0), bytes(0), commits(0)
+{
+}
+
+// Destructor: commit what is pending
+MutationLog::~MutationLog() { close(); }
+
+// Apply the valid records of a log
+bool MutationLog::replay(const string &fileName, uint64_t afterLsn,
+                         const function<void(const LogRecord &)> &apply,
+                         LogReplayStats &stats)
+{
+  stats = LogReplayStats{0, 0, 0, false};
+  string contents;
+  if (!readWholeFile(fileName, contents))
+  {
+    return true; // no log yet
+  }
+  ByteReader input(contents.data(), contents.size());
+  LogRecord record;
+  while (input.remaining() > 0)
+  {
+    if (!readRecord(input, record))
+    {
+      // A crash cut the last write short; everything before it is valid
+      stats.tornTail = true;
+      break;
+    }
+    stats.lastLsn = record.lsn;
+    stats.validBytes = contents.size() - input.remaining();
+    if (record.lsn > afterLsn)
+    {
+      apply(record);
+      ++stats.records;
+    }
+  }
+  return true;
+}
+
+// Start appending after a replay
+bool MutationLog::open(const string &fileName, const LogReplayStats &replayed,
+                       uint64_t lastLsn, const LogOptions &options)
+{
+  close();
+  if (!file.open(fileName))
+  {
+    return false;
+  }
+  if (file.size() > replayed.validBytes && !file.truncate(replayed.validBytes))
+  {
+    file.close();
+    return false;
+  }
+  this->fileName = fileName;
+  this->options = options;
+  appendedLsn = durableLsn = lastLsn;
+  pending.clear();
+  writing = failed = stopping = false;
+  syncWaiters = 0;
+  records = bytes = commits = 0;
+  if (options.commitIntervalMicros > 0)
+  {
+    committer = thread(&MutationLog::committerMain, this);
+  }
+  return true;
+}
+
+// Commit and stop
+void MutationLog::close()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    if (!file.isOpen())
+    {
+      return;
+    }
+    stopping = true;
+  }
+  work.notify_all();
+  if (committer.joinable())
+  {
+    committer.join();
+  }
+  lock_guard<mutex> guard(lock);
+  file.close();
+}
+
+// Whether records are being appended; truncateThrough() reopens the file
+bool MutationLog::isOpen() const
+{
+  lock_guard<mutex> guard(lock);
+  return file.isOpen();
+}
+
+// Log one mutation
+uint64_t MutationLog::append(LogOp op, initializer_list<string_view> args,
+                             int32_t weight)
+{
+  unique_lock<mutex> guard(lock);
+  uint64_t lsn = ++appendedLsn;
+  size_t start = pending.size();
+  bool wasEmpty = start == 0;
+
+  // Header placeholder, then the payload
+  pending.append(HEADER_BYTES, '\0');
+  ByteWriter payload(pending);
+  payload.u64(lsn);
+  payload.u8(static_cast<uint8_t>(op));
+  payload.u32(static_cast<uint32_t>(weight));
+  payload.u16(static_cast<uint16_t>(args.size()));
+  for (string_view arg : args)
+  {
+    payload.str(arg);
+  }
+  size_t size = pending.size() - start - HEADER_BYTES;
+  string header;
+  ByteWriter frame(header);
+  frame.u32(static_cast<uint32_t>(size));
+  frame.u32(crc32(pending.data() + start + HEADER_BYTES, size));
+  pending.replace(start, HEADER_BYTES, header);
+  ++records;
+  bytes += size + HEADER_BYTES;
+
+  if (options.commitIntervalMicros == 0)
+  {
+    // No batching: the record is on the disk before returning
+    while (durableLsn < lsn && !failed)
+    {
+      if (writing)
+      {
+        committed.wait(guard);
+      }
+      else
+      {
+        writePending(guard);
+      }
+    }
+  }
+  else if (wasEmpty || pending.size() >= options.maxBatchBytes)
+  {
+    work.notify_one();
+  }
+  return lsn;
+}
+
+// Wait for the records appended so far to be on the disk
+bool MutationLog::sync()
+{
+  unique_lock<mutex> guard(lock);
+  if (!file.isOpen())
+  {
+    return !failed;
+  }
+  uint64_t target = appendedLsn;
+  if (options.commitIntervalMicros == 0)
+  {
+    committed.wait(guard, [&] { return durableLsn >= target || failed; });
+    return !failed;
+  }
+  ++syncWaiters;
+  work.notify_one();
+  committed.wait(guard, [&] { return durableLsn >= target || failed; });
+  --syncWaiters;
+  return !failed;
+}
+
+// Drop the records a checkpoint covers
+bool MutationLog::truncateThrough(uint64_t lsn)
+{
+  if (!sync())
+  {
+    return false;
+  }
+  unique_lock<mutex> guard(lock);
+  // Records appended since sync() wait in 'pending' until we are done
+  committed.wait(guard, [&] { return !writing; });
+
+  string contents;
+  if (!readWholeFile(fileName, contents))
+  {
+    cerr << "Error: cannot read " << fileName << endl;
+    return false;
+  }
+  ByteReader input(contents.data(), contents.size());
+  size_t keepFrom = contents.size();
+  LogRecord record;
+  while (input.remaining() > 0)
+  {
+    size_t offset = contents.size() - input.remaining();
+    if (!readRecord(input, record))
+    {
+      break;
+    }
+    if (record.lsn > lsn)
+    {
+      keepFrom = offset;
+      break;
+    }
+  }
+  if (keepFrom == contents.size())
+  {
+    return file.truncate(0);
+  }
+
+  // Rewrite the log with only its newer records
+  file.close();
+  bool replaced = replaceFileDurably(fileName, contents.substr(keepFrom));
+  if (!file.open(fileName))
+  {
+    failed = true;
+    return false;
+  }
+  return replaced;
+}
+
+// Last appended LSN
+uint64_t MutationLog::lastLsn() const
+{
+  lock_guard<mutex> guard(lock);
+  return appendedLsn;
+}
+
+// Counters since open
+LogStats MutationLog::stats() const
+{
+  lock_guard<mutex> guard(lock);
+  return LogStats{appendedLsn, durableLsn, records, bytes, commits};
+}
+
+// Group commit thread
+void MutationLog::committerMain()
+{
+  unique_lock<mutex> guard(lock);
+  for (;;)
+  {
+    work.wait(guard, [&] { return stopping || !pending.empty(); });
+    if (!stopping && syncWaiters == 0)
+    {
+      // Let the commit window collect more records
+      work.wait_for(guard, chrono::microseconds(options.commitIntervalMicros),
+                    [&] {
+                      return stopping || syncWaiters > 0 ||
+                             pending.size() >= options.maxBatchBytes;
+                    });
+    }
+    writePending(guard);
+    if (stopping && pending.empty())
+    {
+      return;
+    }
+  }
+}
+
+// Write and fsync the pending records, outside the lock
+bool MutationLog::writePending(unique_lock<mutex> &guard)
+{
+  if (pending.empty() || failed)
+  {
+    pending.clear();
+    return !failed;
+  }
+  string batch;
+  batch.swap(pending);
+  uint64_t batchLsn = appendedLsn;
+  writing = true;
+  guard.unlock();
+  bool written = file.append(batch.data(), batch.size()) && file.sync();
+  guard.lock();
+  writing = false;
+  ++commits;
+  if (written)
+  {
+    durableLsn = batchLsn;
+  }
+  else
+  {
+    failed = true; // reported by DurableFile
+  }
+  committed.notify_all();
+  return written;
+}
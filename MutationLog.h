@@ -0,0 +1,200 @@
+/******************************************************************************
+    Implementation of MutationLog class:
+    LogOp / LogRecord: One logged graph mutation.
+    replay: Read the valid records of a log, in order.
+    open / close: Start and stop appending to a log.
+    append: Add a record; it becomes durable with the next group commit.
+    sync: Wait until every appended record is on the disk.
+    truncateThrough: Drop the records a checkpoint already covers.
+ * ****************************************************************************
+ * */
+
+#ifndef MUTATIONLOG_H
+#define MUTATIONLOG_H
+
+#include "DurableIO.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum class LogOp : uint8_t
+{
+  AddUser = 1,       // userName, firstName, lastName, email
+  RemoveUser,        // userName
+  AddConnection,     // source, destination; weight
+  RemoveConnection,  // source, destination
+  DeleteConnections, // userName
+  ClearGraph,        // -
+  ClearUsers,        // -
+  UpdateProfile      // oldUserName, userName, firstName, lastName, email
+};
+
+struct LogRecord
+{
+  uint64_t lsn;         // log sequence number, increasing
+  LogOp op;             // mutation
+  int32_t weight;       // connection weight (AddConnection)
+  vector<string> args;  // names, see LogOp
+};
+
+struct LogOptions
+{
+  unsigned commitIntervalMicros = 1000; // group commit window; 0 = fsync
+                                        // every record before returning
+  size_t maxBatchBytes = 1 << 20;       // commit early past this backlog
+};
+
+struct LogReplayStats
+{
+  size_t records;      // records applied
+  uint64_t lastLsn;    // last valid record (0 if none)
+  uint64_t validBytes; // length of the valid prefix of the file
+  bool tornTail;       // bytes after it were cut off or corrupt
+};
+
+struct LogStats
+{
+  uint64_t appendedLsn; // last record appended
+  uint64_t durableLsn;  // last record known to be on the disk
+  uint64_t records;     // records appended since open
+  uint64_t bytes;       // bytes appended since open
+  uint64_t commits;     // fsyncs since open
+};
+
+/******************************************************************************
+ * Class: MutationLog
+ *
+ * Description: Append-only write-ahead log of graph mutations. Each record
+ *              is framed by its length and a CRC-32, so that a record
+ *              torn by a crash is detected and dropped on replay. Appends
+ *              only encode the record into a buffer; a committer thread
+ *              writes the buffer and fsyncs it once per commit window
+ *              (group commit), so one fsync covers every mutation of the
+ *              window. A crash can therefore lose at most the last window
+ *              of mutations, and never leaves a partial one applied; sync()
+ *              is the durability point for callers that cannot lose any.
+ *
+ * Member Variables:
+ *    - file: The log file.
+ *    - fileName: Its path.
+ *    - options: Commit window and batch size.
+ *    - lock: Guards everything below it.
+ *    - pending: Encoded records not yet written.
+ *    - appendedLsn / durableLsn: Last appended and last synced record.
+ *    - writing: The committer is writing a batch outside the lock.
+ *    - syncWaiters: Callers of sync() waiting for a commit.
+ *    - failed: A write or fsync failed; the log no longer commits.
+ *    - stopping: close() was called.
+ *    - records / bytes / commits: Counters for stats().
+ *    - work: Wakes the committer.
+ *    - committed: Signals finished commits.
+ *    - committer: The group commit thread.
+ *
+ *****************************************************************************/
+class MutationLog
+{
+public:
+  MutationLog();
+  MutationLog(const MutationLog &) = delete;
+  MutationLog &operator=(const MutationLog &) = delete;
+  ~MutationLog();
+
+  static bool replay(const string &fileName, uint64_t afterLsn,
+                     const function<void(const LogRecord &)> &apply,
+                     LogReplayStats &stats);
+  /*-------------------------------------------------------------------------
+    Call 'apply' on every record of the log with an LSN above 'afterLsn',
+    in log order, stopping at the first torn or corrupt record.
+
+    Preconditions: None. A missing log counts as empty.
+    Postconditions: Returns false only if the file exists but cannot be
+                    read. 'stats' describes the valid prefix.
+  -------------------------------------------------------------------------*/
+
+  bool open(const string &fileName, const LogReplayStats &replayed,
+            uint64_t lastLsn, const LogOptions &options = LogOptions());
+  /*-------------------------------------------------------------------------
+    Start appending after a replay: cut the file to its valid prefix and
+    number new records after 'lastLsn'.
+
+    Preconditions: The log is not open; 'replayed' comes from replay() of
+                   the same file.
+    Postconditions: Returns false (after reporting) if the file cannot be
+                    opened.
+  -------------------------------------------------------------------------*/
+
+  void close();
+  /*-------------------------------------------------------------------------
+    Commit the pending records and stop the committer.
+
+    Preconditions: None.
+    Postconditions: isOpen() is false.
+  -------------------------------------------------------------------------*/
+
+  bool isOpen() const;
+
+  uint64_t append(LogOp op, initializer_list<string_view> args,
+                  int32_t weight = 0);
+  /*-------------------------------------------------------------------------
+    Log one mutation.
+
+    Preconditions: The log is open. Appends are made in the order the
+                   mutations were applied.
+    Postconditions: Returns the record's LSN. The record is durable after
+                    the next commit (at most commitIntervalMicros later),
+                    or already, with a commit interval of 0.
+  -------------------------------------------------------------------------*/
+
+  bool sync();
+  /*-------------------------------------------------------------------------
+    Wait until every record appended so far is on the disk.
+
+    Preconditions: None.
+    Postconditions: Returns false if a write or fsync failed.
+  -------------------------------------------------------------------------*/
+
+  bool truncateThrough(uint64_t lsn);
+  /*-------------------------------------------------------------------------
+    Drop the records up to 'lsn' once a checkpoint holds their effects.
+
+    Preconditions: The checkpoint covering 'lsn' is durable.
+    Postconditions: Records after 'lsn' are kept. Returns false (after
+                    reporting) on an I/O error; the log is then unchanged.
+  -------------------------------------------------------------------------*/
+
+  uint64_t lastLsn() const;
+  LogStats stats() const;
+
+private:
+  void committerMain();
+  bool writePending(unique_lock<mutex> &guard);
+
+  /***** Member Variables *****/
+  DurableFile file;             // the log file
+  string fileName;              // its path
+  LogOptions options;           // commit window and batch size
+  mutable mutex lock;           // guards the members below
+  string pending;               // encoded, not yet written
+  uint64_t appendedLsn;         // last appended record
+  uint64_t durableLsn;          // last synced record
+  bool writing;                 // a batch is being written
+  size_t syncWaiters;           // callers waiting in sync()
+  bool failed;                  // an I/O error stopped commits
+  bool stopping;                // close() called
+  uint64_t records;             // appended since open
+  uint64_t bytes;               // appended since open
+  uint64_t commits;             // fsyncs since open
+  condition_variable work;      // wakes the committer
+  condition_variable committed; // signals finished commits
+  thread committer;             // group commit thread
+};
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,132 @@
+#include "PageRank.h"
+#include "AnalyticsJob.h"
+#include "Parallel.h"
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+// Scale a vector so it sums to 1; fall back to uniform if it sums to 0
+void normalize(vector<double> &v)
+{
+  double sum = accumulate(v.begin(), v.end(), 0.0);
+  if (sum > 0.0)
+  {
+    for (double &x : v)
+    {
+      x /= sum;
+    }
+  }
+  else if (!v.empty())
+  {
+    v.assign(v.size(), 1.0 / v.size());
+  }
+}
+} // namespace
+
+// Constructor: lay out the column-normalized weights in CSR order
+PageRank::PageRank(const FlatGraph &graph, const PageRankOptions &options)
+    : graph(graph), options(options)
+{
+  size_t n = graph.vertexCount();
+  vector<double> outWeight(n, 0.0);
+  for (FlatGraph::Vertex v = 0; v < n; ++v)
+  {
+    if (graph.degree(v) == 0)
+    {
+      dangling.push_back(v);
+    }
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      outWeight[v] += options.weighted ? graph.weights(v)[i] : 1.0;
+    }
+  }
+
+  // Entry (v, u) carries the share of u's score that flows to v
+  const vector<FlatGraph::Vertex> &adjacency = graph.adjacencyArray();
+  const vector<int> &weights = graph.weightArray();
+  transition.resize(adjacency.size());
+  for (size_t e = 0; e < adjacency.size(); ++e)
+  {
+    double w = options.weighted ? weights[e] : 1.0;
+    transition[e] = w / outWeight[adjacency[e]];
+  }
+}
+
+// Power iteration
+PageRankResult PageRank::run(const vector<double> &warmStart,
+                             const vector<double> &teleport,
+                             JobContext *context) const
+{
+  size_t n = graph.vertexCount();
+  PageRankResult result;
+  result.iterations = 0;
+  result.residual = 0.0;
+  result.converged = true;
+  if (n == 0)
+  {
+    return result;
+  }
+
+  vector<double> jump = teleport.size() == n ? teleport
+                                             : vector<double>(n, 1.0 / n);
+  normalize(jump);
+  vector<double> rank = warmStart.size() == n ? warmStart : jump;
+  normalize(rank);
+
+  const vector<uint32_t> &offsets = graph.offsetArray();
+  const vector<FlatGraph::Vertex> &adjacency = graph.adjacencyArray();
+  const double d = options.damping;
+  vector<double> next(n);
+  vector<double> residuals(workerCount());
+  result.converged = false;
+  if (context != nullptr)
+  {
+    context->setTotal(options.maxIterations);
+  }
+  while (result.iterations < options.maxIterations)
+  {
+    if (context != nullptr && context->cancelled())
+    {
+      break;
+    }
+    double danglingMass = 0.0;
+    for (FlatGraph::Vertex v : dangling)
+    {
+      danglingMass += rank[v];
+    }
+    double base = (1.0 - d) + d * danglingMass;
+
+    // Sparse matrix-vector product, one block of rows per task
+    fill(residuals.begin(), residuals.end(), 0.0);
+    parallelFor(0, n, 1024, [&](size_t lo, size_t hi, unsigned worker) {
+      double change = 0.0;
+      for (size_t v = lo; v < hi; ++v)
+      {
+        double sum = 0.0;
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e)
+        {
+          sum += transition[e] * rank[adjacency[e]];
+        }
+        next[v] = d * sum + base * jump[v];
+        change += fabs(next[v] - rank[v]);
+      }
+      residuals[worker] += change;
+    });
+
+    rank.swap(next);
+    ++result.iterations;
+    if (context != nullptr)
+    {
+      context->advance();
+    }
+    result.residual = accumulate(residuals.begin(), residuals.end(), 0.0);
+    if (result.residual < options.tolerance)
+    {
+      result.converged = true;
+      break;
+    }
+  }
+  result.scores = std::move(rank);
+  return result;
+}
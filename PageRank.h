@@ -0,0 +1,93 @@
+/******************************************************************************
+    Implementation of PageRank class:
+    PageRank: Constructor preparing the normalized transition matrix.
+    run: Power iteration, optionally personalized and warm-started.
+ * ****************************************************************************
+ * */
+
+#ifndef PAGERANK_H
+#define PAGERANK_H
+
+#include "FlatGraph.h"
+#include <vector>
+
+using namespace std;
+
+class JobContext;
+
+struct PageRankOptions
+{
+  double damping = 0.85;     // probability of following a connection
+  double tolerance = 1e-9;   // stop when the L1 change drops below this
+  int maxIterations = 100;   // iteration cap
+  bool weighted = true;      // follow connections in proportion to weight
+};
+
+struct PageRankResult
+{
+  vector<double> scores; // score per vertex, summing to 1
+  int iterations;        // iterations performed
+  double residual;       // L1 change of the last iteration
+  bool converged;        // residual fell below the tolerance
+};
+
+/******************************************************************************
+ * Class: PageRank
+ *
+ * Description: PageRank as a power iteration of sparse matrix-vector
+ *              products over the flat graph. The transition weights are
+ *              laid out in CSR order once, so every iteration is a pull
+ *              over contiguous arrays: rank[v] = sum(weight[e] *
+ *              share[neighbor[e]]). Rows are split into blocks across the
+ *              parallelFor workers. Users without connections hand their
+ *              score back through the teleport vector.
+ *
+ * Member Variables:
+ *    - graph: The flat graph being ranked.
+ *    - options: Damping, tolerance, iteration cap, weighting.
+ *    - transition: Edge weight divided by the total weight of the
+ *                  neighbor it comes from, aligned with the adjacency.
+ *    - dangling: Vertices without connections.
+ *
+ *****************************************************************************/
+class PageRank
+{
+public:
+  /***** Constructors *****/
+  PageRank(const FlatGraph &graph, const PageRankOptions &options);
+  /*-------------------------------------------------------------------------
+    Prepare the transition weights of a flat graph.
+
+    Preconditions: 'graph' outlives the PageRank object.
+    Postconditions: run() can be called any number of times.
+  -------------------------------------------------------------------------*/
+
+  /***** Computation *****/
+  PageRankResult run(const vector<double> &warmStart = {},
+                     const vector<double> &teleport = {},
+                     JobContext *context = nullptr) const;
+  /*-------------------------------------------------------------------------
+    Run the power iteration.
+
+    Preconditions:
+      - 'warmStart' is empty or holds one (non-negative) score per vertex;
+        it is normalized before use. Starting from the previous scores
+        after a few mutations converges in far fewer iterations.
+      - 'teleport' is empty (uniform, classic PageRank) or holds one
+        non-negative weight per vertex (personalized PageRank).
+      - 'context' (if any) receives progress per iteration, out of the
+        iteration cap, and can cancel the run.
+
+    Postconditions: Returns the scores and convergence information; a
+    cancelled run stops unconverged.
+  -------------------------------------------------------------------------*/
+
+private:
+  /***** Member Variables *****/
+  const FlatGraph &graph;           // graph being ranked
+  PageRankOptions options;          // iteration settings
+  vector<double> transition;        // normalized weight per adjacency entry
+  vector<FlatGraph::Vertex> dangling; // vertices without connections
+};
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,15 @@
+#include "Parallel.h"
+#include "ThreadPool.h"
+
+// Number of workers used by parallelFor
+unsigned workerCount()
+{
+  return ThreadPool::shared().workerCount();
+}
+
+// Run a chunked loop on the shared pool
+void parallelFor(size_t begin, size_t end, size_t grain,
+                 const function<void(size_t, size_t, unsigned)> &body)
+{
+  ThreadPool::shared().parallelFor(begin, end, grain, body);
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+    Parallel loop helpers shared by the graph algorithms:
+    workerCount: Number of workers a parallel loop uses.
+    parallelFor: Run a loop body over [begin, end) in chunks on all workers.
+ * ****************************************************************************
+ * */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+/******************************************************************************
+ * Function: workerCount
+ *
+ * Purpose: Report how many workers parallelFor runs on (the size of the
+ *          shared ThreadPool, by default the hardware concurrency). Callers
+ *          size per-worker scratch buffers with it.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns a value >= 1.
+ *****************************************************************************/
+unsigned workerCount();
+
+/******************************************************************************
+ * Function: parallelFor
+ *
+ * Purpose: Split [begin, end) into chunks of 'grain' indexes and run
+ *          body(chunkBegin, chunkEnd, worker) on every chunk, on the shared
+ *          work-stealing ThreadPool. Idle workers steal half of a busy
+ *          worker's remaining chunks, so skewed chunks (e.g. hub users) do
+ *          not hold the other workers back. Loops may be nested.
+ *
+ * Preconditions:
+ *    - 'grain' > 0, or 0 to pick it from the loop size.
+ *    - 'body' is safe to call concurrently for different chunks.
+ *
+ * Postconditions: Returns after every chunk has run. 'worker' is in
+ *                 [0, workerCount()) and no two concurrent calls share it.
+ *****************************************************************************/
+void parallelFor(size_t begin, size_t end, size_t grain,
+                 const function<void(size_t, size_t, unsigned)> &body);
+
+#endif // END OF THE HEADER FILE
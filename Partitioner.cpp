@@ -0,0 +1,544 @@
+#include "Partitioner.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace
+{
+const uint32_t NONE = UINT32_MAX;
+
+// Weighted CSR graph used at every level
+struct WeightedGraph
+{
+  vector<uint32_t> offsets{0};
+  vector<uint32_t> adjacency;
+  vector<int64_t> edgeWeights;
+  vector<int64_t> vertexWeights;
+
+  size_t size() const { return vertexWeights.size(); }
+  int64_t totalWeight() const
+  {
+    return accumulate(vertexWeights.begin(), vertexWeights.end(),
+                      static_cast<int64_t>(0));
+  }
+};
+
+// Level-0 graph: unit vertex weights, connection weights (or 1)
+WeightedGraph fromFlatGraph(const FlatGraph &graph, bool weighted)
+{
+  WeightedGraph g;
+  g.offsets.assign(graph.offsetArray().begin(), graph.offsetArray().end());
+  g.adjacency.assign(graph.adjacencyArray().begin(),
+                     graph.adjacencyArray().end());
+  if (weighted)
+  {
+    g.edgeWeights.assign(graph.weightArray().begin(),
+                         graph.weightArray().end());
+  }
+  else
+  {
+    g.edgeWeights.assign(g.adjacency.size(), 1);
+  }
+  g.vertexWeights.assign(graph.vertexCount(), 1);
+  return g;
+}
+
+// Subgraph induced by the vertices with side[v] == keep
+WeightedGraph sideSubgraph(const WeightedGraph &g,
+                           const vector<uint8_t> &side, uint8_t keep,
+                           const vector<uint32_t> &ids,
+                           vector<uint32_t> &subIds)
+{
+  vector<uint32_t> local(g.size(), NONE);
+  subIds.clear();
+  for (uint32_t v = 0; v < g.size(); ++v)
+  {
+    if (side[v] == keep)
+    {
+      local[v] = static_cast<uint32_t>(subIds.size());
+      subIds.push_back(ids[v]);
+    }
+  }
+  WeightedGraph sub;
+  for (uint32_t v = 0; v < g.size(); ++v)
+  {
+    if (side[v] != keep)
+    {
+      continue;
+    }
+    for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e)
+    {
+      if (local[g.adjacency[e]] != NONE)
+      {
+        sub.adjacency.push_back(local[g.adjacency[e]]);
+        sub.edgeWeights.push_back(g.edgeWeights[e]);
+      }
+    }
+    sub.offsets.push_back(static_cast<uint32_t>(sub.adjacency.size()));
+    sub.vertexWeights.push_back(g.vertexWeights[v]);
+  }
+  return sub;
+}
+
+// Heavy-edge matching; returns false if the graph hardly shrinks
+bool coarsen(const WeightedGraph &fine, mt19937_64 &rng,
+             WeightedGraph &coarse, vector<uint32_t> &coarseOf)
+{
+  size_t n = fine.size();
+  vector<uint32_t> order(n);
+  iota(order.begin(), order.end(), 0);
+  shuffle(order.begin(), order.end(), rng);
+
+  // Match every vertex with its heaviest unmatched neighbor
+  vector<uint32_t> match(n, NONE);
+  for (uint32_t v : order)
+  {
+    if (match[v] != NONE)
+    {
+      continue;
+    }
+    uint32_t best = v;
+    int64_t bestWeight = -1;
+    for (uint32_t e = fine.offsets[v]; e < fine.offsets[v + 1]; ++e)
+    {
+      uint32_t u = fine.adjacency[e];
+      if (u == v || match[u] != NONE)
+      {
+        continue;
+      }
+      int64_t w = fine.edgeWeights[e];
+      // Ties go to the lighter neighbor, keeping coarse vertices even
+      if (w > bestWeight ||
+          (w == bestWeight && fine.vertexWeights[u] < fine.vertexWeights[best]))
+      {
+        best = u;
+        bestWeight = w;
+      }
+    }
+    match[v] = best;
+    match[best] = v;
+  }
+
+  // Number the pairs
+  coarseOf.assign(n, NONE);
+  vector<uint32_t> members; // fine vertices, pair by pair
+  members.reserve(n);
+  uint32_t coarseCount = 0;
+  for (uint32_t v = 0; v < n; ++v)
+  {
+    if (coarseOf[v] != NONE)
+    {
+      continue;
+    }
+    coarseOf[v] = coarseCount;
+    members.push_back(v);
+    if (match[v] != v)
+    {
+      coarseOf[match[v]] = coarseCount;
+      members.push_back(match[v]);
+    }
+    ++coarseCount;
+  }
+  if (coarseCount > n * 0.95)
+  {
+    return false;
+  }
+
+  // Merge the adjacency of each pair, summing parallel edges
+  coarse = WeightedGraph();
+  coarse.vertexWeights.assign(coarseCount, 0);
+  vector<uint32_t> position(coarseCount, NONE);
+  size_t m = 0;
+  for (uint32_t c = 0; c < coarseCount; ++c)
+  {
+    size_t start = coarse.adjacency.size();
+    for (int k = 0; k < 2 && m < members.size() && coarseOf[members[m]] == c;
+         ++k, ++m)
+    {
+      uint32_t f = members[m];
+      coarse.vertexWeights[c] += fine.vertexWeights[f];
+      for (uint32_t e = fine.offsets[f]; e < fine.offsets[f + 1]; ++e)
+      {
+        uint32_t cu = coarseOf[fine.adjacency[e]];
+        if (cu == c)
+        {
+          continue; // the matched edge disappears
+        }
+        if (position[cu] != NONE && position[cu] >= start)
+        {
+          coarse.edgeWeights[position[cu]] += fine.edgeWeights[e];
+        }
+        else
+        {
+          position[cu] = static_cast<uint32_t>(coarse.adjacency.size());
+          coarse.adjacency.push_back(cu);
+          coarse.edgeWeights.push_back(fine.edgeWeights[e]);
+        }
+      }
+    }
+    coarse.offsets.push_back(static_cast<uint32_t>(coarse.adjacency.size()));
+  }
+  return true;
+}
+
+// Cut weight of a bisection
+int64_t cutOf(const WeightedGraph &g, const vector<uint8_t> &side)
+{
+  int64_t cut = 0;
+  for (uint32_t v = 0; v < g.size(); ++v)
+  {
+    for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e)
+    {
+      if (side[g.adjacency[e]] != side[v])
+      {
+        cut += g.edgeWeights[e];
+      }
+    }
+  }
+  return cut / 2;
+}
+
+// Weight above the limits of both sides
+int64_t overweight(const int64_t weight[2], const int64_t limit[2])
+{
+  return max<int64_t>(0, weight[0] - limit[0]) +
+         max<int64_t>(0, weight[1] - limit[1]);
+}
+
+// Fiduccia-Mattheyses refinement of a bisection
+void refine(const WeightedGraph &g, vector<uint8_t> &side,
+            const int64_t limit[2], uint32_t passes)
+{
+  size_t n = g.size();
+  vector<int64_t> gain(n);
+  vector<uint8_t> locked(n);
+  vector<uint32_t> moves;
+  typedef pair<int64_t, uint32_t> Entry;
+
+  for (uint32_t pass = 0; pass < passes; ++pass)
+  {
+    // Gains: external minus internal weight
+    int64_t weight[2] = {0, 0};
+    int64_t cut = 0;
+    priority_queue<Entry> heap[2]; // lazy: stale entries are skipped
+    for (uint32_t v = 0; v < n; ++v)
+    {
+      weight[side[v]] += g.vertexWeights[v];
+    }
+    for (uint32_t v = 0; v < n; ++v)
+    {
+      int64_t external = 0, internal = 0;
+      for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e)
+      {
+        (side[g.adjacency[e]] != side[v] ? external : internal) +=
+            g.edgeWeights[e];
+      }
+      gain[v] = external - internal;
+      cut += external;
+      // Boundary vertices, and every vertex of an overweight side
+      if (external > 0 || weight[side[v]] > limit[side[v]])
+      {
+        heap[side[v]].push(Entry(gain[v], v));
+      }
+    }
+    cut /= 2;
+    fill(locked.begin(), locked.end(), 0);
+    moves.clear();
+
+    int64_t bestCut = cut;
+    int64_t bestExcess = overweight(weight, limit);
+    size_t bestMoves = 0;
+    size_t patience = max<size_t>(50, n / 100);
+    for (size_t sinceBest = 0; sinceBest < patience;)
+    {
+      // Best valid candidate of each side
+      uint32_t candidate[2] = {NONE, NONE};
+      for (int s = 0; s < 2; ++s)
+      {
+        while (!heap[s].empty())
+        {
+          Entry top = heap[s].top();
+          uint32_t v = top.second;
+          if (!locked[v] && side[v] == s && gain[v] == top.first)
+          {
+            candidate[s] = v;
+            break;
+          }
+          heap[s].pop();
+        }
+      }
+      int from = -1;
+      for (int s = 0; s < 2; ++s)
+      {
+        uint32_t v = candidate[s];
+        if (v == NONE)
+        {
+          continue;
+        }
+        bool fits = weight[1 - s] + g.vertexWeights[v] <= limit[1 - s] ||
+                    weight[s] > limit[s];
+        if (!fits)
+        {
+          continue;
+        }
+        if (weight[s] > limit[s])
+        {
+          from = s; // relieve an overweight side first
+          break;
+        }
+        if (from < 0 || gain[v] > gain[candidate[from]])
+        {
+          from = s;
+        }
+      }
+      if (from < 0)
+      {
+        break;
+      }
+
+      // Move it and update the neighbors' gains
+      uint32_t v = candidate[from];
+      heap[from].pop();
+      int to = 1 - from;
+      side[v] = static_cast<uint8_t>(to);
+      locked[v] = 1;
+      weight[from] -= g.vertexWeights[v];
+      weight[to] += g.vertexWeights[v];
+      cut -= gain[v];
+      gain[v] = -gain[v];
+      moves.push_back(v);
+      for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e)
+      {
+        uint32_t u = g.adjacency[e];
+        gain[u] += side[u] == to ? -2 * g.edgeWeights[e] : 2 * g.edgeWeights[e];
+        if (!locked[u])
+        {
+          heap[side[u]].push(Entry(gain[u], u));
+        }
+      }
+
+      int64_t excess = overweight(weight, limit);
+      if (excess < bestExcess || (excess == bestExcess && cut < bestCut))
+      {
+        bestCut = cut;
+        bestExcess = excess;
+        bestMoves = moves.size();
+        sinceBest = 0;
+      }
+      else
+      {
+        ++sinceBest;
+      }
+    }
+
+    // Undo the moves after the best state
+    for (size_t i = bestMoves; i < moves.size(); ++i)
+    {
+      side[moves[i]] ^= 1;
+    }
+    if (bestMoves == 0)
+    {
+      break; // no improvement in this pass
+    }
+  }
+}
+
+// Bisection by breadth-first growth of side 0 from a seed
+vector<uint8_t> growBisection(const WeightedGraph &g, int64_t target0,
+                              uint32_t seed)
+{
+  vector<uint8_t> side(g.size(), 1);
+  int64_t weight0 = 0;
+  queue<uint32_t> frontier;
+  uint32_t nextStart = 0;
+  frontier.push(seed);
+  side[seed] = 0;
+  weight0 += g.vertexWeights[seed];
+  while (weight0 < target0)
+  {
+    if (frontier.empty())
+    {
+      // Component exhausted: continue from any vertex still on side 1
+      while (nextStart < g.size() && side[nextStart] == 0)
+      {
+        ++nextStart;
+      }
+      if (nextStart == g.size())
+      {
+        break;
+      }
+      side[nextStart] = 0;
+      weight0 += g.vertexWeights[nextStart];
+      frontier.push(nextStart);
+      continue;
+    }
+    uint32_t v = frontier.front();
+    frontier.pop();
+    for (uint32_t e = g.offsets[v]; e < g.offsets[v + 1] && weight0 < target0;
+         ++e)
+    {
+      uint32_t u = g.adjacency[e];
+      if (side[u] == 1)
+      {
+        side[u] = 0;
+        weight0 += g.vertexWeights[u];
+        frontier.push(u);
+      }
+    }
+  }
+  return side;
+}
+
+// Multilevel bisection with 'fraction' of the weight on side 0
+vector<uint8_t> bisect(const WeightedGraph &g, double fraction, double slack,
+                       const PartitionOptions &options, uint64_t seed)
+{
+  mt19937_64 rng(seed);
+  int64_t total = g.totalWeight();
+  int64_t target0 = static_cast<int64_t>(llround(total * fraction));
+  int64_t limit[2] = {
+      static_cast<int64_t>(ceil(target0 * (1 + slack))),
+      static_cast<int64_t>(ceil((total - target0) * (1 + slack)))};
+
+  // Coarsen
+  vector<unique_ptr<WeightedGraph>> levels;
+  vector<vector<uint32_t>> coarseOf;
+  const WeightedGraph *current = &g;
+  while (current->size() > options.coarsestSize)
+  {
+    unique_ptr<WeightedGraph> next(new WeightedGraph());
+    vector<uint32_t> map;
+    if (!coarsen(*current, rng, *next, map))
+    {
+      break;
+    }
+    coarseOf.push_back(std::move(map));
+    levels.push_back(std::move(next));
+    current = levels.back().get();
+  }
+
+  // Initial bisection: best of several grown seeds
+  vector<uint8_t> side;
+  int64_t bestCut = 0, bestExcess = 0;
+  if (current->size() > 0)
+  {
+    uniform_int_distribution<uint32_t> pick(0, current->size() - 1);
+    for (uint32_t attempt = 0; attempt < max(1u, options.initialTries);
+         ++attempt)
+    {
+      vector<uint8_t> trial = growBisection(*current, target0, pick(rng));
+      refine(*current, trial, limit, options.refinePasses);
+      int64_t weight[2] = {0, 0};
+      for (uint32_t v = 0; v < current->size(); ++v)
+      {
+        weight[trial[v]] += current->vertexWeights[v];
+      }
+      int64_t excess = overweight(weight, limit);
+      int64_t cut = cutOf(*current, trial);
+      if (side.empty() || excess < bestExcess ||
+          (excess == bestExcess && cut < bestCut))
+      {
+        side.swap(trial);
+        bestCut = cut;
+        bestExcess = excess;
+      }
+    }
+  }
+
+  // Uncoarsen: project to the finer level and refine there
+  for (size_t level = levels.size(); level-- > 0;)
+  {
+    const WeightedGraph &finer = level == 0 ? g : *levels[level - 1];
+    vector<uint8_t> projected(finer.size());
+    for (uint32_t v = 0; v < finer.size(); ++v)
+    {
+      projected[v] = side[coarseOf[level][v]];
+    }
+    side.swap(projected);
+    refine(finer, side, limit, options.refinePasses);
+  }
+  return side;
+}
+
+// Recursive bisection into 'parts' parts numbered from 'firstPart'
+void partitionRecursive(const WeightedGraph &g, const vector<uint32_t> &ids,
+                        uint32_t parts, uint32_t firstPart, double slack,
+                        const PartitionOptions &options, uint64_t seed,
+                        vector<uint32_t> &result)
+{
+  if (parts == 1 || g.size() == 0)
+  {
+    for (uint32_t id : ids)
+    {
+      result[id] = firstPart;
+    }
+    return;
+  }
+  uint32_t leftParts = parts / 2;
+  vector<uint8_t> side = bisect(g, static_cast<double>(leftParts) / parts,
+                                slack, options, seed);
+
+  // Partition both halves, in parallel
+  parallelFor(0, 2, 1, [&](size_t lo, size_t hi, unsigned) {
+    for (size_t half = lo; half < hi; ++half)
+    {
+      vector<uint32_t> subIds;
+      WeightedGraph sub = sideSubgraph(g, side, static_cast<uint8_t>(half),
+                                       ids, subIds);
+      partitionRecursive(sub, subIds, half == 0 ? leftParts : parts - leftParts,
+                         half == 0 ? firstPart : firstPart + leftParts, slack,
+                         options, seed * 2 + half + 1, result);
+    }
+  });
+}
+} // namespace
+
+// Multilevel recursive bisection
+PartitionResult partitionGraph(const FlatGraph &graph,
+                               const PartitionOptions &options)
+{
+  uint32_t parts = max(1u, options.parts);
+  vector<uint32_t> part(graph.vertexCount(), 0);
+  WeightedGraph g = fromFlatGraph(graph, options.weighted);
+  vector<uint32_t> ids(graph.vertexCount());
+  iota(ids.begin(), ids.end(), 0);
+
+  // Spread the tolerance over the levels of bisection
+  double depth = ceil(log2(static_cast<double>(parts)));
+  double slack = depth > 0 ? pow(1 + options.imbalance, 1 / depth) - 1 : 0;
+  partitionRecursive(g, ids, parts, 0, slack, options, options.seed, part);
+  return evaluatePartition(graph, std::move(part), parts, options.weighted);
+}
+
+// Edge cut and balance of a partition
+PartitionResult evaluatePartition(const FlatGraph &graph,
+                                  vector<uint32_t> part, uint32_t parts,
+                                  bool weighted)
+{
+  PartitionResult result;
+  result.partSizes.assign(max(1u, parts), 0);
+  result.edgeCut = 0;
+  for (FlatGraph::Vertex v = 0; v < graph.vertexCount(); ++v)
+  {
+    ++result.partSizes[part[v]];
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      FlatGraph::Vertex u = graph.neighbors(v)[i];
+      if (v < u && part[u] != part[v])
+      {
+        result.edgeCut += weighted ? graph.weights(v)[i] : 1;
+      }
+    }
+  }
+  size_t largest =
+      *max_element(result.partSizes.begin(), result.partSizes.end());
+  double average = static_cast<double>(graph.vertexCount()) /
+                   result.partSizes.size();
+  result.imbalance = average > 0 ? largest / average - 1 : 0.0;
+  result.part = std::move(part);
+  return result;
+}
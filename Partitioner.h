@@ -0,0 +1,75 @@
+/******************************************************************************
+    Multilevel graph partitioning:
+    PartitionOptions: Number of parts, balance tolerance and tuning.
+    PartitionResult: Part of every vertex, edge cut and balance.
+    partitionGraph: Balanced partition minimizing the weight of cut edges.
+    evaluatePartition: Edge cut and balance of any partition.
+ * ****************************************************************************
+ * */
+
+#ifndef PARTITIONER_H
+#define PARTITIONER_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+struct PartitionOptions
+{
+  uint32_t parts = 2;          // number of parts (shards)
+  double imbalance = 0.03;     // allowed excess of the largest part
+  bool weighted = true;        // cut connection weights, not edge counts
+  uint32_t coarsestSize = 100; // stop coarsening below this many vertices
+  uint32_t initialTries = 8;   // graph-growing seeds at the coarsest level
+  uint32_t refinePasses = 8;   // FM passes per level
+  uint64_t seed = 0;           // random seed (matching order, seeds)
+};
+
+struct PartitionResult
+{
+  vector<uint32_t> part;    // part of each vertex
+  int64_t edgeCut;          // weight (or number) of edges between parts
+  double imbalance;         // largest part / average part - 1
+  vector<size_t> partSizes; // vertices per part
+};
+
+/******************************************************************************
+ * Function: partitionGraph
+ *
+ * Purpose: Split the users into 'parts' balanced parts with few (light)
+ *          connections between them, so that a sharded deployment sends
+ *          few cross-shard messages. Multilevel recursive bisection: each
+ *          bisection coarsens the graph by heavy-edge matching (merging
+ *          the endpoints of the heaviest edges) down to a few hundred
+ *          vertices, bisects the coarsest graph by graph growing from
+ *          several seeds, then projects the bisection back level by level
+ *          and improves it at each level with Fiduccia-Mattheyses passes.
+ *          The two halves are then partitioned in parallel.
+ *
+ * Preconditions: options.parts > 0. Weights are not negative.
+ *
+ * Postconditions: Every part holds at most about (1 + imbalance) times the
+ *                 average part size; the result is deterministic for a
+ *                 given seed.
+ *****************************************************************************/
+PartitionResult partitionGraph(const FlatGraph &graph,
+                               const PartitionOptions &options =
+                                   PartitionOptions());
+
+/******************************************************************************
+ * Function: evaluatePartition
+ *
+ * Purpose: Measure the edge cut and balance of a partition, e.g. to
+ *          compare hash sharding with partitionGraph().
+ *
+ * Preconditions: 'part' has one entry per vertex, each less than 'parts'.
+ *
+ * Postconditions: Returns 'part' with its statistics.
+ *****************************************************************************/
+PartitionResult evaluatePartition(const FlatGraph &graph,
+                                  vector<uint32_t> part, uint32_t parts,
+                                  bool weighted = true);
+
+#endif // END OF THE HEADER FILE
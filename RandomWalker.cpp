@@ -0,0 +1,148 @@
+#include "RandomWalker.h"
+#include "Parallel.h"
+#include <algorithm>
+
+// Constructor; tables are built as the walks reach users
+RandomWalker::RandomWalker(const GraphVersion &graph) : graph(graph) {}
+
+// Sample the next user of a walk
+string_view RandomWalker::step(const AliasTable &table, mt19937_64 &rng)
+{
+  uint32_t degree = static_cast<uint32_t>(table.neighbors.size());
+  uint64_t r = rng();
+  // Low bits pick the slot, high bits decide between it and its alias
+  uint32_t slot = static_cast<uint32_t>((r & 0xFFFFFFFFu) % degree);
+  float coin = static_cast<float>(r >> 40) / static_cast<float>(1 << 24);
+  uint32_t chosen = coin < table.probability[slot] ? slot : table.alias[slot];
+  return table.neighbors[chosen];
+}
+
+// Get the alias table of one user, building it on the first visit
+const RandomWalker::AliasTable &
+RandomWalker::tableOf(string_view user, AliasTables &tables) const
+{
+  auto found = tables.find(user);
+  if (found != tables.end())
+  {
+    return found->second;
+  }
+
+  const GraphVersion::NeighborList &neighbors = graph.neighborsOf(user);
+  uint32_t degree = static_cast<uint32_t>(neighbors.size());
+  AliasTable table;
+  table.neighbors.reserve(degree);
+  table.probability.resize(degree);
+  table.alias.resize(degree);
+  vector<double> scaled;
+  scaled.reserve(degree);
+  double total = 0.0;
+  for (const GraphVersion::Neighbor &neighbor : neighbors)
+  {
+    table.neighbors.push_back(neighbor.userName);
+    scaled.push_back(neighbor.weight);
+    total += neighbor.weight;
+  }
+  vector<uint32_t> small, large;
+  for (uint32_t i = 0; i < degree; ++i)
+  {
+    scaled[i] = scaled[i] * degree / total;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty())
+  {
+    uint32_t s = small.back(), l = large.back();
+    small.pop_back();
+    table.probability[s] = static_cast<float>(scaled[s]);
+    table.alias[s] = l;
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0)
+    {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // Leftovers are 1 up to rounding
+  for (uint32_t i : small)
+  {
+    table.probability[i] = 1.0f;
+    table.alias[i] = i;
+  }
+  for (uint32_t i : large)
+  {
+    table.probability[i] = 1.0f;
+    table.alias[i] = i;
+  }
+  return tables.emplace(user, std::move(table)).first->second;
+}
+
+// Random walks with restart from one user
+vector<pair<string, double>>
+RandomWalker::personalizedScores(string_view source, size_t k,
+                                 const RandomWalkOptions &options) const
+{
+  uint64_t seed = options.seed ? options.seed : random_device()();
+  const size_t GRAIN = 128;
+  size_t tasks = (options.walks + GRAIN - 1) / GRAIN;
+  vector<unordered_map<string_view, uint32_t>> visits(tasks);
+  vector<AliasTables> tables(workerCount());
+
+  parallelFor(0, options.walks, GRAIN,
+              [&](size_t lo, size_t hi, unsigned worker) {
+                size_t task = lo / GRAIN;
+                mt19937_64 rng(seed + 0x9E3779B97F4A7C15ull * (task + 1));
+                uniform_real_distribution<double> coin(0.0, 1.0);
+                unordered_map<string_view, uint32_t> &counts = visits[task];
+                for (size_t walk = lo; walk < hi; ++walk)
+                {
+                  string_view v = source;
+                  for (uint32_t length = 0; length < options.maxLength;
+                       ++length)
+                  {
+                    const AliasTable &table = tableOf(v, tables[worker]);
+                    if (table.neighbors.empty() ||
+                        coin(rng) < options.restartProbability)
+                    {
+                      break;
+                    }
+                    v = step(table, rng);
+                    ++counts[v];
+                  }
+                }
+              });
+
+  // Merge the per-task counts
+  unordered_map<string_view, uint64_t> total;
+  uint64_t steps = 0;
+  for (const auto &counts : visits)
+  {
+    for (const auto &entry : counts)
+    {
+      total[entry.first] += entry.second;
+      steps += entry.second;
+    }
+  }
+  total.erase(source);
+  if (options.excludeFriends)
+  {
+    for (const GraphVersion::Neighbor &neighbor : graph.neighborsOf(source))
+    {
+      total.erase(neighbor.userName);
+    }
+  }
+
+  vector<pair<string_view, double>> scores;
+  scores.reserve(total.size());
+  for (const auto &entry : total)
+  {
+    scores.emplace_back(entry.first,
+                        static_cast<double>(entry.second) / steps);
+  }
+  k = min(k, scores.size());
+  partial_sort(scores.begin(), scores.begin() + k, scores.end(),
+               [](const pair<string_view, double> &a,
+                  const pair<string_view, double> &b) {
+                 return a.second != b.second ? a.second > b.second
+                                             : a.first < b.first;
+               });
+  return vector<pair<string, double>>(scores.begin(), scores.begin() + k);
+}
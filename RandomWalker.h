@@ -0,0 +1,95 @@
+/******************************************************************************
+    Implementation of RandomWalker class:
+    RandomWalker: Constructor binding a pinned graph version.
+    personalizedScores: Top-k users by visit frequency of random walks with
+     restart from one user.
+ * ****************************************************************************
+ * */
+
+#ifndef RANDOMWALKER_H
+#define RANDOMWALKER_H
+
+#include "GraphVersion.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct RandomWalkOptions
+{
+  double restartProbability = 0.15; // chance of ending a walk at each step
+  size_t walks = 2000;              // number of walks from the source
+  uint32_t maxLength = 64;          // hard cap on the steps of one walk
+  uint64_t seed = 0;                // 0 = seed from random_device
+  bool excludeFriends = true;       // leave out existing connections
+};
+
+/******************************************************************************
+ * Class: RandomWalker
+ *
+ * Description: Monte Carlo approximation of personalized PageRank. Walks
+ *              start at the source, follow connections with probability
+ *              proportional to Connection weight and stop with the restart
+ *              probability; visit counts become scores. Each step samples
+ *              the next user in O(1) from a per-user alias table. Walks run
+ *              over a pinned GraphVersion, and alias tables live in a hash
+ *              map keyed by the users the walks reach, built on the first
+ *              visit: a query only pays for the users its walks actually
+ *              reach, and nothing is rebuilt after a mutation. Walks are
+ *              split across parallelFor tasks, each with its own generator
+ *              seeded from the query seed and the task index; every worker
+ *              keeps its own tables.
+ *
+ * Member Variables:
+ *    - graph: The pinned version walked over.
+ *
+ *****************************************************************************/
+class RandomWalker
+{
+public:
+  /***** Constructors *****/
+  explicit RandomWalker(const GraphVersion &graph);
+  /*-------------------------------------------------------------------------
+    Bind a walker to a version of the graph.
+
+    Preconditions: 'graph' stays pinned while the walker is used.
+    Postconditions: No alias table is built yet.
+  -------------------------------------------------------------------------*/
+
+  /***** Queries *****/
+  vector<pair<string, double>>
+  personalizedScores(string_view source, size_t k,
+                     const RandomWalkOptions &options) const;
+  /*-------------------------------------------------------------------------
+    Run the walks from 'source' and rank the visited users.
+
+    Preconditions: None.
+    Postconditions: Returns up to 'k' (username, share of visits) pairs,
+                    best first (ties by name), excluding 'source' (and its
+                    friends if asked); empty if 'source' has no
+                    connections. Safe to call concurrently.
+  -------------------------------------------------------------------------*/
+
+private:
+  // Neighbors of one user with their alias table (Vose's method)
+  struct AliasTable
+  {
+    vector<string_view> neighbors; // names owned by the pinned version
+    vector<float> probability;     // keep probability per slot
+    vector<uint32_t> alias;        // fallback slot
+  };
+  typedef unordered_map<string_view, AliasTable> AliasTables;
+
+  const AliasTable &tableOf(string_view user, AliasTables &tables) const;
+  static string_view step(const AliasTable &table, mt19937_64 &rng);
+
+  /***** Member Variables *****/
+  const GraphVersion &graph; // version walked over
+};
+
+#endif // END OF THE HEADER FILE
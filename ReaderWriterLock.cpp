@@ -0,0 +1,92 @@
+#include "ReaderWriterLock.h"
+#include <cassert>
+
+// Locks held by the current thread: (lock, exclusive)
+thread_local vector<pair<const ReaderWriterLock *, bool>>
+    ReaderWriterLock::held;
+
+// Entry of this lock in the current thread's list, if held
+const pair<const ReaderWriterLock *, bool> *
+ReaderWriterLock::heldByThisThread() const
+{
+  for (const auto &entry : held)
+  {
+    if (entry.first == this)
+    {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// Forget this lock in the current thread's list and unlock it
+void ReaderWriterLock::release() const
+{
+  for (auto it = held.begin(); it != held.end(); ++it)
+  {
+    if (it->first == this)
+    {
+      bool exclusive = it->second;
+      held.erase(it);
+      if (exclusive)
+      {
+        mutex.unlock();
+      }
+      else
+      {
+        mutex.unlock_shared();
+      }
+      return;
+    }
+  }
+}
+
+// Constructor: lock shared unless already held
+ReaderWriterLock::ReadGuard::ReadGuard(const ReaderWriterLock &lock)
+    : owner(nullptr)
+{
+  if (!lock.enabled || lock.heldByThisThread() != nullptr)
+  {
+    return;
+  }
+  lock.mutex.lock_shared();
+  held.emplace_back(&lock, false);
+  owner = &lock;
+}
+
+// Destructor: unlock if this guard locked
+ReaderWriterLock::ReadGuard::~ReadGuard()
+{
+  if (owner != nullptr)
+  {
+    owner->release();
+  }
+}
+
+// Constructor: lock exclusively unless already held
+ReaderWriterLock::WriteGuard::WriteGuard(const ReaderWriterLock &lock)
+    : owner(nullptr)
+{
+  if (!lock.enabled)
+  {
+    return;
+  }
+  const pair<const ReaderWriterLock *, bool> *entry = lock.heldByThisThread();
+  if (entry != nullptr)
+  {
+    assert(entry->second && "write guard inside a read guard");
+    return;
+  }
+  lock.mutex.lock();
+  held.emplace_back(&lock, true);
+  owner = &lock;
+}
+
+// Destructor: unlock if this guard locked
+ReaderWriterLock::WriteGuard::~WriteGuard()
+{
+  if (owner != nullptr)
+  {
+    owner->release();
+  }
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+    Implementation of ReaderWriterLock class:
+    ReaderWriterLock: Construct an enabled or disabled (no-op) lock.
+    isEnabled: Whether the guards lock at all.
+    ReadGuard: Shared ownership for the lifetime of the guard.
+    WriteGuard: Exclusive ownership for the lifetime of the guard.
+ * ****************************************************************************
+ * */
+
+#ifndef READERWRITERLOCK_H
+#define READERWRITERLOCK_H
+
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: ReaderWriterLock
+ *
+ * Description: Shared mutex for objects whose public methods call each
+ *              other. Every thread remembers which locks it holds, so a
+ *              guard taken while the thread already holds the lock does
+ *              nothing instead of deadlocking: a read or write method
+ *              called from a write method, or a read method called from a
+ *              read method, just runs. A write guard inside a read guard
+ *              cannot upgrade and is a programming error. A disabled lock
+ *              makes every guard a no-op for single-threaded use.
+ *
+ * Member Variables:
+ *    - mutex: The shared mutex.
+ *    - enabled: Whether the guards lock it.
+ *    - held: Locks held by the current thread, and whether exclusively.
+ *
+ *****************************************************************************/
+class ReaderWriterLock
+{
+public:
+  explicit ReaderWriterLock(bool enabled = false) : enabled(enabled) {}
+  ReaderWriterLock(const ReaderWriterLock &) = delete;
+  ReaderWriterLock &operator=(const ReaderWriterLock &) = delete;
+
+  bool isEnabled() const { return enabled; }
+
+  class ReadGuard
+  {
+  public:
+    explicit ReadGuard(const ReaderWriterLock &lock);
+    ~ReadGuard();
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+    /*-----------------------------------------------------------------------
+      Hold the lock shared, unless this thread already holds it.
+
+      Preconditions: None.
+      Postconditions: Concurrent writers wait until the outermost guard of
+                      this thread is destroyed.
+    -----------------------------------------------------------------------*/
+
+  private:
+    const ReaderWriterLock *owner; // lock taken by this guard, or nullptr
+  };
+
+  class WriteGuard
+  {
+  public:
+    explicit WriteGuard(const ReaderWriterLock &lock);
+    ~WriteGuard();
+    WriteGuard(const WriteGuard &) = delete;
+    WriteGuard &operator=(const WriteGuard &) = delete;
+    /*-----------------------------------------------------------------------
+      Hold the lock exclusively, unless this thread already does.
+
+      Preconditions: This thread does not hold the lock shared.
+      Postconditions: No other thread holds the lock until the outermost
+                      guard of this thread is destroyed.
+    -----------------------------------------------------------------------*/
+
+  private:
+    const ReaderWriterLock *owner; // lock taken by this guard, or nullptr
+  };
+
+private:
+  const pair<const ReaderWriterLock *, bool> *heldByThisThread() const;
+  void release() const;
+
+  /***** Member Variables *****/
+  mutable shared_mutex mutex; // the lock
+  bool enabled;               // guards are no-ops when false
+  static thread_local vector<pair<const ReaderWriterLock *, bool>> held;
+};
+
+#endif // END OF THE HEADER FILE
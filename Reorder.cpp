@@ -0,0 +1,247 @@
+#include "Reorder.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <queue>
+
+namespace
+{
+typedef FlatGraph::Vertex Vertex;
+
+// All vertices by degree (ties by ID), ascending or descending
+vector<Vertex> byDegree(const FlatGraph &graph, bool descending)
+{
+  vector<Vertex> order(graph.vertexCount());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(), [&](Vertex a, Vertex b) {
+    return descending ? graph.degree(a) > graph.degree(b)
+                      : graph.degree(a) < graph.degree(b);
+  });
+  return order;
+}
+
+// Breadth-first search from 'root' over the unplaced vertices; returns the
+// eccentricity of 'root' and the minimum-degree vertex of the last level
+uint32_t lastLevel(const FlatGraph &graph, Vertex root,
+                   const vector<uint8_t> &placed, vector<uint32_t> &stamp,
+                   uint32_t epoch, vector<Vertex> &queue, Vertex &farthest)
+{
+  queue.assign(1, root);
+  stamp[root] = epoch;
+  uint32_t depth = 0;
+  size_t levelBegin = 0;
+  while (true)
+  {
+    size_t levelEnd = queue.size();
+    for (size_t i = levelBegin; i < levelEnd; ++i)
+    {
+      Vertex v = queue[i];
+      for (uint32_t j = 0; j < graph.degree(v); ++j)
+      {
+        Vertex u = graph.neighbors(v)[j];
+        if (!placed[u] && stamp[u] != epoch)
+        {
+          stamp[u] = epoch;
+          queue.push_back(u);
+        }
+      }
+    }
+    if (queue.size() == levelEnd)
+    {
+      // [levelBegin, levelEnd) is the last level
+      farthest = *min_element(queue.begin() + levelBegin, queue.end(),
+                              [&](Vertex a, Vertex b) {
+                                return graph.degree(a) < graph.degree(b);
+                              });
+      return depth;
+    }
+    levelBegin = levelEnd;
+    ++depth;
+  }
+}
+
+// Reverse Cuthill-McKee
+vector<Vertex> orderRcm(const FlatGraph &graph)
+{
+  size_t n = graph.vertexCount();
+  vector<Vertex> order;
+  order.reserve(n);
+  vector<uint8_t> placed(n, 0);
+  vector<uint32_t> stamp(n, 0);
+  uint32_t epoch = 0;
+  vector<Vertex> queue;
+  vector<Vertex> children;
+
+  for (Vertex start : byDegree(graph, false))
+  {
+    if (placed[start])
+    {
+      continue;
+    }
+    // Pseudo-peripheral root (George-Liu): move to the far end while the
+    // eccentricity keeps growing
+    Vertex root = start, farthest;
+    uint32_t eccentricity =
+        lastLevel(graph, root, placed, stamp, ++epoch, queue, farthest);
+    for (int round = 0; round < 8 && farthest != root; ++round)
+    {
+      Vertex candidate;
+      uint32_t e =
+          lastLevel(graph, farthest, placed, stamp, ++epoch, queue, candidate);
+      if (e <= eccentricity)
+      {
+        break;
+      }
+      root = farthest;
+      eccentricity = e;
+      farthest = candidate;
+    }
+
+    // Cuthill-McKee: BFS, children by increasing degree
+    size_t head = order.size();
+    order.push_back(root);
+    placed[root] = 1;
+    for (; head < order.size(); ++head)
+    {
+      Vertex v = order[head];
+      children.clear();
+      for (uint32_t j = 0; j < graph.degree(v); ++j)
+      {
+        Vertex u = graph.neighbors(v)[j];
+        if (!placed[u])
+        {
+          placed[u] = 1;
+          children.push_back(u);
+        }
+      }
+      stable_sort(children.begin(), children.end(), [&](Vertex a, Vertex b) {
+        return graph.degree(a) < graph.degree(b);
+      });
+      order.insert(order.end(), children.begin(), children.end());
+    }
+  }
+  reverse(order.begin(), order.end());
+  return order;
+}
+
+// Gorder: greedy placement by score against a sliding window
+vector<Vertex> orderGorder(const FlatGraph &graph, uint32_t window)
+{
+  size_t n = graph.vertexCount();
+  const uint32_t hubDegree =
+      max<uint32_t>(8, static_cast<uint32_t>(sqrt(static_cast<double>(n))));
+  vector<Vertex> order;
+  order.reserve(n);
+  vector<uint8_t> placed(n, 0);
+  vector<uint32_t> score(n, 0);
+  // Lazy max-heap: an entry is live while it matches score[v]
+  priority_queue<pair<uint32_t, Vertex>> heap;
+
+  auto bump = [&](Vertex u, int delta) {
+    if (!placed[u])
+    {
+      score[u] += delta;
+      if (score[u] > 0)
+      {
+        heap.push(make_pair(score[u], u));
+      }
+    }
+  };
+  // Add (+1) or remove (-1) the contribution of window vertex 'x'
+  auto update = [&](Vertex x, int delta) {
+    for (uint32_t i = 0; i < graph.degree(x); ++i)
+    {
+      Vertex y = graph.neighbors(x)[i];
+      bump(y, delta); // neighbor score
+      if (graph.degree(y) > hubDegree)
+      {
+        continue;
+      }
+      for (uint32_t j = 0; j < graph.degree(y); ++j)
+      {
+        Vertex u = graph.neighbors(y)[j];
+        if (u != x)
+        {
+          bump(u, delta); // sibling score: common neighbor y
+        }
+      }
+    }
+  };
+
+  vector<Vertex> seeds = byDegree(graph, true);
+  size_t nextSeed = 0;
+  deque<Vertex> recent;
+  while (order.size() < n)
+  {
+    Vertex v = FlatGraph::NO_VERTEX;
+    while (!heap.empty())
+    {
+      pair<uint32_t, Vertex> top = heap.top();
+      heap.pop();
+      if (!placed[top.second] && score[top.second] == top.first)
+      {
+        v = top.second;
+        break;
+      }
+    }
+    if (v == FlatGraph::NO_VERTEX)
+    {
+      // Nothing related to the window: start from the next hub
+      while (placed[seeds[nextSeed]])
+      {
+        ++nextSeed;
+      }
+      v = seeds[nextSeed];
+    }
+
+    placed[v] = 1;
+    order.push_back(v);
+    update(v, +1);
+    recent.push_back(v);
+    if (recent.size() > window)
+    {
+      update(recent.front(), -1);
+      recent.pop_front();
+    }
+  }
+  return order;
+}
+} // namespace
+
+// New vertex order
+vector<FlatGraph::Vertex> computeOrdering(const FlatGraph &graph,
+                                          ReorderStrategy strategy,
+                                          uint32_t window)
+{
+  switch (strategy)
+  {
+  case ReorderStrategy::DEGREE:
+    return byDegree(graph, true);
+  case ReorderStrategy::RCM:
+    return orderRcm(graph);
+  case ReorderStrategy::GORDER:
+    return orderGorder(graph, window);
+  }
+  return byDegree(graph, true);
+}
+
+// Mean ID distance between adjacent vertices
+double averageNeighborGap(const FlatGraph &graph)
+{
+  const vector<Vertex> &adjacency = graph.adjacencyArray();
+  if (adjacency.empty())
+  {
+    return 0.0;
+  }
+  double total = 0.0;
+  for (Vertex v = 0; v < graph.vertexCount(); ++v)
+  {
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      Vertex u = graph.neighbors(v)[i];
+      total += u > v ? u - v : v - u;
+    }
+  }
+  return total / adjacency.size();
+}
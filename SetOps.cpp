@@ -0,0 +1,145 @@
+#include "SetOps.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SETOPS_SSE2 1
+#endif
+
+namespace
+{
+// Above this length ratio, galloping beats a linear merge
+const size_t GALLOP_RATIO = 32;
+
+// Gallop each ID of the short list through the long list
+template <bool Write>
+size_t gallop(const uint32_t *small, size_t ns, const uint32_t *large,
+              size_t nl, uint32_t *out)
+{
+  size_t count = 0;
+  const uint32_t *lo = large;
+  const uint32_t *end = large + nl;
+  for (size_t i = 0; i < ns && lo < end; ++i)
+  {
+    uint32_t value = small[i];
+    // Exponential search for an upper bound, then binary search
+    size_t step = 1;
+    const uint32_t *hi = lo;
+    while (hi < end && *hi < value)
+    {
+      lo = hi;
+      hi = (static_cast<size_t>(end - hi) > step) ? hi + step : end;
+      step *= 2;
+    }
+    lo = lower_bound(lo, hi, value);
+    if (lo < end && *lo == value)
+    {
+      if (Write)
+      {
+        out[count] = value;
+      }
+      ++count;
+      ++lo;
+    }
+  }
+  return count;
+}
+
+// Merge-based intersection, four IDs of each list per step
+template <bool Write>
+size_t merge(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+             uint32_t *out)
+{
+  size_t i = 0, j = 0, count = 0;
+#ifdef SETOPS_SSE2
+  while (i + 4 <= na && j + 4 <= nb)
+  {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + j));
+    // Compare every lane of 'va' against all four rotations of 'vb'
+    __m128i cmp = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                     _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+        _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E)),
+                     _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+    if (Write)
+    {
+      for (int k = 0; k < 4; ++k)
+      {
+        if (mask & (1 << k))
+        {
+          out[count++] = a[i + k];
+        }
+      }
+    }
+    else
+    {
+      count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    uint32_t amax = a[i + 3], bmax = b[j + 3];
+    if (amax <= bmax)
+    {
+      i += 4;
+    }
+    if (bmax <= amax)
+    {
+      j += 4;
+    }
+  }
+#endif
+  while (i < na && j < nb)
+  {
+    if (a[i] < b[j])
+    {
+      ++i;
+    }
+    else if (b[j] < a[i])
+    {
+      ++j;
+    }
+    else
+    {
+      if (Write)
+      {
+        out[count] = a[i];
+      }
+      ++count;
+      ++i;
+      ++j;
+    }
+  }
+  return count;
+}
+
+template <bool Write>
+size_t intersect(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                 uint32_t *out)
+{
+  if (na == 0 || nb == 0)
+  {
+    return 0;
+  }
+  if (na * GALLOP_RATIO < nb)
+  {
+    return gallop<Write>(a, na, b, nb, out);
+  }
+  if (nb * GALLOP_RATIO < na)
+  {
+    return gallop<Write>(b, nb, a, na, out);
+  }
+  return merge<Write>(a, na, b, nb, out);
+}
+} // namespace
+
+size_t intersectSorted(const uint32_t *a, size_t na, const uint32_t *b,
+                       size_t nb, uint32_t *out)
+{
+  return intersect<true>(a, na, b, nb, out);
+}
+
+size_t intersectCount(const uint32_t *a, size_t na, const uint32_t *b,
+                      size_t nb)
+{
+  return intersect<false>(a, na, b, nb, nullptr);
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+    Sorted-set operations on arrays of 32-bit IDs:
+    intersectSorted: Write the intersection of two sorted arrays.
+    intersectCount: Count the intersection of two sorted arrays.
+ * ****************************************************************************
+ * */
+
+#ifndef SETOPS_H
+#define SETOPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Function: intersectSorted
+ *
+ * Purpose: Intersect two strictly increasing arrays of IDs. Lists of similar
+ *          length are merged four-by-four with SSE2 all-pairs comparisons;
+ *          when one list is much longer than the other the short list is
+ *          galloped through the long one instead.
+ *
+ * Preconditions:
+ *    - 'a' and 'b' are sorted without duplicates.
+ *    - 'out' has room for min(na, nb) IDs (it may alias 'a').
+ *
+ * Postconditions: Returns the number of IDs written to 'out', in order.
+ *****************************************************************************/
+size_t intersectSorted(const uint32_t *a, size_t na, const uint32_t *b,
+                       size_t nb, uint32_t *out);
+
+/******************************************************************************
+ * Function: intersectCount
+ *
+ * Purpose: Same as intersectSorted, but only counts the common IDs.
+ *
+ * Preconditions:
+ *    - 'a' and 'b' are sorted without duplicates.
+ *
+ * Postconditions: Returns the size of the intersection.
+ *****************************************************************************/
+size_t intersectCount(const uint32_t *a, size_t na, const uint32_t *b,
+                      size_t nb);
+
+// Convenience overloads for vectors
+inline vector<uint32_t> intersectSorted(const vector<uint32_t> &a,
+                                        const vector<uint32_t> &b)
+{
+  vector<uint32_t> out(a.size() < b.size() ? a.size() : b.size());
+  out.resize(intersectSorted(a.data(), a.size(), b.data(), b.size(),
+                             out.data()));
+  return out;
+}
+
+inline size_t intersectCount(const vector<uint32_t> &a,
+                             const vector<uint32_t> &b)
+{
+  return intersectCount(a.data(), a.size(), b.data(), b.size());
+}
+
+#endif // END OF THE HEADER FILE
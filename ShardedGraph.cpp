@@ -0,0 +1,366 @@
+#include "ShardedGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+typedef FlatGraph::Vertex Vertex;
+typedef pair<Vertex, uint32_t> Message; // (target vertex, value)
+
+// Reusable barrier for a fixed number of threads
+class Barrier
+{
+public:
+  explicit Barrier(size_t count) : count(count), waiting(0), generation(0) {}
+
+  void wait()
+  {
+    unique_lock<mutex> guard(lock);
+    size_t arrived = generation;
+    if (++waiting == count)
+    {
+      waiting = 0;
+      ++generation;
+      released.notify_all();
+      return;
+    }
+    released.wait(guard, [&] { return generation != arrived; });
+  }
+
+private:
+  mutex lock;
+  condition_variable released;
+  size_t count;
+  size_t waiting;
+  size_t generation;
+};
+
+// Keep one message per target vertex: the smallest value
+void combine(vector<Message> &outbox)
+{
+  sort(outbox.begin(), outbox.end());
+  outbox.erase(unique(outbox.begin(), outbox.end(),
+                      [](const Message &a, const Message &b) {
+                        return a.first == b.first;
+                      }),
+               outbox.end());
+}
+
+// Run supersteps, one thread per shard, until a round creates no work.
+// step(shard, round, inbox, outboxes, localUpdates) processes the inbox,
+// fills outboxes[d] for every other shard d and returns its local work for
+// the next round.
+template <typename Step>
+void runSupersteps(size_t shardCount, Step step, ShardStats *stats)
+{
+  vector<vector<vector<Message>>> outboxes(
+      shardCount, vector<vector<Message>>(shardCount));
+  vector<vector<Message>> inboxes(shardCount);
+  vector<uint64_t> localUpdates(shardCount, 0);
+  vector<uint64_t> sent(shardCount, 0);
+  atomic<uint64_t> work[2];
+  work[0].store(0);
+  work[1].store(0);
+  size_t rounds = 0;
+  Barrier barrier(shardCount);
+
+  auto run = [&](size_t shard) {
+    for (size_t round = 0;; ++round)
+    {
+      // Compute: local updates now, remote ones as messages
+      for (vector<Message> &outbox : outboxes[shard])
+      {
+        outbox.clear();
+      }
+      uint64_t pending = step(shard, round, inboxes[shard], outboxes[shard],
+                              localUpdates[shard]);
+      for (size_t target = 0; target < shardCount; ++target)
+      {
+        if (target != shard)
+        {
+          combine(outboxes[shard][target]);
+          pending += outboxes[shard][target].size();
+          sent[shard] += outboxes[shard][target].size();
+        }
+      }
+      work[round % 2] += pending;
+      barrier.wait();
+
+      // Exchange: stop together once no shard has anything left to do
+      if (work[round % 2].load() == 0)
+      {
+        if (shard == 0)
+        {
+          rounds = round + 1;
+        }
+        return;
+      }
+      if (shard == 0)
+      {
+        work[(round + 1) % 2].store(0);
+      }
+      inboxes[shard].clear();
+      for (size_t source = 0; source < shardCount; ++source)
+      {
+        const vector<Message> &delivered = outboxes[source][shard];
+        inboxes[shard].insert(inboxes[shard].end(), delivered.begin(),
+                              delivered.end());
+      }
+      barrier.wait();
+    }
+  };
+
+  vector<thread> threads;
+  for (size_t shard = 1; shard < shardCount; ++shard)
+  {
+    threads.emplace_back(run, shard);
+  }
+  run(0);
+  for (thread &t : threads)
+  {
+    t.join();
+  }
+
+  if (stats != nullptr)
+  {
+    stats->supersteps = rounds;
+    stats->localUpdates = 0;
+    stats->remoteMessages = 0;
+    for (size_t shard = 0; shard < shardCount; ++shard)
+    {
+      stats->localUpdates += localUpdates[shard];
+      stats->remoteMessages += sent[shard];
+    }
+    stats->remoteBytes = stats->remoteMessages * sizeof(Message);
+    stats->sentByShard = sent;
+  }
+}
+} // namespace
+
+// Constructor: shards by vertex hash
+ShardedGraph::ShardedGraph(const FlatGraph &graph, size_t shardCount)
+    : dictionary(graph.users()), owner(graph.vertexCount()),
+      shards(max<size_t>(shardCount, 1)), crossEdges(0)
+{
+  for (Vertex v = 0; v < owner.size(); ++v)
+  {
+    // Multiplicative hash, so that ID ranges spread over the shards
+    owner[v] = static_cast<uint32_t>(
+        (static_cast<uint64_t>(v) * 0x9E3779B97F4A7C15ULL >> 32) %
+        shards.size());
+  }
+  build(graph);
+}
+
+// Constructor: shards by a given partition
+ShardedGraph::ShardedGraph(const FlatGraph &graph,
+                           const vector<uint32_t> &partition)
+    : dictionary(graph.users()), owner(partition), crossEdges(0)
+{
+  uint32_t highest = 0;
+  for (uint32_t part : partition)
+  {
+    highest = max(highest, part);
+  }
+  shards.resize(static_cast<size_t>(highest) + 1);
+  build(graph);
+}
+
+// Split the adjacency by owner
+void ShardedGraph::build(const FlatGraph &graph)
+{
+  localIndex.assign(owner.size(), 0);
+  for (Shard &shard : shards)
+  {
+    shard.offsets.assign(1, 0);
+  }
+  for (Vertex v = 0; v < owner.size(); ++v)
+  {
+    Shard &shard = shards[owner[v]];
+    localIndex[v] = static_cast<uint32_t>(shard.vertices.size());
+    shard.vertices.push_back(v);
+    const Vertex *neighbors = graph.neighbors(v);
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      shard.adjacency.push_back(neighbors[i]);
+      if (owner[neighbors[i]] != owner[v] && v < neighbors[i])
+      {
+        ++crossEdges;
+      }
+    }
+    shard.offsets.push_back(static_cast<uint32_t>(shard.adjacency.size()));
+  }
+}
+
+// Breadth-first search by supersteps
+vector<uint32_t> ShardedGraph::bfs(Vertex source, uint32_t maxHops,
+                                   ShardStats *stats) const
+{
+  size_t shardCount = shards.size();
+  vector<vector<uint32_t>> distance(shardCount);
+  vector<vector<Vertex>> frontier(shardCount);
+  for (size_t s = 0; s < shardCount; ++s)
+  {
+    distance[s].assign(shards[s].vertices.size(), UNREACHED);
+  }
+
+  runSupersteps(
+      shardCount,
+      [&](size_t s, size_t round, const vector<Message> &inbox,
+          vector<vector<Message>> &outboxes, uint64_t &localUpdates) {
+        const Shard &shard = shards[s];
+        vector<uint32_t> &dist = distance[s];
+        vector<Vertex> &current = frontier[s];
+        if (round == 0 && owner[source] == s)
+        {
+          dist[localIndex[source]] = 0;
+          current.push_back(source);
+        }
+        // Vertices reached from other shards join this level
+        for (const Message &message : inbox)
+        {
+          uint32_t &d = dist[localIndex[message.first]];
+          if (d == UNREACHED)
+          {
+            d = message.second;
+            current.push_back(message.first);
+          }
+        }
+
+        vector<Vertex> next;
+        uint32_t level = static_cast<uint32_t>(round);
+        if (level < maxHops)
+        {
+          for (Vertex v : current)
+          {
+            uint32_t i = localIndex[v];
+            for (uint32_t e = shard.offsets[i]; e < shard.offsets[i + 1]; ++e)
+            {
+              Vertex u = shard.adjacency[e];
+              if (owner[u] != s)
+              {
+                outboxes[owner[u]].emplace_back(u, level + 1);
+                continue;
+              }
+              uint32_t &d = dist[localIndex[u]];
+              if (d == UNREACHED)
+              {
+                d = level + 1;
+                next.push_back(u);
+                ++localUpdates;
+              }
+            }
+          }
+        }
+        current.swap(next);
+        return static_cast<uint64_t>(current.size());
+      },
+      stats);
+
+  vector<uint32_t> result(owner.size(), UNREACHED);
+  for (size_t s = 0; s < shardCount; ++s)
+  {
+    for (size_t i = 0; i < shards[s].vertices.size(); ++i)
+    {
+      result[shards[s].vertices[i]] = distance[s][i];
+    }
+  }
+  return result;
+}
+
+// Vertices within k hops
+vector<ShardedGraph::Vertex> ShardedGraph::kHop(Vertex source, uint32_t k,
+                                                ShardStats *stats) const
+{
+  vector<uint32_t> distance = bfs(source, k, stats);
+  vector<Vertex> reached;
+  for (Vertex v = 0; v < distance.size(); ++v)
+  {
+    if (v != source && distance[v] != UNREACHED)
+    {
+      reached.push_back(v);
+    }
+  }
+  return reached;
+}
+
+// Min-label propagation by supersteps
+vector<ShardedGraph::Vertex>
+ShardedGraph::connectedComponents(ShardStats *stats) const
+{
+  size_t shardCount = shards.size();
+  vector<vector<Vertex>> label(shardCount);
+  vector<vector<Vertex>> changed(shardCount);
+  vector<vector<uint32_t>> stamp(shardCount);
+  for (size_t s = 0; s < shardCount; ++s)
+  {
+    label[s] = shards[s].vertices;
+    changed[s] = shards[s].vertices;
+    stamp[s].assign(shards[s].vertices.size(), 0);
+  }
+
+  runSupersteps(
+      shardCount,
+      [&](size_t s, size_t round, const vector<Message> &inbox,
+          vector<vector<Message>> &outboxes, uint64_t &localUpdates) {
+        const Shard &shard = shards[s];
+        vector<Vertex> &labels = label[s];
+        vector<Vertex> &current = changed[s];
+        vector<uint32_t> &seen = stamp[s];
+        uint32_t epoch = static_cast<uint32_t>(round) + 1;
+
+        for (const Message &message : inbox)
+        {
+          uint32_t i = localIndex[message.first];
+          if (message.second < labels[i])
+          {
+            labels[i] = message.second;
+            current.push_back(message.first);
+          }
+        }
+
+        // Send every changed label to the neighbors, once per vertex
+        vector<Vertex> next;
+        for (Vertex v : current)
+        {
+          uint32_t i = localIndex[v];
+          if (seen[i] == epoch)
+          {
+            continue;
+          }
+          seen[i] = epoch;
+          for (uint32_t e = shard.offsets[i]; e < shard.offsets[i + 1]; ++e)
+          {
+            Vertex u = shard.adjacency[e];
+            if (owner[u] != s)
+            {
+              outboxes[owner[u]].emplace_back(u, labels[i]);
+              continue;
+            }
+            uint32_t j = localIndex[u];
+            if (labels[i] < labels[j])
+            {
+              labels[j] = labels[i];
+              next.push_back(u);
+              ++localUpdates;
+            }
+          }
+        }
+        current.swap(next);
+        return static_cast<uint64_t>(current.size());
+      },
+      stats);
+
+  vector<Vertex> result(owner.size());
+  for (size_t s = 0; s < shardCount; ++s)
+  {
+    for (size_t i = 0; i < shards[s].vertices.size(); ++i)
+    {
+      result[shards[s].vertices[i]] = label[s][i];
+    }
+  }
+  return result;
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+    Implementation of ShardedGraph class:
+    ShardedGraph: Split a flat graph into shards by vertex hash or by a
+     given partition.
+    shardCount / vertexCount / ownerOf / cutEdges: Layout of the shards.
+    bfs: Hop distances from one vertex, by bulk-synchronous supersteps.
+    kHop: Vertices within k hops of one vertex.
+    connectedComponents: Component label of every vertex (min-label
+     propagation).
+    idOf / nameOf: The vertex dictionary.
+ * ****************************************************************************
+ * */
+
+#ifndef SHARDEDGRAPH_H
+#define SHARDEDGRAPH_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+struct ShardStats
+{
+  size_t supersteps;              // rounds until no shard had work
+  uint64_t localUpdates;          // updates that stayed inside a shard
+  uint64_t remoteMessages;        // messages sent to another shard
+  uint64_t remoteBytes;           // payload of those messages
+  vector<uint64_t> sentByShard;   // remote messages sent by each shard
+};
+
+/******************************************************************************
+ * Class: ShardedGraph
+ *
+ * Description: Stand-in for a graph spread over several machines. Every
+ *              vertex is owned by one shard, which alone stores its
+ *              adjacency and its algorithm state. Algorithms run as
+ *              bulk-synchronous supersteps with one thread per shard: each
+ *              shard processes its inbox and its local frontier, updates
+ *              its own vertices directly and queues messages for vertices
+ *              of other shards; after a barrier, every shard collects the
+ *              messages addressed to it. Messages to the same vertex are
+ *              combined before they are sent. The message counts show how
+ *              much traffic a real deployment would put on the network.
+ *
+ * Member Variables:
+ *    - dictionary: Username <-> global vertex ID, as in the flat graph.
+ *    - owner: Shard of every global vertex.
+ *    - localIndex: Position of every vertex inside its shard.
+ *    - shards: Vertices and adjacency (global IDs) of each shard.
+ *    - crossEdges: Number of edges between different shards.
+ *
+ *****************************************************************************/
+class ShardedGraph
+{
+public:
+  typedef FlatGraph::Vertex Vertex;
+  static constexpr uint32_t UNREACHED = UINT32_MAX;
+
+  /***** Constructors *****/
+  ShardedGraph(const FlatGraph &graph, size_t shardCount);
+  /*-------------------------------------------------------------------------
+    Assign vertices to shards by a hash of their ID.
+
+    Preconditions: 'shardCount' > 0.
+    Postconditions: The sharded graph does not reference 'graph'.
+  -------------------------------------------------------------------------*/
+
+  ShardedGraph(const FlatGraph &graph, const vector<uint32_t> &partition);
+  /*-------------------------------------------------------------------------
+    Assign vertices to shards by a precomputed partition (e.g. one that
+    minimizes the edges between shards).
+
+    Preconditions: 'partition' has one entry per vertex.
+    Postconditions: There are max(partition) + 1 shards.
+  -------------------------------------------------------------------------*/
+
+  /***** Layout *****/
+  size_t shardCount() const { return shards.size(); }
+  size_t vertexCount() const { return owner.size(); }
+  uint32_t ownerOf(Vertex v) const { return owner[v]; }
+  size_t cutEdges() const { return crossEdges; }
+
+  /***** Algorithms *****/
+  vector<uint32_t> bfs(Vertex source, uint32_t maxHops = UNREACHED,
+                       ShardStats *stats = nullptr) const;
+  /*-------------------------------------------------------------------------
+    Breadth-first search from 'source', one superstep per level.
+
+    Preconditions: 'source' is less than vertexCount().
+    Postconditions: Returns the hop distance of every vertex, UNREACHED if
+                    it is farther than 'maxHops' or cannot be reached.
+                    'stats', if given, receives the message counts.
+  -------------------------------------------------------------------------*/
+
+  vector<Vertex> kHop(Vertex source, uint32_t k,
+                      ShardStats *stats = nullptr) const;
+  /*-------------------------------------------------------------------------
+    Find the vertices within 'k' hops of 'source'.
+
+    Preconditions: 'source' is less than vertexCount().
+    Postconditions: Returns them in increasing ID order, 'source' excluded.
+  -------------------------------------------------------------------------*/
+
+  vector<Vertex> connectedComponents(ShardStats *stats = nullptr) const;
+  /*-------------------------------------------------------------------------
+    Label the connected components: every vertex repeatedly adopts the
+    smallest label among its neighbors until no label changes.
+
+    Preconditions: None.
+    Postconditions: Returns for every vertex the smallest vertex ID in its
+                    component.
+  -------------------------------------------------------------------------*/
+
+  /***** Dictionary *****/
+  Vertex idOf(string_view userName) const { return dictionary.findRow(userName); }
+  string_view nameOf(Vertex v) const { return dictionary.getUserName(v); }
+
+private:
+  struct Shard
+  {
+    vector<Vertex> vertices;  // owned global IDs, increasing
+    vector<uint32_t> offsets; // CSR offsets, per owned vertex
+    vector<Vertex> adjacency; // neighbors (global IDs)
+  };
+
+  void build(const FlatGraph &graph);
+
+  /***** Member Variables *****/
+  UserStore dictionary;        // username <-> vertex ID
+  vector<uint32_t> owner;      // shard of each vertex
+  vector<uint32_t> localIndex; // position inside the owner shard
+  vector<Shard> shards;        // per-shard adjacency
+  size_t crossEdges;           // edges between shards
+};
+
+#endif // END OF THE HEADER FILE
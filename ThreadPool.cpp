@@ -0,0 +1,327 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// One parallelFor call
+struct ThreadPool::Loop
+{
+  const Body *body;
+  size_t grain;
+  atomic<size_t> pending; // ranges not finished yet
+  atomic<size_t> queued;  // ranges of this loop in the deques
+};
+
+namespace
+{
+// Worker index of the current thread, if it belongs to a pool
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+// Nesting of runRange on the current thread, to count busy time once
+thread_local unsigned rangeDepth = 0;
+
+mutex sharedLock;
+unique_ptr<ThreadPool> sharedPool;
+unsigned sharedWorkers = 0;
+bool sharedPinned = false;
+
+// Restrict a thread to one CPU
+void pinToCpu(thread &t, unsigned cpu)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % max(1u, thread::hardware_concurrency()), &set);
+  if (pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) != 0)
+  {
+    cerr << "Error: could not pin a worker thread to CPU " << cpu << endl;
+  }
+#else
+  (void)t;
+  (void)cpu;
+#endif
+}
+} // namespace
+
+// Constructor: start the pool threads
+ThreadPool::ThreadPool(unsigned workers, bool pinThreads)
+    : queued(0), hungry(0), sleepers(0), stopping(false), pinned(pinThreads),
+      started(chrono::steady_clock::now())
+{
+  if (workers == 0)
+  {
+    workers = max(1u, thread::hardware_concurrency());
+  }
+  for (unsigned i = 0; i < workers; ++i)
+  {
+    slots.emplace_back(new Slot());
+  }
+  // Pool threads start out looking for work
+  hungry.store(workers - 1);
+  for (unsigned worker = 1; worker < workers; ++worker)
+  {
+    threads.emplace_back(&ThreadPool::workerMain, this, worker);
+    if (pinned)
+    {
+      pinToCpu(threads.back(), worker);
+    }
+  }
+}
+
+// Destructor: stop and join the pool threads
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard<mutex> guard(sleepLock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (thread &t : threads)
+  {
+    t.join();
+  }
+}
+
+// The project-wide pool
+ThreadPool &ThreadPool::shared()
+{
+  lock_guard<mutex> guard(sharedLock);
+  if (!sharedPool)
+  {
+    sharedPool.reset(new ThreadPool(sharedWorkers, sharedPinned));
+  }
+  return *sharedPool;
+}
+
+// Size and pin the project-wide pool before it starts
+bool ThreadPool::configureShared(unsigned workers, bool pinThreads)
+{
+  lock_guard<mutex> guard(sharedLock);
+  if (sharedPool)
+  {
+    cerr << "Error: the thread pool is already running." << endl;
+    return false;
+  }
+  sharedWorkers = workers;
+  sharedPinned = pinThreads;
+  return true;
+}
+
+// Run a chunked loop on the pool
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const Body &body)
+{
+  if (begin >= end)
+  {
+    return;
+  }
+  if (grain == 0)
+  {
+    grain = max<size_t>(1, (end - begin) / (16 * workerCount()));
+  }
+  unsigned worker = currentPool == this ? currentWorker : 0;
+
+  // The whole loop starts as one range on this thread
+  Loop loop;
+  loop.body = &body;
+  loop.grain = grain;
+  loop.pending.store(1);
+  loop.queued.store(0);
+  runRange(Range{&loop, begin, end}, worker);
+  wait(loop, worker);
+}
+
+// Statistics since the start or the last reset
+PoolStats ThreadPool::stats() const
+{
+  PoolStats result;
+  result.workers = workerCount();
+  chrono::steady_clock::time_point since;
+  {
+    lock_guard<mutex> guard(sleepLock);
+    since = started;
+  }
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - since;
+  result.seconds = elapsed.count();
+  for (const unique_ptr<Slot> &slot : slots)
+  {
+    double busy = slot->busyNanos.load() * 1e-9;
+    result.utilization.push_back(result.seconds > 0 ? busy / result.seconds
+                                                    : 0.0);
+    result.rangesRun.push_back(slot->run.load());
+    result.rangesStolen.push_back(slot->stolen.load());
+    result.rangesSplit.push_back(slot->split.load());
+  }
+  return result;
+}
+
+// Restart the statistics period
+void ThreadPool::resetStats()
+{
+  lock_guard<mutex> guard(sleepLock);
+  for (unique_ptr<Slot> &slot : slots)
+  {
+    slot->busyNanos.store(0);
+    slot->run.store(0);
+    slot->stolen.store(0);
+    slot->split.store(0);
+  }
+  started = chrono::steady_clock::now();
+}
+
+// Main loop of a pool thread: run any range, sleep when there is none
+void ThreadPool::workerMain(unsigned worker)
+{
+  currentPool = this;
+  currentWorker = worker;
+  for (;;)
+  {
+    Range range;
+    if (takeRange(worker, nullptr, range))
+    {
+      --hungry;
+      runRange(range, worker);
+      ++hungry;
+      continue;
+    }
+    unique_lock<mutex> guard(sleepLock);
+    ++sleepers;
+    wake.wait(guard, [&] { return stopping || queued.load() > 0; });
+    --sleepers;
+    if (stopping)
+    {
+      return;
+    }
+  }
+}
+
+// Run a range chunk by chunk, splitting off halves for hungry workers
+void ThreadPool::runRange(Range range, unsigned worker)
+{
+  Loop &loop = *range.loop;
+  Slot &slot = *slots[worker];
+  bool outermost = rangeDepth++ == 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  ++slot.run;
+
+  size_t lo = range.begin;
+  size_t hi = range.end;
+  while (lo < hi)
+  {
+    size_t chunks = (hi - lo + loop.grain - 1) / loop.grain;
+    if (chunks > 1 && hungry.load() > 0)
+    {
+      // Keep the lower half; the split stays on a chunk boundary
+      size_t middle = lo + chunks / 2 * loop.grain;
+      ++loop.pending;
+      push(worker, Range{&loop, middle, hi});
+      ++slot.split;
+      hi = middle;
+      continue;
+    }
+    size_t chunkEnd = min(hi, lo + loop.grain);
+    (*loop.body)(lo, chunkEnd, worker);
+    lo = chunkEnd;
+  }
+
+  if (outermost)
+  {
+    slot.busyNanos += chrono::duration_cast<chrono::nanoseconds>(
+                          chrono::steady_clock::now() - start)
+                          .count();
+  }
+  --rangeDepth;
+  finish(loop);
+}
+
+// Take a range of 'loop' (any loop if null): own deque first, newest
+// range first; then steal the oldest (largest) range of another worker
+bool ThreadPool::takeRange(unsigned worker, const Loop *loop, Range &range)
+{
+  size_t count = slots.size();
+  for (size_t i = 0; i < count; ++i)
+  {
+    Slot &victim = *slots[(worker + i) % count];
+    lock_guard<mutex> guard(victim.lock);
+    if (victim.ranges.empty())
+    {
+      continue;
+    }
+    size_t size = victim.ranges.size();
+    for (size_t j = 0; j < size; ++j)
+    {
+      // Own deque from the back, the others from the front
+      size_t index = i == 0 ? size - 1 - j : j;
+      if (loop != nullptr && victim.ranges[index].loop != loop)
+      {
+        continue;
+      }
+      range = victim.ranges[index];
+      victim.ranges.erase(victim.ranges.begin() + index);
+      --range.loop->queued;
+      --queued;
+      if (i != 0)
+      {
+        ++slots[worker]->stolen;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+// Queue a range on a worker's deque and wake the sleepers
+void ThreadPool::push(unsigned worker, const Range &range)
+{
+  {
+    Slot &slot = *slots[worker];
+    lock_guard<mutex> guard(slot.lock);
+    // Count first, so that a sleeper never misses the range
+    ++range.loop->queued;
+    ++queued;
+    slot.ranges.push_back(range);
+  }
+  if (sleepers.load() > 0)
+  {
+    lock_guard<mutex> guard(sleepLock);
+    wake.notify_all();
+  }
+}
+
+// Help with a loop's ranges until all of them have finished
+void ThreadPool::wait(Loop &loop, unsigned worker)
+{
+  ++hungry;
+  while (loop.pending.load() > 0)
+  {
+    Range range;
+    if (takeRange(worker, &loop, range))
+    {
+      --hungry;
+      runRange(range, worker);
+      ++hungry;
+      continue;
+    }
+    unique_lock<mutex> guard(sleepLock);
+    ++sleepers;
+    wake.wait(guard, [&] {
+      return loop.pending.load() == 0 || loop.queued.load() > 0;
+    });
+    --sleepers;
+  }
+  --hungry;
+}
+
+// Mark a range of a loop as done
+void ThreadPool::finish(Loop &loop)
+{
+  if (--loop.pending == 0)
+  {
+    // The waiting caller may destroy 'loop' from here on
+    lock_guard<mutex> guard(sleepLock);
+    wake.notify_all();
+  }
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+    Implementation of ThreadPool class:
+    shared / configureShared: The project-wide pool behind parallelFor.
+    workerCount: Number of workers, the calling thread included.
+    parallelFor: Run a loop body over [begin, end) in chunks on the pool.
+    stats / resetStats: Utilization and work-stealing counters.
+ * ****************************************************************************
+ * */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct PoolStats
+{
+  unsigned workers;               // slot 0 is shared by outside callers
+  double seconds;                 // since the pool started (or reset)
+  vector<double> utilization;     // share of 'seconds' spent in loop bodies
+  vector<uint64_t> rangesRun;     // ranges executed by each worker
+  vector<uint64_t> rangesStolen;  // ... of which taken from another worker
+  vector<uint64_t> rangesSplit;   // ranges each worker split off for others
+};
+
+/******************************************************************************
+ * Class: ThreadPool
+ *
+ * Description: Work-stealing pool shared by all parallel graph algorithms,
+ *              so that they do not start threads of their own. A loop
+ *              starts as one range on the calling thread. A worker runs its
+ *              range one chunk at a time, and while other workers are out
+ *              of work it splits the rest of the range in half and pushes
+ *              the upper half on its own deque. Workers take work from the
+ *              back of their own deque and steal from the front of the
+ *              others', where the largest ranges are. Ranges are split only
+ *              on demand, so a loop over a hub-heavy graph keeps every
+ *              worker busy, while a loop on a busy pool costs no splitting.
+ *              A thread waiting for a loop (possibly nested in another
+ *              loop's body) helps with that loop's ranges only, so the
+ *              worker indexes of one loop never run concurrently.
+ *
+ * Member Variables:
+ *    - threads: The pool threads (workers 1 .. workerCount() - 1).
+ *    - slots: Deque, lock and counters of every worker; slot 0 belongs to
+ *             the threads outside the pool.
+ *    - queued: Ranges waiting in the deques.
+ *    - hungry: Workers looking for work; ranges are split while > 0.
+ *    - sleepLock / wake: Idle and waiting threads sleep on 'wake'.
+ *    - sleepers: Threads sleeping on 'wake'.
+ *    - stopping: Set by the destructor.
+ *    - pinned: Whether pool threads are pinned to CPUs.
+ *    - started: Start of the statistics period.
+ *
+ *****************************************************************************/
+class ThreadPool
+{
+public:
+  typedef function<void(size_t, size_t, unsigned)> Body;
+
+  /***** Constructors *****/
+  explicit ThreadPool(unsigned workers = 0, bool pinThreads = false);
+  /*-------------------------------------------------------------------------
+    Start 'workers' - 1 pool threads; the thread calling parallelFor is the
+    remaining worker.
+
+    Preconditions: None. 0 workers means one per hardware thread.
+    Postconditions: With 'pinThreads', pool thread i runs only on CPU i
+                    (Linux only; elsewhere the flag is ignored).
+  -------------------------------------------------------------------------*/
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+  /*-------------------------------------------------------------------------
+    Stop and join the pool threads.
+
+    Preconditions: No parallelFor is running.
+    Postconditions: None.
+  -------------------------------------------------------------------------*/
+
+  /***** Shared Pool *****/
+  static ThreadPool &shared();
+  static bool configureShared(unsigned workers, bool pinThreads);
+  /*-------------------------------------------------------------------------
+    shared() returns the project-wide pool, created on first use with one
+    worker per hardware thread. configureShared() sets its size and
+    pinning instead.
+
+    Preconditions: configureShared() is called before the first shared().
+    Postconditions: configureShared() returns false and reports an error
+                    if the shared pool already exists.
+  -------------------------------------------------------------------------*/
+
+  /***** Loops *****/
+  unsigned workerCount() const { return static_cast<unsigned>(slots.size()); }
+
+  void parallelFor(size_t begin, size_t end, size_t grain, const Body &body);
+  /*-------------------------------------------------------------------------
+    Run body(chunkBegin, chunkEnd, worker) on every chunk of 'grain'
+    indexes of [begin, end); chunk i is [begin + i * grain, ...). A grain
+    of 0 picks about 16 chunks per worker.
+
+    Preconditions: 'body' is safe to call concurrently for different
+                   chunks.
+    Postconditions: Returns after every chunk has run. 'worker' is in
+                    [0, workerCount()) and no two concurrent calls of this
+                    loop share it. Nested calls are allowed.
+  -------------------------------------------------------------------------*/
+
+  /***** Statistics *****/
+  PoolStats stats() const;
+  void resetStats();
+
+private:
+  struct Loop;
+
+  struct Range
+  {
+    Loop *loop;
+    size_t begin;
+    size_t end;
+  };
+
+  struct alignas(64) Slot
+  {
+    mutex lock;
+    deque<Range> ranges;
+    atomic<uint64_t> busyNanos{0};
+    atomic<uint64_t> run{0};
+    atomic<uint64_t> stolen{0};
+    atomic<uint64_t> split{0};
+  };
+
+  void workerMain(unsigned worker);
+  void runRange(Range range, unsigned worker);
+  bool takeRange(unsigned worker, const Loop *loop, Range &range);
+  void push(unsigned worker, const Range &range);
+  void wait(Loop &loop, unsigned worker);
+  void finish(Loop &loop);
+
+  /***** Member Variables *****/
+  vector<thread> threads;             // pool threads
+  vector<unique_ptr<Slot>> slots;     // per-worker deque and counters
+  atomic<size_t> queued;              // ranges in the deques
+  atomic<unsigned> hungry;            // workers looking for work
+  mutable mutex sleepLock;            // guards sleeping and 'started'
+  condition_variable wake;            // new ranges, finished loops, stop
+  atomic<unsigned> sleepers;          // threads waiting on 'wake'
+  bool stopping;                      // destructor called
+  bool pinned;                        // pool threads pinned to CPUs
+  chrono::steady_clock::time_point started; // start of the statistics
+};
+
+#endif // END OF THE HEADER FILE
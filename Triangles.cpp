@@ -0,0 +1,156 @@
+#include "Triangles.h"
+#include "AnalyticsJob.h"
+#include "Parallel.h"
+#include "SetOps.h"
+#include <atomic>
+
+namespace
+{
+// Out-lists longer than this are intersected through a marker array
+const uint32_t MARKER_THRESHOLD = 32;
+} // namespace
+
+// Count triangles and derive the clustering coefficients
+TriangleStats countTriangles(const FlatGraph &graph, JobContext *context)
+{
+  typedef FlatGraph::Vertex Vertex;
+  size_t n = graph.vertexCount();
+
+  // Orient every edge from the lower-ranked to the higher-ranked end
+  auto ranksBelow = [&graph](Vertex a, Vertex b) {
+    uint32_t da = graph.degree(a), db = graph.degree(b);
+    return da != db ? da < db : a < b;
+  };
+  vector<uint32_t> outOffsets(n + 1, 0);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      count += ranksBelow(v, graph.neighbors(v)[i]);
+    }
+    outOffsets[v + 1] = outOffsets[v] + count;
+  }
+  vector<Vertex> out(outOffsets[n]);
+  for (Vertex v = 0; v < n; ++v)
+  {
+    // Filtering a sorted slice keeps the out-list sorted
+    uint32_t pos = outOffsets[v];
+    for (uint32_t i = 0; i < graph.degree(v); ++i)
+    {
+      Vertex u = graph.neighbors(v)[i];
+      if (ranksBelow(v, u))
+      {
+        out[pos++] = u;
+      }
+    }
+  }
+
+  vector<atomic<uint64_t>> counts(n);
+  vector<vector<uint8_t>> markers(workerCount());
+  vector<vector<Vertex>> scratch(workerCount());
+  if (context != nullptr)
+  {
+    context->setTotal(n);
+  }
+  parallelFor(0, n, 64, [&](size_t lo, size_t hi, unsigned worker) {
+    if (context != nullptr && context->cancelled())
+    {
+      return;
+    }
+    vector<uint8_t> &marker = markers[worker];
+    vector<Vertex> &common = scratch[worker];
+    for (Vertex u = static_cast<Vertex>(lo); u < hi; ++u)
+    {
+      const Vertex *outU = out.data() + outOffsets[u];
+      uint32_t du = outOffsets[u + 1] - outOffsets[u];
+      bool useMarker = du > MARKER_THRESHOLD;
+      if (useMarker)
+      {
+        marker.resize(n, 0);
+        for (uint32_t i = 0; i < du; ++i)
+        {
+          marker[outU[i]] = 1;
+        }
+      }
+      common.resize(du);
+
+      uint64_t found = 0;
+      for (uint32_t i = 0; i < du; ++i)
+      {
+        Vertex v = outU[i];
+        const Vertex *outV = out.data() + outOffsets[v];
+        uint32_t dv = outOffsets[v + 1] - outOffsets[v];
+        uint64_t local = 0;
+        if (useMarker)
+        {
+          for (uint32_t j = 0; j < dv; ++j)
+          {
+            if (marker[outV[j]])
+            {
+              counts[outV[j]].fetch_add(1, memory_order_relaxed);
+              ++local;
+            }
+          }
+        }
+        else
+        {
+          size_t m = intersectSorted(outU, du, outV, dv, common.data());
+          for (size_t j = 0; j < m; ++j)
+          {
+            counts[common[j]].fetch_add(1, memory_order_relaxed);
+          }
+          local = m;
+        }
+        if (local)
+        {
+          counts[v].fetch_add(local, memory_order_relaxed);
+          found += local;
+        }
+      }
+      if (found)
+      {
+        counts[u].fetch_add(found, memory_order_relaxed);
+      }
+
+      if (useMarker)
+      {
+        for (uint32_t i = 0; i < du; ++i)
+        {
+          marker[outU[i]] = 0;
+        }
+      }
+    }
+    if (context != nullptr)
+    {
+      context->advance(hi - lo);
+    }
+  });
+
+  // Derive the coefficients
+  TriangleStats stats;
+  stats.triangles.resize(n);
+  stats.clustering.resize(n, 0.0);
+  uint64_t cornerSum = 0;
+  double triples = 0.0, clusteringSum = 0.0;
+  for (Vertex v = 0; v < n; ++v)
+  {
+    uint64_t t = counts[v].load(memory_order_relaxed);
+    double d = graph.degree(v);
+    stats.triangles[v] = t;
+    cornerSum += t;
+    if (d >= 2)
+    {
+      double pairs = d * (d - 1) / 2.0;
+      stats.clustering[v] = t / pairs;
+      triples += pairs;
+      clusteringSum += stats.clustering[v];
+    }
+  }
+  // Every triangle has three corners
+  stats.totalTriangles = cornerSum / 3;
+  stats.averageClustering = n ? clusteringSum / n : 0.0;
+  stats.transitivity = triples > 0 ? 3.0 * stats.totalTriangles / triples
+                                   : 0.0;
+  return stats;
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+    Triangle counting and clustering coefficients:
+    TriangleStats: Per-user and global triangle statistics.
+    countTriangles: Compute TriangleStats for a flat graph in parallel.
+ * ****************************************************************************
+ * */
+
+#ifndef TRIANGLES_H
+#define TRIANGLES_H
+
+#include "FlatGraph.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class JobContext;
+
+struct TriangleStats
+{
+  vector<uint64_t> triangles; // triangles through each vertex
+  vector<double> clustering;  // local clustering coefficient per vertex
+  uint64_t totalTriangles;    // distinct triangles in the graph
+  double averageClustering;   // mean local clustering over all vertices
+  double transitivity;        // 3 * triangles / connected triples
+};
+
+/******************************************************************************
+ * Function: countTriangles
+ *
+ * Purpose: Count triangles with a degree-ordered orientation: every edge is
+ *          kept only from its lower-ranked end (rank = degree, then ID), so
+ *          each triangle is found exactly once and hubs have short
+ *          out-lists. Out-lists are intersected with a SIMD merge, or with
+ *          a per-worker marker array when the source out-list is long.
+ *          Source vertices are spread over the parallelFor workers.
+ *          'context' (if any) receives progress per source vertex and can
+ *          cancel the count.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: Returns the statistics; vectors are indexed by vertex ID.
+ *                 A cancelled count is partial.
+ *****************************************************************************/
+TriangleStats countTriangles(const FlatGraph &graph,
+                             JobContext *context = nullptr);
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,297 @@
+#include "TrigramIndex.h"
+#include "SetOps.h"
+#include "UserIndex.h"
+#include "UserProfile.h"
+#include <algorithm>
+
+// Constructor
+TrigramIndex::TrigramIndex() : deadDocs(0) {}
+
+// Index a user under the trigrams of its username and names
+void TrigramIndex::addUser(UserProfile *user)
+{
+  uint32_t doc = static_cast<uint32_t>(docs.size());
+  docs.push_back(user);
+  docOf[user] = doc;
+
+  vector<uint32_t> trigrams;
+  trigramsOf(user->getUserName(), true, trigrams);
+  trigramsOf(user->getFirstName(), true, trigrams);
+  trigramsOf(user->getLastName(), true, trigrams);
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+  // Document IDs only grow, so appending keeps every list sorted
+  for (uint32_t trigram : trigrams)
+  {
+    append(postings[trigram], doc);
+  }
+}
+
+// Tombstone a user; rebuild once tombstones dominate
+void TrigramIndex::removeUser(const UserProfile *user)
+{
+  auto entry = docOf.find(user);
+  if (entry == docOf.end())
+  {
+    return;
+  }
+  docs[entry->second] = nullptr;
+  docOf.erase(entry);
+  ++deadDocs;
+  if (deadDocs > 64 && deadDocs > docOf.size())
+  {
+    rebuild();
+  }
+}
+
+void TrigramIndex::clear()
+{
+  postings.clear();
+  docs.clear();
+  docOf.clear();
+  deadDocs = 0;
+}
+
+// "Did you mean" lookup
+vector<TrigramIndex::Match> TrigramIndex::suggest(string_view query,
+                                                  size_t limit,
+                                                  double minScore) const
+{
+  vector<uint32_t> trigrams;
+  trigramsOf(query, true, trigrams);
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+  // Count the query trigrams shared by each document
+  unordered_map<uint32_t, uint32_t> shared;
+  vector<uint32_t> scratch;
+  for (uint32_t trigram : trigrams)
+  {
+    auto list = postings.find(trigram);
+    if (list == postings.end())
+    {
+      continue;
+    }
+    decode(list->second, scratch);
+    for (uint32_t doc : scratch)
+    {
+      if (docs[doc] != nullptr)
+      {
+        ++shared[doc];
+      }
+    }
+  }
+
+  // Keep the documents sharing the most trigrams as candidates
+  vector<pair<uint32_t, uint32_t>> candidates(shared.begin(), shared.end());
+  size_t pool = max<size_t>(limit * 8, 32);
+  if (candidates.size() > pool)
+  {
+    nth_element(candidates.begin(), candidates.begin() + pool,
+                candidates.end(),
+                [](const pair<uint32_t, uint32_t> &a,
+                   const pair<uint32_t, uint32_t> &b) {
+                  return a.second > b.second;
+                });
+    candidates.resize(pool);
+  }
+
+  // Rescore the candidates against each field
+  vector<Match> matches;
+  for (const auto &candidate : candidates)
+  {
+    UserProfile *user = docs[candidate.first];
+    double score = max({similarity(query, user->getUserName()),
+                        similarity(query, user->getFirstName()),
+                        similarity(query, user->getLastName())});
+    if (score >= minScore)
+    {
+      matches.push_back({user, score});
+    }
+  }
+  sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+    if (a.score != b.score)
+    {
+      return a.score > b.score;
+    }
+    return a.user->getUserName() < b.user->getUserName();
+  });
+  if (matches.size() > limit)
+  {
+    matches.resize(limit);
+  }
+  return matches;
+}
+
+// Substring lookup by posting list intersection
+vector<UserProfile *> TrigramIndex::findSubstring(string_view query,
+                                                  size_t limit) const
+{
+  vector<uint32_t> trigrams;
+  trigramsOf(query, false, trigrams);
+  if (trigrams.empty())
+  {
+    return {};
+  }
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+  // Intersect the shortest lists first
+  vector<const PostingList *> lists;
+  for (uint32_t trigram : trigrams)
+  {
+    auto list = postings.find(trigram);
+    if (list == postings.end())
+    {
+      return {};
+    }
+    lists.push_back(&list->second);
+  }
+  sort(lists.begin(), lists.end(),
+       [](const PostingList *a, const PostingList *b) {
+         return a->count < b->count;
+       });
+
+  vector<uint32_t> result, scratch;
+  decode(*lists[0], result);
+  for (size_t i = 1; i < lists.size() && !result.empty(); ++i)
+  {
+    decode(*lists[i], scratch);
+    result.resize(intersectSorted(result.data(), result.size(),
+                                  scratch.data(), scratch.size(),
+                                  result.data()));
+  }
+
+  // Trigrams can match out of order, so verify the candidates
+  string needle = UserIndex::normalize(query);
+  vector<UserProfile *> users;
+  for (uint32_t doc : result)
+  {
+    UserProfile *user = docs[doc];
+    if (user == nullptr)
+    {
+      continue;
+    }
+    for (const string *text :
+         {&user->getUserName(), &user->getFirstName(), &user->getLastName()})
+    {
+      if (UserIndex::normalize(*text).find(needle) != string::npos)
+      {
+        users.push_back(user);
+        break;
+      }
+    }
+    if (users.size() >= limit)
+    {
+      break;
+    }
+  }
+  return users;
+}
+
+// Typo-tolerant similarity based on the optimal string alignment distance
+double TrigramIndex::similarity(string_view a, string_view b)
+{
+  string s = UserIndex::normalize(a), t = UserIndex::normalize(b);
+  size_t n = s.size(), m = t.size();
+  if (n == 0 && m == 0)
+  {
+    return 1.0;
+  }
+
+  // Three rolling rows: i-2, i-1 and i
+  vector<size_t> prev2(m + 1), prev(m + 1), row(m + 1);
+  for (size_t j = 0; j <= m; ++j)
+  {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= n; ++i)
+  {
+    row[0] = i;
+    for (size_t j = 1; j <= m; ++j)
+    {
+      size_t cost = (s[i - 1] == t[j - 1]) ? 0 : 1;
+      row[j] = min({prev[j] + 1, row[j - 1] + 1, prev[j - 1] + cost});
+      if (i > 1 && j > 1 && s[i - 1] == t[j - 2] && s[i - 2] == t[j - 1])
+      {
+        row[j] = min(row[j], prev2[j - 2] + 1);
+      }
+    }
+    prev2.swap(prev);
+    prev.swap(row);
+  }
+  return 1.0 - static_cast<double>(prev[m]) / max(n, m);
+}
+
+// Append the trigrams of a string, packed three bytes per integer
+void TrigramIndex::trigramsOf(string_view text, bool padded,
+                              vector<uint32_t> &out)
+{
+  // Padding adds word-boundary trigrams, which weigh the first letters
+  string s = padded ? "  " + UserIndex::normalize(text) + " "
+                    : UserIndex::normalize(text);
+  for (size_t i = 0; i + 3 <= s.size(); ++i)
+  {
+    out.push_back(static_cast<uint32_t>(static_cast<unsigned char>(s[i]))
+                      << 16 |
+                  static_cast<uint32_t>(static_cast<unsigned char>(s[i + 1]))
+                      << 8 |
+                  static_cast<unsigned char>(s[i + 2]));
+  }
+}
+
+// Append a document ID as a varint-encoded delta
+void TrigramIndex::append(PostingList &list, uint32_t doc)
+{
+  uint32_t delta = list.bytes.empty() ? doc : doc - list.last;
+  while (delta >= 0x80)
+  {
+    list.bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+    delta >>= 7;
+  }
+  list.bytes.push_back(static_cast<uint8_t>(delta));
+  list.last = doc;
+  ++list.count;
+}
+
+// Decode a posting list into a sorted array of document IDs
+void TrigramIndex::decode(const PostingList &list, vector<uint32_t> &out)
+{
+  out.resize(list.count);
+  uint32_t value = 0;
+  size_t pos = 0;
+  for (uint32_t i = 0; i < list.count; ++i)
+  {
+    uint32_t delta = 0;
+    int shift = 0;
+    uint8_t byte;
+    do
+    {
+      byte = list.bytes[pos++];
+      delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    value += delta;
+    out[i] = value;
+  }
+}
+
+// Re-index the live users with fresh, dense document IDs
+void TrigramIndex::rebuild()
+{
+  vector<UserProfile *> live;
+  live.reserve(docOf.size());
+  for (UserProfile *user : docs)
+  {
+    if (user != nullptr)
+    {
+      live.push_back(user);
+    }
+  }
+  clear();
+  for (UserProfile *user : live)
+  {
+    addUser(user);
+  }
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+    Implementation of TrigramIndex class:
+    addUser: Index the trigrams of a user's username, first and last name.
+    removeUser: Drop a user from the index.
+    clear: Empty the index.
+    suggest: "Did you mean" lookup ranked by similarity.
+    findSubstring: Users whose username or name contains a string.
+    similarity: Typo-tolerant similarity between two strings.
+ * ****************************************************************************
+ * */
+
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class UserProfile;
+
+/******************************************************************************
+ * Class: TrigramIndex
+ *
+ * Description: Inverted index from character trigrams to the users whose
+ *              username, first name or last name contains them. Every user
+ *              gets a document ID that only grows, so posting lists stay
+ *              sorted by appending; they are stored delta + varint encoded
+ *              and decoded into scratch arrays for (SIMD) intersection.
+ *              Removed users are tombstoned and the index is rebuilt once
+ *              tombstones outnumber live users.
+ *
+ * Member Variables:
+ *    - postings: Trigram -> compressed posting list.
+ *    - docs: Document ID -> user (nullptr once removed).
+ *    - docOf: User -> current document ID.
+ *    - deadDocs: Number of tombstoned document IDs.
+ *
+ *****************************************************************************/
+class TrigramIndex
+{
+public:
+  struct Match
+  {
+    UserProfile *user; // matching user
+    double score;      // similarity in [0, 1]
+  };
+
+  TrigramIndex();
+
+  /***** Maintenance *****/
+  void addUser(UserProfile *user);
+  /*-------------------------------------------------------------------------
+    Index a user.
+
+    Preconditions: 'user' is a valid pointer that is not indexed yet.
+    Postconditions: The user can be found by suggest() and findSubstring().
+  -------------------------------------------------------------------------*/
+
+  void removeUser(const UserProfile *user);
+  /*-------------------------------------------------------------------------
+    Remove a user from the index.
+
+    Preconditions: None.
+    Postconditions: The user is no longer returned by any query.
+  -------------------------------------------------------------------------*/
+
+  void clear();
+
+  /***** Queries *****/
+  vector<Match> suggest(string_view query, size_t limit,
+                        double minScore = 0.6) const;
+  /*-------------------------------------------------------------------------
+    Find users whose username, first or last name is similar to 'query'.
+    Candidates sharing the most trigrams with the query are rescored with
+    similarity() against each field.
+
+    Preconditions: None.
+    Postconditions: Returns at most 'limit' matches scoring at least
+                    'minScore', best first.
+  -------------------------------------------------------------------------*/
+
+  vector<UserProfile *> findSubstring(string_view query, size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Find users whose username, first or last name contains 'query',
+    ignoring case, by intersecting the posting lists of its trigrams.
+
+    Preconditions: 'query' has at least 3 characters.
+    Postconditions: Returns at most 'limit' users, in indexing order.
+  -------------------------------------------------------------------------*/
+
+  static double similarity(string_view a, string_view b);
+  /*-------------------------------------------------------------------------
+    Similarity between two strings (case-insensitive): 1 minus the
+    optimal string alignment distance divided by the longer length.
+
+    Preconditions: None.
+    Postconditions: Returns a value in [0, 1]; 1 means equal.
+  -------------------------------------------------------------------------*/
+
+private:
+  struct PostingList
+  {
+    vector<uint8_t> bytes; // delta + varint encoded document IDs
+    uint32_t count;        // number of encoded IDs
+    uint32_t last;         // last encoded ID, base of the next delta
+  };
+
+  static void trigramsOf(string_view text, bool padded,
+                         vector<uint32_t> &out);
+  static void append(PostingList &list, uint32_t doc);
+  static void decode(const PostingList &list, vector<uint32_t> &out);
+  void rebuild();
+
+  /***** Member Variables *****/
+  unordered_map<uint32_t, PostingList> postings; // trigram -> documents
+  vector<UserProfile *> docs;                    // document -> user
+  unordered_map<const UserProfile *, uint32_t> docOf; // user -> document
+  size_t deadDocs;                               // tombstoned documents
+};
+
+#endif // END OF THE HEADER FILE
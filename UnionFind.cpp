@@ -0,0 +1,83 @@
+#include "UnionFind.h"
+#include <utility>
+
+// Constructor
+UnionFind::UnionFind() : sets(0) {}
+
+// Add a singleton element
+uint32_t UnionFind::add()
+{
+  uint32_t x = static_cast<uint32_t>(parent.size());
+  parent.push_back(x);
+  rank.push_back(0);
+  size.push_back(1);
+  countSet(1, +1);
+  ++sets;
+  return x;
+}
+
+// Find the root, halving the path on the way
+uint32_t UnionFind::find(uint32_t x)
+{
+  while (parent[x] != x)
+  {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
+}
+
+// Merge two sets, attaching the shallower tree under the deeper one
+bool UnionFind::unite(uint32_t a, uint32_t b)
+{
+  a = find(a);
+  b = find(b);
+  if (a == b)
+  {
+    return false;
+  }
+  if (rank[a] < rank[b])
+  {
+    swap(a, b);
+  }
+  countSet(size[a], -1);
+  countSet(size[b], -1);
+  parent[b] = a;
+  size[a] += size[b];
+  if (rank[a] == rank[b])
+  {
+    ++rank[a];
+  }
+  countSet(size[a], +1);
+  --sets;
+  return true;
+}
+
+// Statistics
+size_t UnionFind::sizeOf(uint32_t x) { return size[find(x)]; }
+size_t UnionFind::setCount() const { return sets; }
+size_t UnionFind::elementCount() const { return parent.size(); }
+const map<size_t, size_t> &UnionFind::sizeHistogram() const
+{
+  return histogram;
+}
+
+void UnionFind::clear()
+{
+  parent.clear();
+  rank.clear();
+  size.clear();
+  histogram.clear();
+  sets = 0;
+}
+
+// Adjust the histogram entry of one set size
+void UnionFind::countSet(size_t setSize, int delta)
+{
+  size_t &count = histogram[setSize];
+  count += delta;
+  if (count == 0)
+  {
+    histogram.erase(setSize);
+  }
+}
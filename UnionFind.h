@@ -0,0 +1,93 @@
+/******************************************************************************
+    Implementation of UnionFind class:
+    add: Add a new singleton element.
+    find: Representative of an element's set (with path compression).
+    unite: Merge the sets of two elements (union by rank).
+    sizeOf: Size of an element's set.
+    setCount: Number of disjoint sets.
+    sizeHistogram: Number of sets of each size.
+    clear: Remove every element.
+ * ****************************************************************************
+ * */
+
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+/******************************************************************************
+ * Class: UnionFind
+ *
+ * Description: Disjoint-set forest over dense element IDs with path
+ *              compression and union by rank, so find/unite run in
+ *              amortized O(alpha(n)). The number of sets and a histogram of
+ *              set sizes are maintained on every union.
+ *
+ * Member Variables:
+ *    - parent: Parent of each element (roots point to themselves).
+ *    - rank: Upper bound on the height of each root's tree.
+ *    - size: Number of elements under each root.
+ *    - histogram: Set size -> number of sets of that size.
+ *    - sets: Number of disjoint sets.
+ *
+ *****************************************************************************/
+class UnionFind
+{
+public:
+  UnionFind();
+
+  uint32_t add();
+  /*-------------------------------------------------------------------------
+    Add a new element in a set of its own.
+
+    Preconditions: None.
+    Postconditions: Returns the new element's ID.
+  -------------------------------------------------------------------------*/
+
+  uint32_t find(uint32_t x);
+  /*-------------------------------------------------------------------------
+    Find the representative of the set containing 'x', halving the path.
+
+    Preconditions: 'x' was returned by add().
+    Postconditions: Returns the root element of the set.
+  -------------------------------------------------------------------------*/
+
+  bool unite(uint32_t a, uint32_t b);
+  /*-------------------------------------------------------------------------
+    Merge the sets containing 'a' and 'b'.
+
+    Preconditions: 'a' and 'b' were returned by add().
+    Postconditions: Returns true if two different sets were merged.
+  -------------------------------------------------------------------------*/
+
+  size_t sizeOf(uint32_t x);
+  size_t setCount() const;
+  size_t elementCount() const;
+  const map<size_t, size_t> &sizeHistogram() const;
+  /*-------------------------------------------------------------------------
+    Set statistics: size of the set of 'x', number of sets, number of
+    elements, and the number of sets of each size.
+
+    Preconditions: 'x' was returned by add().
+    Postconditions: None.
+  -------------------------------------------------------------------------*/
+
+  void clear();
+
+private:
+  void countSet(size_t setSize, int delta);
+
+  /***** Member Variables *****/
+  vector<uint32_t> parent;    // parent element
+  vector<uint8_t> rank;       // tree height bound per root
+  vector<uint32_t> size;      // set size per root
+  map<size_t, size_t> histogram; // set size -> number of sets
+  size_t sets;                // number of sets
+};
+
+#endif // END OF THE HEADER FILE
@@ -0,0 +1,104 @@
+#include "UserIndex.h"
+#include "UserProfile.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <unordered_set>
+
+// Index a user's email and names
+bool UserIndex::addUser(UserProfile *user)
+{
+  if (!byEmail.tryEmplace(normalize(user->getEmail()), user).second)
+  {
+    return false;
+  }
+  byName.emplace(NameKey(normalize(user->getFirstName()), user->getUserId(),
+                         FIRST_NAME),
+                 user);
+  byName.emplace(NameKey(normalize(user->getLastName()), user->getUserId(),
+                         LAST_NAME),
+                 user);
+  return true;
+}
+
+// Drop a user from every index
+void UserIndex::removeUser(const UserProfile *user)
+{
+  string email = normalize(user->getEmail());
+  UserProfile **owner = byEmail.get(email);
+  if (owner != nullptr && *owner == user)
+  {
+    byEmail.erase(email);
+  }
+  byName.erase(NameKey(normalize(user->getFirstName()), user->getUserId(),
+                       FIRST_NAME));
+  byName.erase(NameKey(normalize(user->getLastName()), user->getUserId(),
+                       LAST_NAME));
+}
+
+void UserIndex::clear()
+{
+  byEmail.clear();
+  byName.clear();
+}
+
+// Exact email lookup
+UserProfile *UserIndex::findByEmail(string_view email) const
+{
+  UserProfile *const *user = byEmail.get(normalize(email));
+  return user ? *user : nullptr;
+}
+
+// Names starting with a prefix
+vector<UserProfile *> UserIndex::findByNamePrefix(string_view prefix,
+                                                  size_t limit) const
+{
+  string key = normalize(prefix);
+  auto from = byName.lower_bound(NameKey(key, INT_MIN, FIRST_NAME));
+  return scanNames(from, key, string_view(), limit);
+}
+
+// Names inside [low, high)
+vector<UserProfile *> UserIndex::findByNameRange(string_view low,
+                                                 string_view high,
+                                                 size_t limit) const
+{
+  auto from = byName.lower_bound(NameKey(normalize(low), INT_MIN, FIRST_NAME));
+  string upper = normalize(high);
+  return scanNames(from, string_view(), upper, limit);
+}
+
+// Walk the ordered name index until the prefix/upper bound or the limit
+vector<UserProfile *>
+UserIndex::scanNames(map<NameKey, UserProfile *>::const_iterator from,
+                     string_view prefix, string_view high, size_t limit) const
+{
+  vector<UserProfile *> result;
+  unordered_set<UserProfile *> seen;
+  for (auto it = from; it != byName.end() && result.size() < limit; ++it)
+  {
+    const string &name = get<0>(it->first);
+    if (name.compare(0, prefix.size(), prefix) != 0)
+    {
+      break;
+    }
+    if (!high.empty() && name >= high)
+    {
+      break;
+    }
+    if (seen.insert(it->second).second)
+    {
+      result.push_back(it->second);
+    }
+  }
+  return result;
+}
+
+// Lower-case a key
+string UserIndex::normalize(string_view key)
+{
+  string result(key);
+  transform(result.begin(), result.end(), result.begin(),
+            [](unsigned char c) { return static_cast<char>(tolower(c)); });
+  return result;
+}
@@ -0,0 +1,120 @@
+/******************************************************************************
+    Implementation of UserIndex class:
+    addUser: Index a user's email and first/last names.
+    removeUser: Drop a user from every index.
+    clear: Empty every index.
+    findByEmail: Exact (case-insensitive) email lookup.
+    findByNamePrefix: First/last names starting with a prefix.
+    findByNameRange: First/last names inside a [low, high) range.
+    normalize: Lower-case a key the way the indexes store it.
+ * ****************************************************************************
+ * */
+
+#ifndef USERINDEX_H
+#define USERINDEX_H
+
+#include "FlatHashMap.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+class UserProfile;
+
+/******************************************************************************
+ * Class: UserIndex
+ *
+ * Description: Secondary indexes over user profiles, maintained by the
+ *              Graph as users are added, removed and edited.
+ *
+ * Member Variables:
+ *    - byEmail: Hash index from normalized email to profile (unique).
+ *    - byName: Ordered index keyed by (normalized name, user ID, field),
+ *              holding one entry for the first name and one for the last
+ *              name of every user.
+ *
+ *****************************************************************************/
+class UserIndex
+{
+public:
+  /***** Maintenance *****/
+  bool addUser(UserProfile *user);
+  /*-------------------------------------------------------------------------
+    Index a user.
+
+    Preconditions: 'user' is a valid pointer that is not indexed yet.
+    Postconditions: Returns false (and indexes nothing) if the email is
+                    already used by another user; otherwise true.
+  -------------------------------------------------------------------------*/
+
+  void removeUser(const UserProfile *user);
+  /*-------------------------------------------------------------------------
+    Remove a user from every index, using its current attributes.
+
+    Preconditions: 'user' was indexed with its current attributes.
+    Postconditions: The user can no longer be found through the indexes.
+  -------------------------------------------------------------------------*/
+
+  void clear();
+  /*-------------------------------------------------------------------------
+    Empty every index.
+
+    Preconditions: None.
+    Postconditions: All indexes are empty.
+  -------------------------------------------------------------------------*/
+
+  /***** Queries *****/
+  UserProfile *findByEmail(string_view email) const;
+  /*-------------------------------------------------------------------------
+    Look up a user by email, ignoring case.
+
+    Preconditions: None.
+    Postconditions: Returns the user, or nullptr if the email is unused.
+  -------------------------------------------------------------------------*/
+
+  vector<UserProfile *> findByNamePrefix(string_view prefix,
+                                         size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Find users whose first or last name starts with 'prefix', ignoring
+    case.
+
+    Preconditions: None.
+    Postconditions: Returns at most 'limit' distinct users, ordered by the
+                    matching name.
+  -------------------------------------------------------------------------*/
+
+  vector<UserProfile *> findByNameRange(string_view low, string_view high,
+                                        size_t limit) const;
+  /*-------------------------------------------------------------------------
+    Find users whose first or last name lies in [low, high), ignoring case.
+    An empty 'high' means no upper bound.
+
+    Preconditions: None.
+    Postconditions: Returns at most 'limit' distinct users, ordered by the
+                    matching name.
+  -------------------------------------------------------------------------*/
+
+  static string normalize(string_view key);
+
+private:
+  enum NameField
+  {
+    FIRST_NAME,
+    LAST_NAME
+  };
+  typedef tuple<string, int, int> NameKey; // (name, user ID, NameField)
+
+  vector<UserProfile *> scanNames(map<NameKey, UserProfile *>::const_iterator
+                                      from,
+                                  string_view prefix, string_view high,
+                                  size_t limit) const;
+
+  /***** Member Variables *****/
+  FlatHashMap<UserProfile *> byEmail;  // email -> user
+  map<NameKey, UserProfile *> byName;  // first/last name -> user
+};
+
+#endif // END OF THE HEADER FILE
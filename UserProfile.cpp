@@ -7,38 +7,65 @@ int UserProfile::userIdCounter = 0;
 UserProfile::UserProfile(const string &userName, const string &firstName,
                          const string &lastName, const string &email) {
   userId = ++userIdCounter;
-  setUser(userName, firstName, lastName, email);
+  listener = nullptr;
+  assign(userName, firstName, lastName, email);
 }
 
 // Setters
 void UserProfile::setUserName(const string &userName) {
-  this->userName = userName;
+  setUser(userName, firstName, lastName, email);
 }
 
 void UserProfile::setFirstName(const string &firstName) {
-  this->firstName = firstName;
+  setUser(userName, firstName, lastName, email);
 }
 
 void UserProfile::setLastName(const string &lastName) {
-  this->lastName = lastName;
+  setUser(userName, firstName, lastName, email);
 }
 
-void UserProfile::setEmail(const string &email) { this->email = email; }
+void UserProfile::setEmail(const string &email) {
+  setUser(userName, firstName, lastName, email);
+}
 
 void UserProfile::setUser(const string &username, const string &firstName,
                           const string &lastName, const string &email) {
-  setUserName(username);
-  setFirstName(firstName);
-  setLastName(lastName);
-  setEmail(email);
+  // An owner validates and applies the change under its own lock
+  if (listener != nullptr) {
+    listener->changeProfile(*this, username, firstName, lastName, email);
+    return;
+  }
+  assign(username, firstName, lastName, email);
+}
+
+void UserProfile::setListener(UserProfileListener *listener) {
+  this->listener = listener;
+}
+
+// Write the attributes
+void UserProfile::assign(const string &username, const string &firstName,
+                         const string &lastName, const string &email) {
+  // Copy first: the arguments may alias the members being overwritten
+  string newUserName = username, newFirstName = firstName,
+         newLastName = lastName, newEmail = email;
+  this->userName = std::move(newUserName);
+  this->firstName = std::move(newFirstName);
+  this->lastName = std::move(newLastName);
+  this->email = std::move(newEmail);
+}
+
+void UserProfileListener::assign(UserProfile &user, const string &userName,
+                                 const string &firstName,
+                                 const string &lastName, const string &email) {
+  user.assign(userName, firstName, lastName, email);
 }
 
 // Getters
 int UserProfile::getUserId() const { return userId; }
-string UserProfile::getUserName() const { return userName; }
-string UserProfile::getFirstName() const { return firstName; }
-string UserProfile::getLastName() const { return lastName; }
-string UserProfile::getEmail() const { return email; }
+const string &UserProfile::getUserName() const { return userName; }
+const string &UserProfile::getFirstName() const { return firstName; }
+const string &UserProfile::getLastName() const { return lastName; }
+const string &UserProfile::getEmail() const { return email; }
 
 // Display user information
 string UserProfile::displayUserInfo() const {
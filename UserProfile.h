@@ -3,16 +3,17 @@
  *
  * UserProfile: Constructor with username, first name, last name, and email.
  * getUserId: Getter for the user ID.
- * getUserName: Getter for the username.
- * getFirstName: Getter for the first name.
- * getLastName: Getter for the last name.
- *  getEmail: Getter for the email.
+ * getUserName: Getter for the username (by const reference).
+ * getFirstName: Getter for the first name (by const reference).
+ * getLastName: Getter for the last name (by const reference).
+ *  getEmail: Getter for the email (by const reference).
  * setUserName: Setter for the username.
  * setFirstName: Setter for the first name.
  * setLastName: Setter for the last name.
  * setEmail: Setter for the email.
  * setUser: Setter for all user attributes.
  * displayUserInfo: Display user information.
+ * setListener: Attach an owner that applies every change.
  * */
 
 #ifndef USERPROFILE_H
@@ -23,6 +24,45 @@
 
 using namespace std;
 
+class UserProfile;
+
+/******************************************************************************
+ * Class: UserProfileListener
+ *
+ * Description: Owner of a UserProfile (the Graph). The setters of a profile
+ *              with a listener hand the change to it, so that the owner
+ *              can validate the change, write the attributes and update
+ *              its username key and secondary indexes as one step, under
+ *              its own lock.
+ *****************************************************************************/
+class UserProfileListener {
+public:
+  virtual ~UserProfileListener() {}
+
+  virtual bool changeProfile(UserProfile &user, const string &userName,
+                             const string &firstName, const string &lastName,
+                             const string &email) = 0;
+  /*-------------------------------------------------------------------------
+    Called by the setters instead of writing the attributes.
+
+    Preconditions: The arguments may refer to the attributes of 'user'.
+    Postconditions: Returns false to reject the change (e.g. the new
+  username or email is already taken); the profile is then left unchanged.
+  Otherwise the listener has written the attributes with assign().
+  -------------------------------------------------------------------------*/
+
+protected:
+  static void assign(UserProfile &user, const string &userName,
+                     const string &firstName, const string &lastName,
+                     const string &email);
+  /*-------------------------------------------------------------------------
+    Write the attributes of 'user' without notifying anyone.
+
+    Preconditions: Called from changeProfile().
+    Postconditions: 'user' holds the new attributes.
+  -------------------------------------------------------------------------*/
+};
+
 class UserProfile {
 public:
   /******** Function Members ********/
@@ -47,36 +87,37 @@ public:
     Postconditions: Returns the user ID as an integer.
   -------------------------------------------------------------------------*/
 
-  string getUserName() const;
+  const string &getUserName() const;
   /*-------------------------------------------------------------------------
     Retrieve the username.
 
     Preconditions: None.
-    Postconditions: Returns the username as a string.
+    Postconditions: Returns a reference to the username, valid until the
+  profile is modified or destroyed.
   -------------------------------------------------------------------------*/
 
-  string getFirstName() const;
+  const string &getFirstName() const;
   /*-------------------------------------------------------------------------
     Retrieve the first name.
 
     Preconditions: None.
-    Postconditions: Returns the first name as a string.
+    Postconditions: Returns a reference to the first name.
   -------------------------------------------------------------------------*/
 
-  string getLastName() const;
+  const string &getLastName() const;
   /*-------------------------------------------------------------------------
     Retrieve the last name.
 
     Preconditions: None.
-    Postconditions: Returns the last name as a string.
+    Postconditions: Returns a reference to the last name.
   -------------------------------------------------------------------------*/
 
-  string getEmail() const;
+  const string &getEmail() const;
   /*-------------------------------------------------------------------------
     Retrieve the email.
 
     Preconditions: None.
-    Postconditions: Returns the email as a string.
+    Postconditions: Returns a reference to the email.
   -------------------------------------------------------------------------*/
 
   /***** Setters *****/
@@ -121,6 +162,14 @@ public:
     Postconditions: Updates all user attributes with the specified values.
   -------------------------------------------------------------------------*/
 
+  void setListener(UserProfileListener *listener);
+  /*-------------------------------------------------------------------------
+    Attach (or detach, with nullptr) the listener that applies changes.
+
+    Preconditions: None.
+    Postconditions: Later setter calls go through 'listener'.
+  -------------------------------------------------------------------------*/
+
   /***** Display User Info *****/
   string displayUserInfo() const;
   /*-------------------------------------------------------------------------
@@ -131,12 +180,17 @@ public:
   -------------------------------------------------------------------------*/
 
 private:
+  friend class UserProfileListener;
+  void assign(const string &userName, const string &firstName,
+              const string &lastName, const string &email);
+
   static int userIdCounter; // Counter for generating unique user IDs
   int userId;               // User ID
   string userName;          // Username
   string firstName;         // First name
   string lastName;          // Last name
   string email;             // Email
+  UserProfileListener *listener; // Owner that applies changes
 };
 
 #endif // END OF THE HEADER FILE
@@ -0,0 +1,184 @@
+#include "UserStore.h"
+#include "UserProfile.h"
+#include <functional>
+
+// Constructor
+UserStore::UserStore() : offsets(1, 0), usedSlots(0), liveCount(0) {}
+
+// Append a user from an existing profile
+UserStore::Row UserStore::addUser(const UserProfile &profile)
+{
+  return addUser(profile.getUserId(), profile.getUserName(),
+                 profile.getFirstName(), profile.getLastName(),
+                 profile.getEmail());
+}
+
+// Append a user from its raw fields
+UserStore::Row UserStore::addUser(int userId, string_view userName,
+                                  string_view firstName, string_view lastName,
+                                  string_view email)
+{
+  Row row = static_cast<Row>(userIds.size());
+  if (findRow(userName) != NO_ROW)
+  {
+    return NO_ROW;
+  }
+  // At most half full, so probes stay short and always reach an empty slot
+  if ((usedSlots + 1) * 2 > nameSlots.size())
+  {
+    rehash(liveCount + 1);
+  }
+  size_t slot = findSlot(userName); // before the arena may move
+
+  // The trailing end offset of the previous row becomes this row's start
+  for (string_view text : {userName, firstName, lastName, email})
+  {
+    arena.append(text.data(), text.size());
+    offsets.push_back(static_cast<uint32_t>(arena.size()));
+  }
+  userIds.push_back(userId);
+  live.push_back(1);
+  ++liveCount;
+  nameSlots[slot] = row;
+  ++usedSlots;
+  return row;
+}
+
+// Mark a user row as removed
+bool UserStore::removeUser(string_view userName)
+{
+  size_t slot = findSlot(userName);
+  if (slot == nameSlots.size() || nameSlots[slot] == NO_ROW)
+  {
+    return false;
+  }
+  live[nameSlots[slot]] = 0;
+  nameSlots[slot] = REMOVED_ROW; // later probes must pass over it
+  --liveCount;
+  return true;
+}
+
+// Rewrite the columns without the removed rows
+void UserStore::compact()
+{
+  UserStore compacted;
+  compacted.reserve(liveCount, arena.size());
+  for (Row row = 0; row < rowCount(); ++row)
+  {
+    if (live[row])
+    {
+      compacted.addUser(userIds[row], getUserName(row), getFirstName(row),
+                        getLastName(row), getEmail(row));
+    }
+  }
+  *this = std::move(compacted);
+}
+
+// Reserve capacity for a bulk load
+void UserStore::reserve(size_t rows, size_t textBytes)
+{
+  arena.reserve(textBytes);
+  offsets.reserve(rows * FIELD_COUNT + 1);
+  userIds.reserve(rows);
+  live.reserve(rows);
+  if (rows * 2 > nameSlots.size())
+  {
+    rehash(rows);
+  }
+}
+
+// Slot holding a username, or the empty slot where it would go
+size_t UserStore::findSlot(string_view userName) const
+{
+  if (nameSlots.empty())
+  {
+    return 0;
+  }
+  size_t mask = nameSlots.size() - 1;
+  for (size_t slot = hash<string_view>()(userName) & mask;;
+       slot = (slot + 1) & mask)
+  {
+    Row row = nameSlots[slot];
+    if (row == NO_ROW || (row != REMOVED_ROW && getUserName(row) == userName))
+    {
+      return slot;
+    }
+  }
+}
+
+// Rebuild the lookup table for 'rows' live users, dropping removed marks
+void UserStore::rehash(size_t rows)
+{
+  size_t capacity = 16;
+  while (capacity < rows * 2)
+  {
+    capacity *= 2;
+  }
+  nameSlots.assign(capacity, NO_ROW);
+  usedSlots = 0;
+  for (Row row = 0; row < rowCount(); ++row)
+  {
+    if (live[row])
+    {
+      nameSlots[findSlot(getUserName(row))] = row;
+      ++usedSlots;
+    }
+  }
+}
+
+// Lookup
+UserStore::Row UserStore::findRow(string_view userName) const
+{
+  size_t slot = findSlot(userName);
+  return slot < nameSlots.size() ? nameSlots[slot] : NO_ROW;
+}
+
+bool UserStore::isLive(Row row) const
+{
+  return row < rowCount() && live[row];
+}
+
+size_t UserStore::size() const { return liveCount; }
+size_t UserStore::rowCount() const { return userIds.size(); }
+
+// Column accessors
+int UserStore::getUserId(Row row) const { return userIds[row]; }
+string_view UserStore::getUserName(Row row) const
+{
+  return field(row, USER_NAME);
+}
+string_view UserStore::getFirstName(Row row) const
+{
+  return field(row, FIRST_NAME);
+}
+string_view UserStore::getLastName(Row row) const
+{
+  return field(row, LAST_NAME);
+}
+string_view UserStore::getEmail(Row row) const { return field(row, EMAIL); }
+
+string_view UserStore::field(Row row, Field f) const
+{
+  size_t index = static_cast<size_t>(row) * FIELD_COUNT + f;
+  return string_view(arena).substr(offsets[index],
+                                   offsets[index + 1] - offsets[index]);
+}
+
+// Memory held by the columns and the arena
+size_t UserStore::memoryUsage() const
+{
+  return arena.capacity() + offsets.capacity() * sizeof(uint32_t) +
+         userIds.capacity() * sizeof(int) + live.capacity() +
+         nameSlots.capacity() * sizeof(Row);
+}
+
+// Display user information
+string UserStore::displayUserInfo(Row row) const
+{
+  string info = "User ID: " + to_string(getUserId(row)) + "\n";
+  info.append("Username: ").append(getUserName(row)).append("\n");
+  info.append("First Name: ").append(getFirstName(row)).append("\n");
+  info.append("Last Name: ").append(getLastName(row)).append("\n");
+  info.append("Email: ").append(getEmail(row)).append("\n");
+  return info;
+}
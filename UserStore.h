@@ -0,0 +1,179 @@
+/******************************************************************************
+    Implementation of UserStore class:
+    UserStore: Constructor for an empty store.
+    addUser: Append a user row (from a UserProfile or from raw fields).
+    removeUser: Mark a user row as removed.
+    findRow: Look up the row of a username.
+    isLive: Check whether a row still holds a user.
+    getUserId / getUserName / getFirstName / getLastName / getEmail:
+     Column accessors returning string_view into the shared arena.
+    size: Number of live users.
+    rowCount: Number of rows, including removed ones.
+    compact: Drop removed rows and reclaim their arena space.
+    memoryUsage: Bytes held by the columns and the arena.
+    displayUserInfo: Format a row the same way as UserProfile.
+ * ****************************************************************************
+ * */
+
+#ifndef USERSTORE_H
+#define USERSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class UserProfile;
+
+/******************************************************************************
+ * Class: UserStore
+ *
+ * Description: Column-oriented storage for user profiles. The text of every
+ *              profile lives in one shared arena; each row only owns a user
+ *              ID and four fixed-width offsets into it. Rows are dense
+ *              integers, so algorithms that only need IDs never touch the
+ *              profile text at all. Graph itself keeps its users as
+ *              UserProfile objects (their pointers are handed out and their
+ *              setters re-index the graph); a UserStore is the column copy
+ *              that buildUserStore() exports and that the flat forms of the
+ *              graph use as their vertex dictionary.
+ *
+ * Member Variables:
+ *    - arena: Concatenated text of all username/first/last/email fields.
+ *    - offsets: FIELD_COUNT offsets per row plus a trailing end offset; a
+ *               field ends where the next one starts.
+ *    - userIds: User ID column.
+ *    - live: 1 if the row holds a user, 0 if it was removed.
+ *    - nameSlots: Username to row lookup: an open-addressing table of
+ *                 rows, hashed and compared through the usernames in
+ *                 'arena', so no name is stored twice.
+ *    - usedSlots: Slots of 'nameSlots' holding a row or a removed mark.
+ *    - liveCount: Number of live rows.
+ *
+ *****************************************************************************/
+class UserStore
+{
+public:
+  typedef uint32_t Row;
+  static constexpr Row NO_ROW = UINT32_MAX;
+
+  /***** Constructors *****/
+  UserStore();
+  /*-------------------------------------------------------------------------
+    Construct an empty store.
+
+    Preconditions: None.
+    Postconditions: An empty store is created.
+  -------------------------------------------------------------------------*/
+
+  /***** Modifiers *****/
+  Row addUser(const UserProfile &profile);
+  Row addUser(int userId, string_view userName, string_view firstName,
+              string_view lastName, string_view email);
+  /*-------------------------------------------------------------------------
+    Append a user as a new row.
+
+    Preconditions: None.
+    Postconditions: Returns the new row, or NO_ROW if the username is
+                    already stored.
+  -------------------------------------------------------------------------*/
+
+  bool removeUser(string_view userName);
+  /*-------------------------------------------------------------------------
+    Remove a user. The row is only marked as removed; its arena space is
+    reclaimed by compact().
+
+    Preconditions: None.
+    Postconditions: Returns true if the user was found and removed.
+  -------------------------------------------------------------------------*/
+
+  void compact();
+  /*-------------------------------------------------------------------------
+    Rewrite the columns without removed rows.
+
+    Preconditions: None.
+    Postconditions: Removed rows and their text are gone. Live rows are
+                    renumbered densely, keeping their relative order.
+  -------------------------------------------------------------------------*/
+
+  void reserve(size_t rows, size_t textBytes);
+  /*-------------------------------------------------------------------------
+    Reserve room ahead of a bulk load.
+
+    Preconditions: None.
+    Postconditions: Column and arena capacity is at least the given sizes.
+  -------------------------------------------------------------------------*/
+
+  /***** Lookup *****/
+  Row findRow(string_view userName) const;
+  /*-------------------------------------------------------------------------
+    Look up the row of a username.
+
+    Preconditions: None.
+    Postconditions: Returns the row, or NO_ROW if the user is not stored.
+  -------------------------------------------------------------------------*/
+
+  bool isLive(Row row) const;
+  size_t size() const;
+  size_t rowCount() const;
+
+  /***** Column Accessors *****/
+  int getUserId(Row row) const;
+  string_view getUserName(Row row) const;
+  string_view getFirstName(Row row) const;
+  string_view getLastName(Row row) const;
+  string_view getEmail(Row row) const;
+  /*-------------------------------------------------------------------------
+    Read one field of a row. The returned views stay valid until the next
+    addUser() or compact().
+
+    Preconditions: 'row' is less than rowCount().
+    Postconditions: Returns the field without copying it.
+  -------------------------------------------------------------------------*/
+
+  size_t memoryUsage() const;
+  /*-------------------------------------------------------------------------
+    Report the bytes held by the columns, the arena and the username
+    lookup table.
+
+    Preconditions: None.
+    Postconditions: Returns the number of bytes in use.
+  -------------------------------------------------------------------------*/
+
+  string displayUserInfo(Row row) const;
+  /*-------------------------------------------------------------------------
+    Format a row the same way as UserProfile::displayUserInfo.
+
+    Preconditions: 'row' is less than rowCount().
+    Postconditions: Returns the user information as a string.
+  -------------------------------------------------------------------------*/
+
+private:
+  enum Field
+  {
+    USER_NAME,
+    FIRST_NAME,
+    LAST_NAME,
+    EMAIL,
+    FIELD_COUNT
+  };
+
+  static constexpr Row REMOVED_ROW = NO_ROW - 1; // slot of a removed user
+
+  string_view field(Row row, Field f) const;
+  size_t findSlot(string_view userName) const;
+  void rehash(size_t rows);
+
+  /***** Member Variables *****/
+  string arena;             // shared text of all rows
+  vector<uint32_t> offsets; // FIELD_COUNT offsets per row + end offset
+  vector<int> userIds;      // user ID column
+  vector<uint8_t> live;     // row still holds a user
+  vector<Row> nameSlots;    // username -> row, keys read from 'arena'
+  size_t usedSlots;         // rows and removed marks in 'nameSlots'
+  size_t liveCount;         // number of live rows
+};
+
+#endif // END OF THE HEADER FILE
@@ -28,14 +28,19 @@
      Function to read users from a file and add them to the graph.
     readConnectionsFromFile:
      Function to read connections from a file and add them to the graph.
+    suggestSimilarUsers:
+     Function to print "did you mean" suggestions for an unknown user name.
     main: The main function that drives the execution of the program.
     **************************************************************************/
 
 #include "Connection.h"
 #include "Graph.h"
 #include "UserProfile.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <random>
 #include <sstream>
 #include <type_traits>
@@ -245,19 +250,134 @@ void readUsersFromFile(const string &fileName, Graph &graph);
 void readConnectionsFromFile(const string &folderName,
                              const string &fileName, Graph &graph);
 
+/******************************************************************************
+ * Function: suggestSimilarUsers
+ *
+ * Purpose: Print the users whose names resemble a user name that was not
+ *          found, so a misspelled name can be corrected.
+ *
+ * Preconditions:
+ *    - 'graph' is a valid Graph object.
+ *
+ * Postconditions: Suggestions, if any, are printed.
+ *****************************************************************************/
+void suggestSimilarUsers(const Graph &graph, const string &userName);
+
+// Users with their scores, highest first
+typedef vector<pair<string, double>> RankedUsers;
+
+/******************************************************************************
+ * Struct: AnalysisJobs
+ *
+ * Description: Background jobs of the graph analysis, kept across visits
+ *              of the menu so each runs once per version of the graph.
+ *
+ * Member Variables:
+ *    - graph: Snapshot the jobs run on; a new one restarts them.
+ *    - brokerageSamples: Sources the betweenness job samples; 0 = exact.
+ *    - The job handles; null until submitted or after a cancellation.
+ *
+ *****************************************************************************/
+struct AnalysisJobs
+{
+  shared_ptr<const FlatGraph> graph;                // snapshot analyzed
+  size_t brokerageSamples = 0;                      // 0: exact betweenness
+  shared_ptr<AnalyticsJob<int>> diameter;           // longest distance
+  shared_ptr<AnalyticsJob<TriangleStats>> triangles; // clustering
+  shared_ptr<AnalyticsJob<size_t>> components;      // connected components
+  shared_ptr<AnalyticsJob<vector<uint32_t>>> cores; // core numbers
+  shared_ptr<AnalyticsJob<CommunityResult>> communities; // Louvain
+  shared_ptr<AnalyticsJob<RankedUsers>> influencers; // top PageRank
+  shared_ptr<AnalyticsJob<RankedUsers>> brokers;     // top betweenness
+};
+
+/******************************************************************************
+ * Function: displayGraphAnalysis
+ *
+ * Purpose: Display the degree statistics and the results of the analysis
+ *          jobs. Jobs are (re)submitted when the graph changed since they
+ *          started; a job still running is shown with its progress.
+ *
+ * Preconditions:
+ *    - 'graph' is a valid Graph object.
+ *
+ * Postconditions: The analysis is printed; 'jobs' holds the running jobs.
+ *****************************************************************************/
+void displayGraphAnalysis(Graph &graph, AnalysisJobs &jobs);
+
+/******************************************************************************
+ * Function: cancelAnalysis
+ *
+ * Purpose: Cancel the analysis jobs that were submitted.
+ *
+ * Preconditions: None.
+ *
+ * Postconditions: The jobs stop at their next check; handles are kept.
+ *****************************************************************************/
+void cancelAnalysis(AnalysisJobs &jobs);
+
+/******************************************************************************
+ * Function: jobDone
+ *
+ * Purpose: Wait for a job until 'deadline' and print "label: computing
+ *          (N%)" if it is still running, or a note if it was cancelled.
+ *
+ * Preconditions:
+ *    - 'job' is not null.
+ *
+ * Postconditions: Returns whether the job's result can be printed; a
+ *                 cancelled job is reset so the next visit restarts it.
+ *****************************************************************************/
+template <typename T>
+bool jobDone(const string &label, shared_ptr<AnalyticsJob<T>> &job,
+             chrono::steady_clock::time_point deadline);
+
+/******************************************************************************
+ * Function: topUsers
+ *
+ * Purpose: Pick the 'k' highest scores of a flat graph and name their users.
+ *
+ * Preconditions:
+ *    - 'scores' holds one score per vertex of 'graph'.
+ *
+ * Postconditions: Returns at most 'k' users, highest score first.
+ *****************************************************************************/
+RankedUsers topUsers(const FlatGraph &graph, const vector<double> &scores,
+                     size_t k);
+
 int main()
 {
-  // Create a graph object
-  Graph graph;
-  // Read users from a file and add them to the graph
-  readUsersFromFile("resources/users.txt", graph);
+  // Create a graph object; thread-safe so that it checkpoints in the
+  // background while the menu runs
+  Graph graph(true);
+  // Restore the graph saved by earlier runs; changes are logged to 'data'
+  RecoveryStats recovery;
+  bool stored = graph.openStorage("data", StorageOptions(), &recovery);
+  if (stored && recovery.found)
+  {
+    cout << "Restored " << graph.getNumOfUsers() << " users in "
+         << recovery.seconds * 1000 << " ms (" << recovery.replayedRecords
+         << " logged changes replayed)" << endl;
+  }
+  else
+  {
+    if (!stored)
+    {
+      cout << "Changes will not be saved in this session." << endl;
+      graph.clearUsers();
+    }
+    // Read users from a file and add them to the graph
+    readUsersFromFile("resources/users.txt", graph);
 
-  // Read connections from a file and add them to the graph
-  readConnectionsFromFile("resources", "connections.txt", graph);
+    // Read connections from a file and add them to the graph
+    readConnectionsFromFile("resources", "connections.txt", graph);
+  }
 
   int choice;
   char choiceOfUser;
   string userName;
+  // Background analysis jobs and the graph snapshot they run on
+  AnalysisJobs analysisJobs;
   do
   {
     displayMenu();
@@ -316,15 +436,11 @@ int main()
       break;
     case 13:
       // Display graph analysis
-      cout << "Average Degree: " << graph.calculateAverageDegree() << endl;
-      cout << "Diameter: " << graph.calculateDiameter() << endl;
-      cout << "\nThe number of Users : " << graph.getNumOfUsers() << endl;
-      cout << "\nThe number of connections : " << graph.getNumOfConnections()
-           << endl;
+      displayGraphAnalysis(graph, analysisJobs);
       break;
     case 14:
       // Visualize graph
-      graph.generateDOTFile("graph.dot");
+      graph.generateDOTFile("graph.dot", true);
       graph.renderGraph("graph.dot", "graph.png");
       break;
     case 15:
@@ -346,6 +462,11 @@ int main()
     case 18:
       // Exit
       cout << "Exiting program..." << endl;
+      if (stored)
+      {
+        cout << (graph.closeStorage() ? "Graph saved." : "Graph not saved.")
+             << endl;
+      }
       break;
     default:
       cout << "Invalid choice. Please enter a valid option." << endl;
@@ -401,6 +522,13 @@ void addUserToGraph(Graph &graph)
       cout << "Enter email: ";
       cin >> email;
 
+      if (graph.isEmailTaken(email))
+      {
+        cout << "The email '" << email
+             << "' is already registered. Please try again." << endl;
+        continue;
+      }
+
       // Create UserProfile object and add it to the graph
       UserProfile *user = new UserProfile(username, fname, lname, email);
       if (graph.addUser(user))
@@ -472,6 +600,7 @@ void addConnectionBetweenUsers(Graph &graph)
   {
     cout << "User not found. Please enter a valid user name next time."
          << endl;
+    suggestSimilarUsers(graph, user1);
     return;
   }
   cout << "Enter the second user name: ";
@@ -480,6 +609,7 @@ void addConnectionBetweenUsers(Graph &graph)
   {
     cout << "User not found. Please enter a valid user name next time."
          << endl;
+    suggestSimilarUsers(graph, user2);
     return;
   }
   cout << "Enter the weight of the connection (when a negative weight is "
@@ -498,7 +628,7 @@ void addConnectionBetweenUsers(Graph &graph)
   }
   else
   {
-    cout << "Failed to add connection. One or both users not found or "
+    cout << "Failed to add connection. The users are the same or the "
             "connection already exists."
          << endl;
     delete connection; // Clean up memory
@@ -591,6 +721,10 @@ void isUserConnectedToAnother(Graph &graph)
   else
   {
     cout << "User " << user1 << " is not connected to user " << user2 << endl;
+    if (graph.sameComponent(user1, user2))
+    {
+      cout << "They can still reach each other through other users." << endl;
+    }
   }
 }
 
@@ -652,6 +786,7 @@ void shortestPathBetweenUsers(Graph &graph)
     if (!graph.searchUser(user1))
     {
       cout << "User not found. Please enter a valid user name." << endl;
+      suggestSimilarUsers(graph, user1);
       continue;
     }
 
@@ -663,6 +798,7 @@ void shortestPathBetweenUsers(Graph &graph)
     if (!graph.searchUser(user2))
     {
       cout << "User not found. Please enter a valid user name." << endl;
+      suggestSimilarUsers(graph, user2);
       continue;
     }
 
@@ -741,6 +877,32 @@ void getAndDisplayConnectionsOfUser(Graph &graph)
     cout << user << ", ";
   }
   cout << endl;
+
+  // Size of the wider network, hop by hop
+  EgoNetwork network = graph.kHopNeighborhood(userName, 3, 10000);
+  if (!network.users.empty())
+  {
+    cout << "Network within 3 hops: ";
+    for (uint32_t hop = 1; hop < network.hopCounts.size(); ++hop)
+    {
+      cout << network.hopCounts[hop] << " at hop " << hop << ", ";
+    }
+    cout << (network.truncated ? "(limit reached)" : "") << endl;
+  }
+
+  // Friends of friends ranked by mutual friends
+  vector<pair<UserProfile *, double>> suggestions =
+      graph.suggestFriends(userName, 5);
+  if (!suggestions.empty())
+  {
+    cout << "People you may know: ";
+    for (const auto &suggestion : suggestions)
+    {
+      cout << suggestion.first->getUserName() << " (" << suggestion.second
+           << " mutual), ";
+    }
+    cout << endl;
+  }
 }
 
 // option 15
@@ -816,6 +978,8 @@ void readUsersFromFile(const string &fileName, Graph &graph)
     return;
   }
 
+  // Readers see the whole file at once
+  graph.beginBatch();
   string line;
   while (getline(file, line))
   {
@@ -825,6 +989,7 @@ void readUsersFromFile(const string &fileName, Graph &graph)
 
     graph.addUser(new UserProfile(userName, firstName, lastName, email));
   }
+  graph.endBatch();
 
   file.close();
 }
@@ -841,6 +1006,8 @@ void readConnectionsFromFile(const string &folderName, const string &fileName,
     return;
   }
 
+  // Readers see the whole file at once
+  graph.beginBatch();
   string line;
   while (getline(file, line))
   {
@@ -858,6 +1025,257 @@ void readConnectionsFromFile(const string &folderName, const string &fileName,
       graph.addConnection(connection);
     }
   }
+  graph.endBatch();
 
   file.close();
-}
\ No newline at end of file
+}
+
+// Print "did you mean" suggestions for an unknown user name
+void suggestSimilarUsers(const Graph &graph, const string &userName)
+{
+  vector<UserProfile *> suggestions = graph.suggestUsers(userName, 3);
+  if (suggestions.empty())
+  {
+    return;
+  }
+  cout << "Did you mean: ";
+  for (size_t i = 0; i < suggestions.size(); ++i)
+  {
+    cout << (i ? ", " : "") << suggestions[i]->getUserName();
+  }
+  cout << "?" << endl;
+}
+
+void displayGraphAnalysis(Graph &graph, AnalysisJobs &jobs)
+{
+  cout << "Average Degree: " << graph.calculateAverageDegree() << endl;
+  cout << "Max Degree: " << graph.getMaxDegree() << endl;
+  cout << "Total Connection Weight: " << graph.getTotalWeight() << endl;
+
+  // Whole-graph analytics run in the background on a snapshot; restart
+  // them only once the graph has changed
+  shared_ptr<const FlatGraph> flat = graph.flatGraph();
+  if (jobs.graph != flat)
+  {
+    cancelAnalysis(jobs);
+    jobs = AnalysisJobs();
+    jobs.graph = flat;
+    // Exact betweenness is O(users * connections); sample large graphs
+    // from a fixed number of sources
+    const size_t brokerageSamples = 1000;
+    if (flat->vertexCount() > brokerageSamples)
+    {
+      jobs.brokerageSamples = brokerageSamples;
+    }
+  }
+  if (jobs.diameter == nullptr)
+  {
+    jobs.diameter = graph.submitDiameter();
+  }
+  if (jobs.triangles == nullptr)
+  {
+    jobs.triangles = graph.submitAnalytics<TriangleStats>(
+        [](const FlatGraph &snapshot, JobContext &context) {
+          return countTriangles(snapshot, &context);
+        });
+  }
+  if (jobs.components == nullptr)
+  {
+    jobs.components = graph.submitAnalytics<size_t>(
+        [](const FlatGraph &snapshot, JobContext &context) {
+          UnionFind components;
+          context.setTotal(snapshot.vertexCount());
+          for (FlatGraph::Vertex v = 0; v < snapshot.vertexCount(); ++v)
+          {
+            components.add();
+          }
+          for (FlatGraph::Vertex v = 0;
+               v < snapshot.vertexCount() && !context.cancelled(); ++v)
+          {
+            for (uint32_t i = 0; i < snapshot.degree(v); ++i)
+            {
+              components.unite(v, snapshot.neighbors(v)[i]);
+            }
+            context.advance();
+          }
+          return components.setCount();
+        });
+  }
+  if (jobs.cores == nullptr)
+  {
+    jobs.cores = graph.submitAnalytics<vector<uint32_t>>(
+        [](const FlatGraph &snapshot, JobContext &context) {
+          // Peel in parallel once the graph is large
+          return computeCoreNumbers(snapshot, snapshot.vertexCount() > 100000,
+                                    &context);
+        });
+  }
+  if (jobs.communities == nullptr)
+  {
+    jobs.communities = graph.submitAnalytics<CommunityResult>(
+        [](const FlatGraph &snapshot, JobContext &context) {
+          return detectCommunities(snapshot, CommunityOptions(), &context);
+        });
+  }
+  if (jobs.influencers == nullptr)
+  {
+    jobs.influencers = graph.submitAnalytics<RankedUsers>(
+        [](const FlatGraph &snapshot, JobContext &context) {
+          PageRank ranking(snapshot, PageRankOptions());
+          return topUsers(snapshot, ranking.run({}, {}, &context).scores, 3);
+        });
+  }
+  if (jobs.brokers == nullptr)
+  {
+    BetweennessOptions brokerage;
+    brokerage.samples = jobs.brokerageSamples;
+    jobs.brokers = graph.submitAnalytics<RankedUsers>(
+        [brokerage](const FlatGraph &snapshot, JobContext &context) {
+          return topUsers(
+              snapshot,
+              calculateBetweenness(snapshot, brokerage, &context).centrality,
+              3);
+        });
+  }
+
+  // Give quick jobs a moment, then show the rest with their progress
+  chrono::steady_clock::time_point deadline =
+      chrono::steady_clock::now() + chrono::milliseconds(200);
+  if (jobDone("Diameter", jobs.diameter, deadline))
+  {
+    cout << "Diameter: " << jobs.diameter->get() << endl;
+  }
+  if (jobDone("Triangles", jobs.triangles, deadline))
+  {
+    const TriangleStats &triangles = jobs.triangles->get();
+    cout << "Triangles: " << triangles.totalTriangles << endl;
+    cout << "Average Clustering Coefficient: "
+         << triangles.averageClustering << endl;
+    cout << "Transitivity: " << triangles.transitivity << endl;
+  }
+  if (jobDone("Connected Components", jobs.components, deadline))
+  {
+    cout << "Connected Components: " << jobs.components->get() << endl;
+  }
+  if (jobDone("Degeneracy (max core)", jobs.cores, deadline))
+  {
+    const vector<uint32_t> &cores = jobs.cores->get();
+    uint32_t degeneracy =
+        cores.empty() ? 0 : *max_element(cores.begin(), cores.end());
+    cout << "Degeneracy (max core): " << degeneracy << " ("
+         << count(cores.begin(), cores.end(), degeneracy) << " users)"
+         << endl;
+    cout << "Users outside the 2-core: "
+         << count_if(cores.begin(), cores.end(),
+                     [](uint32_t core) { return core < 2; })
+         << endl;
+  }
+  if (jobDone("Communities", jobs.communities, deadline))
+  {
+    const CommunityResult &communities = jobs.communities->get();
+    cout << "Communities: " << communities.communityCount << " (modularity "
+         << communities.modularity << ")" << endl;
+  }
+  if (jobDone("Top Influencers", jobs.influencers, deadline))
+  {
+    cout << "Top Influencers: ";
+    for (const auto &influencer : jobs.influencers->get())
+    {
+      cout << influencer.first << " (" << influencer.second << "), ";
+    }
+    cout << endl;
+  }
+  if (jobDone("Top Brokers", jobs.brokers, deadline))
+  {
+    cout << "Top Brokers: ";
+    for (const auto &broker : jobs.brokers->get())
+    {
+      cout << broker.first << " (" << broker.second << "), ";
+    }
+    cout << endl;
+    if (jobs.brokerageSamples > 0)
+    {
+      BetweennessOptions brokerage;
+      cout << "  (sampled from " << jobs.brokerageSamples
+           << " users: scores within "
+           << errorForSamples(jobs.graph->vertexCount(),
+                              jobs.brokerageSamples, brokerage.delta)
+           << " with probability " << 1.0 - brokerage.delta << ")" << endl;
+    }
+  }
+
+  // Adjacency memory per connection, flat vs. compressed
+  size_t connections = flat->edgeCount();
+  if (connections > 0)
+  {
+    cout << "Adjacency bytes per connection: flat "
+         << static_cast<double>(flat->adjacencyBytes()) / connections
+         << ", compressed "
+         << static_cast<double>(graph.compressedGraph()->adjacencyBytes()) /
+                connections
+         << endl;
+  }
+  cout << "\nThe number of Users : " << graph.getNumOfUsers() << endl;
+  cout << "\nThe number of connections : " << graph.getNumOfConnections()
+       << endl;
+}
+
+void cancelAnalysis(AnalysisJobs &jobs)
+{
+  // Results for an older graph are no longer shown; stop computing them
+  auto cancel = [](auto &job) {
+    if (job != nullptr)
+    {
+      job->cancel();
+    }
+  };
+  cancel(jobs.diameter);
+  cancel(jobs.triangles);
+  cancel(jobs.components);
+  cancel(jobs.cores);
+  cancel(jobs.communities);
+  cancel(jobs.influencers);
+  cancel(jobs.brokers);
+}
+
+template <typename T>
+bool jobDone(const string &label, shared_ptr<AnalyticsJob<T>> &job,
+             chrono::steady_clock::time_point deadline)
+{
+  if (job->future().wait_until(deadline) != future_status::ready)
+  {
+    cout << label << ": computing (" << static_cast<int>(job->progress())
+         << "%), choose 13 again later" << endl;
+    return false;
+  }
+  try
+  {
+    job->get();
+    return true;
+  }
+  catch (const JobCancelled &)
+  {
+    cout << label << ": cancelled, choose 13 again to restart" << endl;
+    job = nullptr;
+    return false;
+  }
+}
+
+RankedUsers topUsers(const FlatGraph &graph, const vector<double> &scores,
+                     size_t k)
+{
+  vector<FlatGraph::Vertex> order(scores.size());
+  iota(order.begin(), order.end(), 0);
+  k = min(k, order.size());
+  partial_sort(order.begin(), order.begin() + k, order.end(),
+               [&scores](FlatGraph::Vertex a, FlatGraph::Vertex b) {
+                 return scores[a] != scores[b] ? scores[a] > scores[b]
+                                               : a < b;
+               });
+  RankedUsers result;
+  for (size_t i = 0; i < k; ++i)
+  {
+    result.emplace_back(string(graph.nameOf(order[i])), scores[order[i]]);
+  }
+  return result;
+}
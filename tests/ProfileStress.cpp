@@ -0,0 +1,190 @@
+/******************************************************************************
+    Stress test of a thread-safe Graph: writer threads rename users, change
+    their emails and add and remove connections while reader threads run
+    queries, copy every profile and walk snapshots. At the end every index
+    must agree with the profiles.
+
+    Build it next to the application, best with ThreadSanitizer:
+      g++ -std=c++17 -O1 -g -fsanitize=thread -I. tests/ProfileStress.cpp \
+          $(ls *.cpp | grep -v main.cpp) -pthread -o profile_stress
+    Exits with status 1 (after reporting) if a check fails.
+ * ****************************************************************************
+ * */
+
+#include "Connection.h"
+#include "Graph.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+const int USERS = 400;
+const int WRITERS = 3;
+const int READERS = 3;
+const chrono::seconds DURATION(3);
+
+atomic<int> failures(0);
+
+// Report a failed check
+void check(bool condition, const string &message)
+{
+  if (!condition)
+  {
+    cerr << "FAILED: " << message << endl;
+    ++failures;
+  }
+}
+
+string nameOf(int user, int generation)
+{
+  return "user" + to_string(user) + "_" + to_string(generation);
+}
+
+// Each writer owns the users with index % WRITERS == writer, so their
+// current names are known without asking the graph
+void writer(Graph &graph, int id, vector<int> &generations)
+{
+  mt19937 random(id);
+  auto end = chrono::steady_clock::now() + DURATION;
+  while (chrono::steady_clock::now() < end)
+  {
+    int user = static_cast<int>(random() % (USERS / WRITERS)) * WRITERS + id;
+    string current = nameOf(user, generations[user]);
+    switch (random() % 4)
+    {
+    case 0:
+    {
+      // Rename through the setter of the profile
+      UserProfile *profile = graph.searchUser(current);
+      check(profile != nullptr, "own user " + current + " not found");
+      if (profile != nullptr)
+      {
+        ++generations[user];
+        profile->setUserName(nameOf(user, generations[user]));
+      }
+      break;
+    }
+    case 1:
+    {
+      string email = nameOf(user, generations[user] + 1) + "@example.com";
+      check(graph.updateProfile(current, current, "First", "Last", email),
+            "updateProfile of " + current + " failed");
+      break;
+    }
+    case 2:
+    {
+      // Only this writer knows the current names of its users
+      int other =
+          static_cast<int>(random() % (USERS / WRITERS)) * WRITERS + id;
+      UserProfile *source = graph.searchUser(current);
+      UserProfile *destination =
+          graph.searchUser(nameOf(other, generations[other]));
+      if (source != nullptr && destination != nullptr &&
+          source != destination)
+      {
+        Connection *connection = new Connection(source, destination, 1);
+        if (!graph.addConnection(connection))
+        {
+          delete connection;
+        }
+      }
+      break;
+    }
+    default:
+    {
+      vector<string> friends = graph.getConnectedUsers(current);
+      if (!friends.empty())
+      {
+        graph.removeConnection(current, friends[random() % friends.size()]);
+      }
+      break;
+    }
+    }
+  }
+}
+
+// Read-only queries that touch the profile text and the indexes
+void reader(Graph &graph, int id)
+{
+  mt19937 random(100 + id);
+  auto end = chrono::steady_clock::now() + DURATION;
+  while (chrono::steady_clock::now() < end)
+  {
+    UserStore store = graph.buildUserStore();
+    check(store.size() == USERS, "user count changed");
+    for (UserStore::Row row = 0; row < store.rowCount(); row += 37)
+    {
+      check(store.getUserName(row).rfind("user", 0) == 0,
+            "torn username " + string(store.getUserName(row)));
+    }
+    graph.suggestUsers("user1", 5);
+    graph.searchUsersByNamePrefix("First", 5);
+    GraphSnapshot snapshot = graph.snapshot();
+    check(snapshot->userCount() == USERS, "snapshot user count changed");
+    graph.componentOf(nameOf(static_cast<int>(random() % USERS), 0));
+    graph.getNumOfConnections();
+  }
+}
+} // namespace
+
+int main()
+{
+  Graph graph(true);
+  for (int user = 0; user < USERS; ++user)
+  {
+    graph.addUser(new UserProfile(nameOf(user, 0), "First", "Last",
+                                  nameOf(user, 0) + "@example.com"));
+  }
+
+  vector<int> generations(USERS, 0);
+  vector<thread> threads;
+  for (int id = 0; id < WRITERS; ++id)
+  {
+    threads.emplace_back(writer, ref(graph), id, ref(generations));
+  }
+  for (int id = 0; id < READERS; ++id)
+  {
+    threads.emplace_back(reader, ref(graph), id);
+  }
+  for (thread &worker : threads)
+  {
+    worker.join();
+  }
+
+  // Every user is found under its final name and email
+  check(graph.getNumOfUsers() == USERS, "final user count");
+  size_t listed = 0;
+  for (int user = 0; user < USERS; ++user)
+  {
+    string name = nameOf(user, generations[user]);
+    UserProfile *profile = graph.searchUser(name);
+    check(profile != nullptr, name + " missing");
+    if (profile == nullptr)
+    {
+      continue;
+    }
+    check(profile->getUserName() == name, name + " key and name differ");
+    check(graph.searchUserByEmail(profile->getEmail()) == profile,
+          name + " email index is stale");
+    check(graph.snapshot()->find(name) != nullptr,
+          name + " missing from the snapshot");
+    listed += graph.getConnectedUsers(name).size();
+  }
+  check(listed == 2 * static_cast<size_t>(graph.getNumOfConnections()),
+        "connection counter differs from the adjacency");
+
+  if (failures > 0)
+  {
+    cerr << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "Profile stress test passed" << endl;
+  return 0;
+}